@@ -0,0 +1,68 @@
+//! Render benchmarks on the headless display
+//!
+//! ```text
+//! cargo bench --features simulator --bench render
+//! LVGL_BENCH_SIZE=480x320 LVGL_BENCH_FRAMES=300 cargo bench --features simulator --bench render
+//! ```
+//!
+//! Prints one row per scene and render mode, see `lvgl::bench`. Peak heap is
+//! read from glibc's allocator statistics, which cover both Rust and LVGL
+//! (`LV_STDLIB_CLIB`) allocations; other platforms report `-`.
+
+use std::sync::OnceLock;
+use std::time::Instant;
+
+use lvgl::bench::{self, BenchConfig};
+
+fn now_us() -> u64 {
+    static START: OnceLock<Instant> = OnceLock::new();
+    START.get_or_init(Instant::now).elapsed().as_micros() as u64
+}
+
+#[cfg(all(target_os = "linux", target_env = "gnu"))]
+fn heap_used() -> usize {
+    #[repr(C)]
+    struct Mallinfo2 {
+        arena: usize,
+        ordblks: usize,
+        smblks: usize,
+        hblks: usize,
+        hblkhd: usize,
+        usmblks: usize,
+        fsmblks: usize,
+        uordblks: usize,
+        fordblks: usize,
+        keepcost: usize,
+    }
+    extern "C" {
+        fn mallinfo2() -> Mallinfo2;
+    }
+    // Bytes in use in the heap, plus chunks allocated with mmap
+    let info = unsafe { mallinfo2() };
+    info.uordblks + info.hblkhd
+}
+
+fn env_or(name: &str, default: &str) -> String {
+    std::env::var(name).unwrap_or_else(|_| default.to_string())
+}
+
+fn main() -> Result<(), Box<dyn std::error::Error>> {
+    let size = env_or("LVGL_BENCH_SIZE", "320x240");
+    let (width, height) = size
+        .split_once('x')
+        .and_then(|(w, h)| Some((w.parse().ok()?, h.parse().ok()?)))
+        .ok_or("LVGL_BENCH_SIZE must look like 320x240")?;
+
+    let mut config = BenchConfig::new(width, height, now_us);
+    config.frames = env_or("LVGL_BENCH_FRAMES", "120").parse()?;
+    #[cfg(all(target_os = "linux", target_env = "gnu"))]
+    {
+        config.heap_used = Some(heap_used);
+    }
+
+    lvgl::init()?;
+    println!("{}x{}, {} frames per scene", width, height, config.frames);
+    println!("{}", bench::HEADER);
+    bench::run(&config, |result| println!("{}", result))?;
+    Ok(())
+}
@@ -0,0 +1,57 @@
+//! Asset pack in a memory-mapped flash partition
+//!
+//! The `assets` data partition (see `partitions.csv`) holds an
+//! `lvgl::assets` pack. It is mapped into the data address space once and
+//! never unmapped, so images and fonts are read straight from flash through
+//! the cache. Flash a new pack without touching the app:
+//!
+//! ```text
+//! parttool.py write_partition --partition-name assets --input assets.bin
+//! ```
+
+use core::ffi::c_void;
+use core::ptr;
+
+use esp_idf_hal::sys::{self, esp, EspError};
+use lvgl::assets::AssetPack;
+
+/// Partition label in `partitions.csv`
+pub const PARTITION_LABEL: &core::ffi::CStr = c"assets";
+
+/// Map the asset partition and open the pack in it
+///
+/// Returns `Ok(None)` when the partition is missing or holds no valid pack.
+pub fn open() -> Result<Option<&'static AssetPack>, EspError> {
+    let data = match map_partition(PARTITION_LABEL)? {
+        Some(data) => data,
+        None => return Ok(None),
+    };
+    Ok(AssetPack::from_static(data).ok().map(AssetPack::leak))
+}
+
+/// Map a whole data partition for the rest of the program
+fn map_partition(label: &core::ffi::CStr) -> Result<Option<&'static [u8]>, EspError> {
+    unsafe {
+        let part = sys::esp_partition_find_first(
+            sys::esp_partition_type_t_ESP_PARTITION_TYPE_DATA,
+            sys::esp_partition_subtype_t_ESP_PARTITION_SUBTYPE_ANY,
+            label.as_ptr(),
+        );
+        if part.is_null() {
+            return Ok(None);
+        }
+        let size = (*part).size as usize;
+        let mut data: *const c_void = ptr::null();
+        let mut handle: sys::esp_partition_mmap_handle_t = 0;
+        esp!(sys::esp_partition_mmap(
+            part,
+            0,
+            size,
+            sys::esp_partition_mmap_memory_t_ESP_PARTITION_MMAP_DATA,
+            &mut data,
+            &mut handle,
+        ))?;
+        // The handle is dropped on purpose: the mapping stays for good
+        Ok(Some(core::slice::from_raw_parts(data as *const u8, size)))
+    }
+}
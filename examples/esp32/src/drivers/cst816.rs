@@ -4,11 +4,15 @@
 //! - LILYGO T-Display-S3
 //! - Many ESP32 display modules
 //!
-//! Uses I2C interface.
+//! Uses I2C interface. The INT line pulses on every touch report and state
+//! change, so with [`Cst816::subscribe`] the bus is only read when there is
+//! new data.
 
 use esp_idf_hal::delay::Ets;
-use esp_idf_hal::gpio::{Input, InputPin, Output, OutputPin, PinDriver};
+use esp_idf_hal::gpio::{Input, InputPin, InterruptType, Output, OutputPin, PinDriver};
 use esp_idf_hal::i2c::I2cDriver;
+use esp_idf_hal::sys::{EspError, ESP_ERR_INVALID_STATE};
+use lvgl::display::TouchTransform;
 
 /// CST816 I2C address
 const CST816_ADDR: u8 = 0x15;
@@ -59,6 +63,23 @@ pub enum Gesture {
     LongPress = 0x0C,
 }
 
+impl Gesture {
+    /// Map to the LVGL-side gesture (`None` for [`Gesture::None`])
+    pub fn to_lvgl(self) -> Option<lvgl::input::Gesture> {
+        use lvgl::input::Gesture as G;
+        match self {
+            Gesture::None => None,
+            Gesture::SwipeUp => Some(G::SwipeUp),
+            Gesture::SwipeDown => Some(G::SwipeDown),
+            Gesture::SwipeLeft => Some(G::SwipeLeft),
+            Gesture::SwipeRight => Some(G::SwipeRight),
+            Gesture::SingleClick => Some(G::Tap),
+            Gesture::DoubleClick => Some(G::DoubleTap),
+            Gesture::LongPress => Some(G::LongPress),
+        }
+    }
+}
+
 impl From<u8> for Gesture {
     fn from(value: u8) -> Self {
         match value {
@@ -140,6 +161,12 @@ where
         }
     }
 
+    /// Update the coordinate range, e.g. after rotating the display
+    pub fn set_size(&mut self, width: u16, height: u16) {
+        self.width = width;
+        self.height = height;
+    }
+
     /// Configure coordinate transformation
     pub fn set_transform(&mut self, swap_xy: bool, invert_x: bool, invert_y: bool) {
         self.swap_xy = swap_xy;
@@ -147,6 +174,12 @@ where
         self.invert_y = invert_y;
     }
 
+    /// Apply the touch mapping returned by `Display::rotate_with`
+    pub fn apply_transform(&mut self, transform: &TouchTransform) {
+        self.set_size(transform.width as u16, transform.height as u16);
+        self.set_transform(transform.swap_xy, transform.invert_x, transform.invert_y);
+    }
+
     /// Initialize the touch controller
     pub fn init(&mut self) -> Result<(), esp_idf_hal::sys::EspError> {
         // Hardware reset if we have a reset pin
@@ -164,8 +197,9 @@ where
         // Disable auto sleep (keep touch active)
         self.write_reg(reg::DIS_AUTO_SLEEP, 0x01)?;
 
-        // Configure IRQ mode (trigger on touch)
-        self.write_reg(reg::IRQ_CTL, 0x41)?;
+        // Pulse INT while touched (EnTouch) and on press/release (EnChange),
+        // plus once on long press
+        self.write_reg(reg::IRQ_CTL, 0x61)?;
 
         Ok(())
     }
@@ -218,6 +252,37 @@ where
         })
     }
 
+    /// Call `callback` from the GPIO ISR when INT goes low
+    ///
+    /// The interrupt disarms itself after firing; call
+    /// [`enable_interrupt`](Self::enable_interrupt) after each read. Do the
+    /// I2C read in a task, not in `callback`.
+    ///
+    /// Level-triggered so the same pin can wake the chip from light sleep.
+    ///
+    /// # Safety
+    /// `callback` runs in interrupt context and must be ISR-safe.
+    pub unsafe fn subscribe(
+        &mut self,
+        callback: impl FnMut() + Send + 'static,
+    ) -> Result<(), EspError> {
+        let int = self
+            .int
+            .as_mut()
+            .ok_or(EspError::from_infallible::<ESP_ERR_INVALID_STATE>())?;
+        int.set_interrupt_type(InterruptType::LowLevel)?;
+        int.subscribe(callback)?;
+        int.enable_interrupt()
+    }
+
+    /// Re-arm the INT interrupt after handling a pulse
+    pub fn enable_interrupt(&mut self) -> Result<(), EspError> {
+        match self.int {
+            Some(ref mut int) => int.enable_interrupt(),
+            None => Ok(()),
+        }
+    }
+
     /// Check if touch interrupt is active (if INT pin is connected)
     pub fn is_touched(&self) -> bool {
         if let Some(ref int) = self.int {
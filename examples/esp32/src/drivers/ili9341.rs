@@ -5,7 +5,9 @@
 
 use esp_idf_hal::delay::Ets;
 use esp_idf_hal::gpio::{OutputPin, PinDriver};
-use esp_idf_hal::spi::{SpiDeviceDriver, SpiDriver};
+use lvgl::display::FlushReady;
+
+use super::spi_panel::SpiPanelBus;
 
 /// ILI9341 Commands
 mod cmd {
@@ -26,8 +28,7 @@ where
     RST: OutputPin,
     BL: OutputPin,
 {
-    spi: SpiDeviceDriver<'a, &'a SpiDriver<'a>>,
-    dc: PinDriver<'a, DC, esp_idf_hal::gpio::Output>,
+    bus: SpiPanelBus<'a, DC>,
     rst: PinDriver<'a, RST, esp_idf_hal::gpio::Output>,
     bl: PinDriver<'a, BL, esp_idf_hal::gpio::Output>,
     width: u16,
@@ -43,23 +44,20 @@ where
     /// Create a new ILI9341 driver
     ///
     /// # Arguments
-    /// * `spi` - SPI device driver
-    /// * `dc` - Data/Command pin
+    /// * `bus` - SPI panel bus (owns chip select and Data/Command pins)
     /// * `rst` - Reset pin
     /// * `bl` - Backlight pin
     /// * `width` - Display width
     /// * `height` - Display height
     pub fn new(
-        spi: SpiDeviceDriver<'a, &'a SpiDriver<'a>>,
-        dc: PinDriver<'a, DC, esp_idf_hal::gpio::Output>,
+        bus: SpiPanelBus<'a, DC>,
         rst: PinDriver<'a, RST, esp_idf_hal::gpio::Output>,
         bl: PinDriver<'a, BL, esp_idf_hal::gpio::Output>,
         width: u16,
         height: u16,
     ) -> Self {
         Self {
-            spi,
-            dc,
+            bus,
             rst,
             bl,
             width,
@@ -76,24 +74,22 @@ where
         Ets::delay_ms(120);
 
         // Software reset
-        self.write_command(cmd::SWRESET)?;
-        Ets::delay_ms(120);
+        self.write_command(cmd::SWRESET, &[])?;
+        self.delay_ms(120)?;
 
         // Sleep out
-        self.write_command(cmd::SLPOUT)?;
-        Ets::delay_ms(120);
+        self.write_command(cmd::SLPOUT, &[])?;
+        self.delay_ms(120)?;
 
         // Pixel format: 16-bit RGB565
-        self.write_command(cmd::COLMOD)?;
-        self.write_data(&[0x55])?;
+        self.write_command(cmd::COLMOD, &[0x55])?;
 
         // Memory access control (rotation)
-        self.write_command(cmd::MADCTL)?;
-        self.write_data(&[0x48])?; // RGB order, landscape
+        self.write_command(cmd::MADCTL, &[0x48])?; // RGB order, landscape
 
         // Display on
-        self.write_command(cmd::DISPON)?;
-        Ets::delay_ms(50);
+        self.write_command(cmd::DISPON, &[])?;
+        self.delay_ms(50)?;
 
         // Backlight on
         self.bl.set_high()?;
@@ -110,34 +106,36 @@ where
         y1: u16,
     ) -> Result<(), esp_idf_hal::sys::EspError> {
         // Column address set
-        self.write_command(cmd::CASET)?;
-        self.write_data(&[
-            (x0 >> 8) as u8,
-            (x0 & 0xFF) as u8,
-            (x1 >> 8) as u8,
-            (x1 & 0xFF) as u8,
-        ])?;
+        self.write_command(
+            cmd::CASET,
+            &[
+                (x0 >> 8) as u8,
+                (x0 & 0xFF) as u8,
+                (x1 >> 8) as u8,
+                (x1 & 0xFF) as u8,
+            ],
+        )?;
 
         // Page address set
-        self.write_command(cmd::PASET)?;
-        self.write_data(&[
-            (y0 >> 8) as u8,
-            (y0 & 0xFF) as u8,
-            (y1 >> 8) as u8,
-            (y1 & 0xFF) as u8,
-        ])?;
+        self.write_command(
+            cmd::PASET,
+            &[
+                (y0 >> 8) as u8,
+                (y0 & 0xFF) as u8,
+                (y1 >> 8) as u8,
+                (y1 & 0xFF) as u8,
+            ],
+        )?;
 
         // Memory write
-        self.write_command(cmd::RAMWR)?;
+        self.write_command(cmd::RAMWR, &[])?;
 
         Ok(())
     }
 
     /// Write pixel data to the display
     pub fn write_pixels(&mut self, data: &[u8]) -> Result<(), esp_idf_hal::sys::EspError> {
-        self.dc.set_high()?;
-        self.spi.write(data)?;
-        Ok(())
+        self.bus.write_pixels(data)
     }
 
     /// Flush a region to the display (for LVGL)
@@ -154,17 +152,60 @@ where
         Ok(())
     }
 
-    /// Write a command byte
-    fn write_command(&mut self, cmd: u8) -> Result<(), esp_idf_hal::sys::EspError> {
-        self.dc.set_low()?;
-        self.spi.write(&[cmd])?;
-        Ok(())
+    /// Start flushing a region without waiting (for LVGL)
+    ///
+    /// `done` is signalled from the SPI ISR when the transfer has finished.
+    ///
+    /// # Safety
+    /// `data` must stay valid until `done` is signalled.
+    pub unsafe fn flush_async(
+        &mut self,
+        x1: i32,
+        y1: i32,
+        x2: i32,
+        y2: i32,
+        data: &[u8],
+        done: FlushReady,
+    ) -> Result<(), esp_idf_hal::sys::EspError> {
+        self.set_window(x1 as u16, y1 as u16, x2 as u16, y2 as u16)?;
+        self.bus.queue_pixels(data, Some(done))
+    }
+
+    /// Wait for pending transfers and release the SPI bus
+    ///
+    /// Call before the UI thread goes idle so the chip can enter light sleep.
+    pub fn release_bus(&mut self) -> Result<(), esp_idf_hal::sys::EspError> {
+        self.bus.release()
+    }
+
+    /// Clear the screen with a color
+    pub fn clear(&mut self, color: u16) -> Result<(), esp_idf_hal::sys::EspError> {
+        self.fill_rect(0, 0, self.width, self.height, color)
+    }
+
+    /// Fill a rectangle with a color
+    pub fn fill_rect(
+        &mut self,
+        x: u16,
+        y: u16,
+        width: u16,
+        height: u16,
+        color: u16,
+    ) -> Result<(), esp_idf_hal::sys::EspError> {
+        self.set_window(x, y, x + width - 1, y + height - 1)?;
+        self.bus
+            .fill(color.to_be_bytes(), width as usize * height as usize)
+    }
+
+    /// Write a command byte followed by its parameters
+    fn write_command(&mut self, cmd: u8, params: &[u8]) -> Result<(), esp_idf_hal::sys::EspError> {
+        self.bus.command(cmd, params)
     }
 
-    /// Write data bytes
-    fn write_data(&mut self, data: &[u8]) -> Result<(), esp_idf_hal::sys::EspError> {
-        self.dc.set_high()?;
-        self.spi.write(data)?;
+    /// Wait for queued commands to go out, then delay
+    fn delay_ms(&mut self, ms: u32) -> Result<(), esp_idf_hal::sys::EspError> {
+        self.bus.wait_idle()?;
+        Ets::delay_ms(ms);
         Ok(())
     }
 }
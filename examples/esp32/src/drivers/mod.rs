@@ -4,4 +4,5 @@
 
 pub mod cst816;
 pub mod ili9341;
+pub mod spi_panel;
 pub mod st7789;
@@ -0,0 +1,297 @@
+//! Queued SPI transport for MIPI-DBI panels (ST7789, ILI9341)
+//!
+//! Talks to the ESP-IDF SPI master driver directly so transfers can be queued
+//! to DMA instead of blocking on each chunk. The D/C line is driven from the
+//! pre-transfer callback, and pixel transfers can signal LVGL's flush
+//! completion from the post-transfer callback (SPI ISR).
+//!
+//! The bus stays acquired while the panel is busy, so queued transactions
+//! skip the per-transaction bus lock, and chip select is held low across a
+//! command and its parameters. [`SpiPanelBus::release`] hands it back when
+//! the UI goes idle; the bus holds a power-management lock while acquired,
+//! which would keep the chip out of light sleep.
+
+use core::ffi::c_void;
+use core::ptr;
+
+use esp_idf_hal::delay::BLOCK;
+use esp_idf_hal::gpio::{Output, OutputPin, PinDriver};
+use esp_idf_hal::peripheral::Peripheral;
+use esp_idf_hal::spi::SpiDriver;
+use esp_idf_hal::sys::{self, esp, EspError};
+use lvgl::display::FlushReady;
+
+/// Largest single DMA transfer; pass this to `DriverConfig::dma(Dma::Auto(..))`
+pub const MAX_TRANSFER_SIZE: usize = 16 * 1024;
+
+/// Number of transactions that can be queued at once
+const QUEUE_DEPTH: usize = 8;
+
+/// Transaction plus the state its ISR callbacks need
+#[repr(C)]
+struct Slot {
+    trans: sys::spi_transaction_t,
+    dc_gpio: i32,
+    dc_level: u32,
+    done: Option<FlushReady>,
+}
+
+/// Runs in the SPI ISR before a transaction starts
+unsafe extern "C" fn pre_transfer(trans: *mut sys::spi_transaction_t) {
+    let slot = &*((*trans).user as *const Slot);
+    sys::gpio_set_level(slot.dc_gpio, slot.dc_level);
+}
+
+/// Runs in the SPI ISR after a transaction finished
+unsafe extern "C" fn post_transfer(trans: *mut sys::spi_transaction_t) {
+    let slot = &*((*trans).user as *const Slot);
+    if let Some(done) = slot.done {
+        done.signal();
+    }
+}
+
+/// SPI panel bus with queued DMA transfers
+pub struct SpiPanelBus<'d, DC>
+where
+    DC: OutputPin,
+{
+    handle: sys::spi_device_handle_t,
+    dc: PinDriver<'d, DC, Output>,
+    slots: Box<[Slot; QUEUE_DEPTH]>,
+    next: usize,
+    in_flight: usize,
+    acquired: bool,
+    _bus: &'d SpiDriver<'d>,
+}
+
+impl<'d, DC> SpiPanelBus<'d, DC>
+where
+    DC: OutputPin,
+{
+    /// Add a panel device to an SPI bus
+    ///
+    /// # Arguments
+    /// * `bus` - SPI bus driver, created with DMA enabled
+    /// * `cs` - Chip select pin
+    /// * `dc` - Data/Command pin
+    /// * `baudrate_hz` - SPI clock in Hz
+    pub fn new(
+        bus: &'d SpiDriver<'d>,
+        cs: impl Peripheral<P = impl OutputPin> + 'd,
+        dc: PinDriver<'d, DC, Output>,
+        baudrate_hz: u32,
+    ) -> Result<Self, EspError> {
+        let cs = cs.into_ref();
+
+        let dev_config = sys::spi_device_interface_config_t {
+            mode: 0,
+            clock_speed_hz: baudrate_hz as i32,
+            spics_io_num: cs.pin(),
+            queue_size: QUEUE_DEPTH as i32,
+            flags: sys::SPI_DEVICE_HALFDUPLEX,
+            pre_cb: Some(pre_transfer),
+            post_cb: Some(post_transfer),
+            ..Default::default()
+        };
+
+        let mut handle: sys::spi_device_handle_t = ptr::null_mut();
+        esp!(unsafe { sys::spi_bus_add_device(bus.host(), &dev_config, &mut handle) })?;
+
+        let dc_gpio = dc.pin();
+        let slots = Box::new(core::array::from_fn(|_| Slot {
+            trans: Default::default(),
+            dc_gpio,
+            dc_level: 0,
+            done: None,
+        }));
+
+        Ok(Self {
+            handle,
+            dc,
+            slots,
+            next: 0,
+            in_flight: 0,
+            acquired: false,
+            _bus: bus,
+        })
+    }
+
+    /// Queue a command byte with optional parameters
+    ///
+    /// Parameters of up to 4 bytes are copied into the transaction and do not
+    /// block; longer parameter blocks wait until they have been sent.
+    pub fn command(&mut self, cmd: u8, params: &[u8]) -> Result<(), EspError> {
+        // Hold CS low between the command byte and its parameters
+        self.queue_inline(0, &[cmd], !params.is_empty())?;
+        if params.len() <= 4 {
+            if !params.is_empty() {
+                self.queue_inline(1, params, false)?;
+            }
+        } else {
+            unsafe { self.queue(1, params, false, None)? };
+            self.wait_idle()?;
+        }
+        Ok(())
+    }
+
+    /// Send `count` copies of one RGB565 pixel and wait until done
+    ///
+    /// A single line buffer is filled once and queued repeatedly, so only one
+    /// wait is needed for the whole fill.
+    pub fn fill(&mut self, pixel: [u8; 2], count: usize) -> Result<(), EspError> {
+        const FILL_CHUNK: usize = 4096;
+
+        let total = count * 2;
+        let mut line = vec![0u8; total.min(FILL_CHUNK)];
+        for px in line.chunks_exact_mut(2) {
+            px.copy_from_slice(&pixel);
+        }
+
+        let mut remaining = total;
+        while remaining > 0 {
+            let len = remaining.min(line.len());
+            remaining -= len;
+            // `line` outlives the transfers thanks to wait_idle() below
+            unsafe { self.queue(1, &line[..len], remaining > 0, None)? };
+        }
+        self.wait_idle()
+    }
+
+    /// Send pixel data and wait until the transfer has finished
+    pub fn write_pixels(&mut self, data: &[u8]) -> Result<(), EspError> {
+        unsafe { self.queue_pixels(data, None)? };
+        self.wait_idle()
+    }
+
+    /// Queue pixel data without waiting
+    ///
+    /// `done` is signalled from the SPI ISR once the last chunk has been sent.
+    ///
+    /// # Safety
+    /// `data` must stay valid and unmodified until the transfer completes.
+    pub unsafe fn queue_pixels(
+        &mut self,
+        data: &[u8],
+        done: Option<FlushReady>,
+    ) -> Result<(), EspError> {
+        if data.is_empty() {
+            if let Some(done) = done {
+                done.signal();
+            }
+            return Ok(());
+        }
+
+        let last = (data.len() - 1) / MAX_TRANSFER_SIZE;
+        for (i, chunk) in data.chunks(MAX_TRANSFER_SIZE).enumerate() {
+            if i == last {
+                self.queue(1, chunk, false, done)?;
+            } else {
+                self.queue(1, chunk, true, None)?;
+            }
+        }
+        Ok(())
+    }
+
+    /// Wait until every queued transaction has completed
+    pub fn wait_idle(&mut self) -> Result<(), EspError> {
+        while self.in_flight > 0 {
+            self.reap_one()?;
+        }
+        Ok(())
+    }
+
+    /// Finish all transfers and release the bus until the next one
+    ///
+    /// Call before the UI thread sleeps so light sleep is possible.
+    pub fn release(&mut self) -> Result<(), EspError> {
+        self.wait_idle()?;
+        if self.acquired {
+            unsafe { sys::spi_device_release_bus(self.handle) };
+            self.acquired = false;
+        }
+        Ok(())
+    }
+
+    /// Take the next free slot, reaping the oldest transaction if all are busy
+    ///
+    /// With `keep_cs`, chip select stays asserted after the transaction.
+    fn next_slot(
+        &mut self,
+        dc_level: u32,
+        keep_cs: bool,
+        done: Option<FlushReady>,
+    ) -> Result<usize, EspError> {
+        if self.in_flight == QUEUE_DEPTH {
+            self.reap_one()?;
+        }
+
+        let idx = self.next;
+        self.next = (self.next + 1) % QUEUE_DEPTH;
+
+        let slot = &mut self.slots[idx];
+        slot.trans = Default::default();
+        slot.trans.user = slot as *mut Slot as *mut c_void;
+        if keep_cs {
+            slot.trans.flags = sys::SPI_TRANS_CS_KEEP_ACTIVE;
+        }
+        slot.dc_level = dc_level;
+        slot.done = done;
+        Ok(idx)
+    }
+
+    /// Queue up to 4 bytes stored inside the transaction itself
+    fn queue_inline(&mut self, dc_level: u32, data: &[u8], keep_cs: bool) -> Result<(), EspError> {
+        let idx = self.next_slot(dc_level, keep_cs, None)?;
+        let slot = &mut self.slots[idx];
+        slot.trans.flags |= sys::SPI_TRANS_USE_TXDATA;
+        slot.trans.length = data.len() * 8;
+        unsafe {
+            slot.trans.__bindgen_anon_1.tx_data[..data.len()].copy_from_slice(data);
+        }
+        self.submit(idx)
+    }
+
+    /// Queue a transfer that reads directly from `data`
+    unsafe fn queue(
+        &mut self,
+        dc_level: u32,
+        data: &[u8],
+        keep_cs: bool,
+        done: Option<FlushReady>,
+    ) -> Result<(), EspError> {
+        let idx = self.next_slot(dc_level, keep_cs, done)?;
+        let slot = &mut self.slots[idx];
+        slot.trans.length = data.len() * 8;
+        slot.trans.__bindgen_anon_1.tx_buffer = data.as_ptr() as *const c_void;
+        self.submit(idx)
+    }
+
+    fn submit(&mut self, idx: usize) -> Result<(), EspError> {
+        // The panel is the only device on this bus; keep it until release()
+        if !self.acquired {
+            esp!(unsafe { sys::spi_device_acquire_bus(self.handle, BLOCK) })?;
+            self.acquired = true;
+        }
+        esp!(unsafe { sys::spi_device_queue_trans(self.handle, &mut self.slots[idx].trans, BLOCK) })?;
+        self.in_flight += 1;
+        Ok(())
+    }
+
+    fn reap_one(&mut self) -> Result<(), EspError> {
+        let mut done: *mut sys::spi_transaction_t = ptr::null_mut();
+        esp!(unsafe { sys::spi_device_get_trans_result(self.handle, &mut done, BLOCK) })?;
+        self.in_flight -= 1;
+        Ok(())
+    }
+}
+
+impl<'d, DC> Drop for SpiPanelBus<'d, DC>
+where
+    DC: OutputPin,
+{
+    fn drop(&mut self) {
+        let _ = self.release();
+        let _ = self.dc.set_low();
+        unsafe { sys::spi_bus_remove_device(self.handle) };
+    }
+}
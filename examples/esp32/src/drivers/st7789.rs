@@ -8,7 +8,9 @@
 
 use esp_idf_hal::delay::Ets;
 use esp_idf_hal::gpio::{Output, OutputPin, PinDriver};
-use esp_idf_hal::spi::{SpiDeviceDriver, SpiDriver};
+use lvgl::display::{Area, DisplayRotation, FlushReady, FlushSink, PanelRotation};
+
+use super::spi_panel::SpiPanelBus;
 
 /// ST7789 Commands
 #[allow(dead_code)]
@@ -66,7 +68,7 @@ mod madctl {
 }
 
 /// Display orientation
-#[derive(Clone, Copy, Debug)]
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
 pub enum Orientation {
     /// Portrait (connector at bottom)
     Portrait,
@@ -79,6 +81,20 @@ pub enum Orientation {
 }
 
 impl Orientation {
+    /// Turned clockwise by `quarter_turns`, like LVGL's display rotation
+    pub fn rotated(self, quarter_turns: u8) -> Orientation {
+        // With each clockwise turn the connector moves from the bottom to
+        // the left, top and right
+        const CLOCKWISE: [Orientation; 4] = [
+            Orientation::Portrait,
+            Orientation::LandscapeInverted,
+            Orientation::PortraitInverted,
+            Orientation::Landscape,
+        ];
+        let index = CLOCKWISE.iter().position(|&o| o == self).unwrap_or(0);
+        CLOCKWISE[(index + quarter_turns as usize) % 4]
+    }
+
     fn madctl_value(&self) -> u8 {
         match self {
             Orientation::Portrait => madctl::MX | madctl::BGR,
@@ -190,10 +206,11 @@ where
     DC: OutputPin,
     RST: OutputPin,
 {
-    spi: SpiDeviceDriver<'a, &'a SpiDriver<'a>>,
-    dc: PinDriver<'a, DC, Output>,
+    bus: SpiPanelBus<'a, DC>,
     rst: Option<PinDriver<'a, RST, Output>>,
     config: St7789Config,
+    /// Orientation from the config, which rotations are counted from
+    native_orientation: Orientation,
 }
 
 impl<'a, DC, RST> St7789<'a, DC, RST>
@@ -204,20 +221,18 @@ where
     /// Create a new ST7789 driver
     ///
     /// # Arguments
-    /// * `spi` - SPI device driver
-    /// * `dc` - Data/Command pin
+    /// * `bus` - SPI panel bus (owns chip select and Data/Command pins)
     /// * `rst` - Reset pin (optional, use None if tied to EN)
     /// * `config` - Display configuration
     pub fn new(
-        spi: SpiDeviceDriver<'a, &'a SpiDriver<'a>>,
-        dc: PinDriver<'a, DC, Output>,
+        bus: SpiPanelBus<'a, DC>,
         rst: Option<PinDriver<'a, RST, Output>>,
         config: St7789Config,
     ) -> Self {
         Self {
-            spi,
-            dc,
+            bus,
             rst,
+            native_orientation: config.orientation,
             config,
         }
     }
@@ -235,37 +250,35 @@ where
         }
 
         // Software reset
-        self.write_command(cmd::SWRESET)?;
-        Ets::delay_ms(150);
+        self.write_command(cmd::SWRESET, &[])?;
+        self.delay_ms(150)?;
 
         // Sleep out
-        self.write_command(cmd::SLPOUT)?;
-        Ets::delay_ms(50);
+        self.write_command(cmd::SLPOUT, &[])?;
+        self.delay_ms(50)?;
 
         // Pixel format: 16-bit RGB565
-        self.write_command(cmd::COLMOD)?;
-        self.write_data(&[0x55])?; // 16-bit color
-        Ets::delay_ms(10);
+        self.write_command(cmd::COLMOD, &[0x55])?; // 16-bit color
+        self.delay_ms(10)?;
 
         // Memory access control (orientation)
-        self.write_command(cmd::MADCTL)?;
-        self.write_data(&[self.config.orientation.madctl_value()])?;
+        self.write_command(cmd::MADCTL, &[self.config.orientation.madctl_value()])?;
 
         // Inversion (most ST7789 displays need this)
         if self.config.invert_colors {
-            self.write_command(cmd::INVON)?;
+            self.write_command(cmd::INVON, &[])?;
         } else {
-            self.write_command(cmd::INVOFF)?;
+            self.write_command(cmd::INVOFF, &[])?;
         }
-        Ets::delay_ms(10);
+        self.delay_ms(10)?;
 
         // Normal display mode
-        self.write_command(cmd::NORON)?;
-        Ets::delay_ms(10);
+        self.write_command(cmd::NORON, &[])?;
+        self.delay_ms(10)?;
 
         // Display on
-        self.write_command(cmd::DISPON)?;
-        Ets::delay_ms(50);
+        self.write_command(cmd::DISPON, &[])?;
+        self.delay_ms(50)?;
 
         // Clear screen to black
         self.clear(0x0000)?;
@@ -310,40 +323,36 @@ where
         };
 
         // Column address set
-        self.write_command(cmd::CASET)?;
-        self.write_data(&[
-            (col_start >> 8) as u8,
-            (col_start & 0xFF) as u8,
-            (col_end >> 8) as u8,
-            (col_end & 0xFF) as u8,
-        ])?;
+        self.write_command(
+            cmd::CASET,
+            &[
+                (col_start >> 8) as u8,
+                (col_start & 0xFF) as u8,
+                (col_end >> 8) as u8,
+                (col_end & 0xFF) as u8,
+            ],
+        )?;
 
         // Row address set
-        self.write_command(cmd::RASET)?;
-        self.write_data(&[
-            (row_start >> 8) as u8,
-            (row_start & 0xFF) as u8,
-            (row_end >> 8) as u8,
-            (row_end & 0xFF) as u8,
-        ])?;
+        self.write_command(
+            cmd::RASET,
+            &[
+                (row_start >> 8) as u8,
+                (row_start & 0xFF) as u8,
+                (row_end >> 8) as u8,
+                (row_end & 0xFF) as u8,
+            ],
+        )?;
 
         // Memory write
-        self.write_command(cmd::RAMWR)?;
+        self.write_command(cmd::RAMWR, &[])?;
 
         Ok(())
     }
 
     /// Write pixel data to the display
     pub fn write_pixels(&mut self, data: &[u8]) -> Result<(), esp_idf_hal::sys::EspError> {
-        self.dc.set_high()?;
-
-        // Write in chunks to avoid SPI buffer overflow
-        const CHUNK_SIZE: usize = 4096;
-        for chunk in data.chunks(CHUNK_SIZE) {
-            self.spi.write(chunk)?;
-        }
-
-        Ok(())
+        self.bus.write_pixels(data)
     }
 
     /// Flush a region to the display (for LVGL integration)
@@ -362,29 +371,69 @@ where
         Ok(())
     }
 
-    /// Clear the screen with a color
-    pub fn clear(&mut self, color: u16) -> Result<(), esp_idf_hal::sys::EspError> {
-        let width = self.config.effective_width();
-        let height = self.config.effective_height();
-
-        self.set_window(0, 0, width - 1, height - 1)?;
+    /// Start flushing a region without waiting for the transfer
+    ///
+    /// Queues the window setup and pixel data to SPI DMA and returns
+    /// immediately; `done` is signalled from the SPI ISR when the last pixel
+    /// chunk has been sent.
+    ///
+    /// # Safety
+    /// `data` must stay valid until `done` is signalled. LVGL guarantees this
+    /// for the draw buffer passed to the flush callback.
+    pub unsafe fn flush_async(
+        &mut self,
+        x1: i32,
+        y1: i32,
+        x2: i32,
+        y2: i32,
+        data: &[u8],
+        done: FlushReady,
+    ) -> Result<(), esp_idf_hal::sys::EspError> {
+        self.set_window(x1 as u16, y1 as u16, x2 as u16, y2 as u16)?;
+        self.bus.queue_pixels(data, Some(done))
+    }
 
-        let color_bytes = [(color >> 8) as u8, (color & 0xFF) as u8];
+    /// Flush a region whose rows are `stride` bytes apart
+    ///
+    /// Used for sub-rectangles of a full frame buffer, where rows are not
+    /// contiguous. The window is programmed once and each row is queued as
+    /// its own DMA transfer.
+    pub fn flush_strided(
+        &mut self,
+        area: &Area,
+        data: &[u8],
+        stride: usize,
+    ) -> Result<(), esp_idf_hal::sys::EspError> {
+        self.set_window(area.x1 as u16, area.y1 as u16, area.x2 as u16, area.y2 as u16)?;
 
-        // Write in lines to save memory
-        let line_bytes = (width as usize) * 2;
-        let mut line_buf = vec![0u8; line_bytes];
-        for i in 0..width as usize {
-            line_buf[i * 2] = color_bytes[0];
-            line_buf[i * 2 + 1] = color_bytes[1];
+        let row_bytes = area.width() as usize * 2;
+        if stride == row_bytes {
+            return self.bus.write_pixels(&data[..row_bytes * area.height() as usize]);
         }
 
-        self.dc.set_high()?;
-        for _ in 0..height {
-            self.spi.write(&line_buf)?;
+        for row in 0..area.height() as usize {
+            let start = row * stride;
+            // Rows stay valid until wait_idle() below
+            unsafe { self.bus.queue_pixels(&data[start..start + row_bytes], None)? };
         }
+        self.bus.wait_idle()
+    }
 
-        Ok(())
+    /// Wait for pending transfers and release the SPI bus
+    ///
+    /// Call before the UI thread goes idle so the chip can enter light sleep.
+    pub fn release_bus(&mut self) -> Result<(), esp_idf_hal::sys::EspError> {
+        self.bus.release()
+    }
+
+    /// Clear the screen with a color
+    pub fn clear(&mut self, color: u16) -> Result<(), esp_idf_hal::sys::EspError> {
+        let width = self.config.effective_width();
+        let height = self.config.effective_height();
+
+        self.set_window(0, 0, width - 1, height - 1)?;
+        self.bus
+            .fill(color.to_be_bytes(), width as usize * height as usize)
     }
 
     /// Fill a rectangle with a color
@@ -397,32 +446,8 @@ where
         color: u16,
     ) -> Result<(), esp_idf_hal::sys::EspError> {
         self.set_window(x, y, x + width - 1, y + height - 1)?;
-
-        let color_bytes = [(color >> 8) as u8, (color & 0xFF) as u8];
-        let total_pixels = (width as usize) * (height as usize);
-
-        self.dc.set_high()?;
-
-        // Write in chunks
-        const CHUNK_PIXELS: usize = 1024;
-        let mut buf = [0u8; CHUNK_PIXELS * 2];
-        for i in 0..CHUNK_PIXELS {
-            buf[i * 2] = color_bytes[0];
-            buf[i * 2 + 1] = color_bytes[1];
-        }
-
-        let full_chunks = total_pixels / CHUNK_PIXELS;
-        let remainder = total_pixels % CHUNK_PIXELS;
-
-        for _ in 0..full_chunks {
-            self.spi.write(&buf)?;
-        }
-
-        if remainder > 0 {
-            self.spi.write(&buf[..remainder * 2])?;
-        }
-
-        Ok(())
+        self.bus
+            .fill(color.to_be_bytes(), width as usize * height as usize)
     }
 
     /// Set display orientation
@@ -431,33 +456,29 @@ where
         orientation: Orientation,
     ) -> Result<(), esp_idf_hal::sys::EspError> {
         self.config.orientation = orientation;
-        self.write_command(cmd::MADCTL)?;
-        self.write_data(&[orientation.madctl_value()])?;
-        Ok(())
+        self.write_command(cmd::MADCTL, &[orientation.madctl_value()])
     }
 
     /// Turn display on
     pub fn display_on(&mut self) -> Result<(), esp_idf_hal::sys::EspError> {
-        self.write_command(cmd::DISPON)
+        self.write_command(cmd::DISPON, &[])
     }
 
     /// Turn display off
     pub fn display_off(&mut self) -> Result<(), esp_idf_hal::sys::EspError> {
-        self.write_command(cmd::DISPOFF)
+        self.write_command(cmd::DISPOFF, &[])
     }
 
     /// Enter sleep mode
     pub fn sleep(&mut self) -> Result<(), esp_idf_hal::sys::EspError> {
-        self.write_command(cmd::SLPIN)?;
-        Ets::delay_ms(5);
-        Ok(())
+        self.write_command(cmd::SLPIN, &[])?;
+        self.delay_ms(5)
     }
 
     /// Exit sleep mode
     pub fn wake(&mut self) -> Result<(), esp_idf_hal::sys::EspError> {
-        self.write_command(cmd::SLPOUT)?;
-        Ets::delay_ms(120);
-        Ok(())
+        self.write_command(cmd::SLPOUT, &[])?;
+        self.delay_ms(120)
     }
 
     /// Get display width (accounting for orientation)
@@ -470,21 +491,41 @@ where
         self.config.effective_height()
     }
 
-    /// Write a command byte
-    fn write_command(&mut self, cmd: u8) -> Result<(), esp_idf_hal::sys::EspError> {
-        self.dc.set_low()?;
-        self.spi.write(&[cmd])?;
-        Ok(())
+    /// Write a command byte followed by its parameters
+    fn write_command(&mut self, cmd: u8, params: &[u8]) -> Result<(), esp_idf_hal::sys::EspError> {
+        self.bus.command(cmd, params)
     }
 
-    /// Write data bytes
-    fn write_data(&mut self, data: &[u8]) -> Result<(), esp_idf_hal::sys::EspError> {
-        self.dc.set_high()?;
-        self.spi.write(data)?;
+    /// Wait for queued commands to go out, then delay
+    fn delay_ms(&mut self, ms: u32) -> Result<(), esp_idf_hal::sys::EspError> {
+        self.bus.wait_idle()?;
+        Ets::delay_ms(ms);
         Ok(())
     }
 }
 
+impl<'a, DC, RST> FlushSink for St7789<'a, DC, RST>
+where
+    DC: OutputPin,
+    RST: OutputPin,
+{
+    fn flush_area(&mut self, area: &Area, data: &[u8], stride: usize) {
+        let _ = self.flush_strided(area, data, stride);
+    }
+}
+
+impl<'a, DC, RST> PanelRotation for St7789<'a, DC, RST>
+where
+    DC: OutputPin,
+    RST: OutputPin,
+{
+    /// Rotate through MADCTL; queued behind pending pixel transfers on the bus
+    fn set_panel_rotation(&mut self, rotation: DisplayRotation) -> bool {
+        let orientation = self.native_orientation.rotated(rotation.quarter_turns());
+        self.set_orientation(orientation).is_ok()
+    }
+}
+
 /// RGB565 color helper
 pub mod color {
     /// Convert RGB888 to RGB565
@@ -0,0 +1,48 @@
+//! ESP-IDF capability-based buffer allocation
+//!
+//! Places LVGL draw buffers in a specific memory region using
+//! `heap_caps_aligned_alloc`, so SPI DMA can read them without bounce copies.
+
+use esp_idf_hal::sys;
+use lvgl::display::BufferAllocator;
+
+/// Allocator for a `MALLOC_CAP_*` memory region
+#[derive(Clone, Copy, Debug)]
+pub struct HeapCaps {
+    caps: u32,
+}
+
+impl HeapCaps {
+    /// DMA-capable internal SRAM (fastest for SPI panels)
+    pub const fn internal_dma() -> Self {
+        Self {
+            caps: sys::MALLOC_CAP_DMA | sys::MALLOC_CAP_INTERNAL,
+        }
+    }
+
+    /// External PSRAM (needs `CONFIG_SPIRAM` in `sdkconfig.defaults`)
+    pub const fn psram() -> Self {
+        Self {
+            caps: sys::MALLOC_CAP_SPIRAM | sys::MALLOC_CAP_8BIT,
+        }
+    }
+
+    /// Free bytes left in this region
+    pub fn free_size(&self) -> usize {
+        unsafe { sys::heap_caps_get_free_size(self.caps) }
+    }
+}
+
+impl BufferAllocator for HeapCaps {
+    unsafe fn allocate(&self, size: usize, align: usize) -> *mut u8 {
+        let buf = sys::heap_caps_aligned_alloc(align, size, self.caps) as *mut u8;
+        if !buf.is_null() {
+            core::ptr::write_bytes(buf, 0, size);
+        }
+        buf
+    }
+
+    unsafe fn deallocate(&self, ptr: *mut u8, _size: usize, _align: usize) {
+        sys::heap_caps_free(ptr as *mut _);
+    }
+}
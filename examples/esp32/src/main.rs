@@ -10,24 +10,44 @@
 //! - DC:   GPIO13
 //! - RST:  GPIO9
 //! - BL:   GPIO14
+//!
+//! CST816 touch: SDA GPIO18, SCL GPIO17, RST GPIO21, INT GPIO16
+
+use core::num::NonZeroU32;
+use std::sync::{Arc as StdArc, Mutex, OnceLock};
 
-use esp_idf_hal::delay::FreeRtos;
-use esp_idf_hal::gpio::{Gpio10, Gpio11, Gpio13, Gpio9, PinDriver};
+use esp_idf_hal::delay::{FreeRtos, BLOCK};
+use esp_idf_hal::gpio::{Gpio11, Gpio13, Gpio16, Gpio21, Gpio9, PinDriver};
+use esp_idf_hal::i2c::{I2cConfig, I2cDriver};
 use esp_idf_hal::peripherals::Peripherals;
-use esp_idf_hal::spi::{
-    config::Config as SpiConfig, config::DriverConfig, SpiDeviceDriver, SpiDriver,
-};
+use esp_idf_hal::spi::{config::DriverConfig, Dma, SpiDriver};
+use esp_idf_hal::sys;
+use esp_idf_hal::task::notification::{Notification, Notifier};
+#[cfg(feature = "multicore")]
+use esp_idf_hal::task::thread::ThreadSpawnConfiguration;
 use esp_idf_hal::units::FromValueType;
 use esp_idf_svc::log::EspLogger;
-use log::info;
+use log::{info, warn};
 
+mod assets;
 mod drivers;
+mod heap_caps;
 
+use drivers::cst816::Cst816;
+use drivers::spi_panel::{SpiPanelBus, MAX_TRANSFER_SIZE};
 use drivers::st7789::{St7789, St7789Config};
-use lvgl::display::{Display, RenderMode};
-use lvgl::input::{InputDevice, InputState, InputType, TouchPoint};
+use heap_caps::HeapCaps;
+use lvgl::display::{
+    ByteOrder, ColorFormat, Display, DisplayBuffers, DisplayRotation, FlushReady, RenderMode,
+    TouchTransform,
+};
+use lvgl::assets::AssetPack;
+use lvgl::command::{Command, CommandQueue, ObjHandle};
+use lvgl::input::{Gesture, InputDevice, InputMode, InputType, TouchQueue};
+use lvgl::observer::Subject;
+use lvgl::perf::{FrameStats, FrameStatsRing};
 use lvgl::widgets::*;
-use lvgl::{Color, Event, LvglObj, Obj, Style};
+use lvgl::{Color, Event, IdleWait, LvglObj, Obj, RunLoop, Style};
 
 // =============================================================================
 // Configuration - Adjust for your board!
@@ -37,8 +57,12 @@ const DISPLAY_WIDTH: u32 = 170;
 const DISPLAY_HEIGHT: u32 = 320;
 const BUFFER_LINES: u32 = 32;
 
-static mut DISPLAY_BUF1: [u8; (DISPLAY_WIDTH * BUFFER_LINES * 2) as usize] =
-    [0u8; (DISPLAY_WIDTH * BUFFER_LINES * 2) as usize];
+/// Draw buffers: LVGL renders into one while DMA sends the other
+const BUFFER_COUNT: usize = 2;
+
+/// While a finger is down, re-read this often even without an INT pulse so a
+/// missed release can't leave the pointer stuck
+const TOUCH_HELD_POLL_MS: u32 = 50;
 
 // =============================================================================
 // Global State (needed for C callbacks)
@@ -46,11 +70,26 @@ static mut DISPLAY_BUF1: [u8; (DISPLAY_WIDTH * BUFFER_LINES * 2) as usize] =
 
 static mut DISPLAY_DRIVER: Option<St7789<'static, Gpio13, Gpio9>> = None;
 
-static mut TOUCH_POINT: TouchPoint = TouchPoint {
-    x: 0,
-    y: 0,
-    pressed: false,
-};
+/// Widget updates from background tasks, applied by the UI loop
+static UI_UPDATES: CommandQueue<32> = CommandQueue::new();
+
+/// Wakes the UI task from `lvgl::wake()`
+static UI_NOTIFIER: OnceLock<StdArc<Notifier>> = OnceLock::new();
+
+/// Touch samples read once per CST816 interrupt, consumed by LVGL
+static TOUCH_QUEUE: TouchQueue<16> = TouchQueue::new();
+
+/// Touch mapping after a display rotation, picked up by the touch task
+static TOUCH_TRANSFORM: Mutex<Option<TouchTransform>> = Mutex::new(None);
+
+/// Arc position, shown by the label inside the arc
+static ARC_VALUE: Subject<i32> = Subject::new(65);
+
+/// Per-refresh timings, drained by the heap monitor task
+static FRAME_STATS: FrameStatsRing<32> = FrameStatsRing::new();
+
+/// Refreshes slower than this are logged
+const SLOW_FRAME_US: u32 = 33_000;
 
 // =============================================================================
 // LVGL Callbacks
@@ -67,29 +106,83 @@ unsafe extern "C" fn flush_cb(
     let x2 = area.x2;
     let y2 = area.y2;
 
-    let width = (x2 - x1 + 1) as usize;
-    let height = (y2 - y1 + 1) as usize;
-    let len = width * height * 2;
+    let len = ColorFormat::native().area_size(area);
 
     if let Some(ref mut driver) = DISPLAY_DRIVER {
         let data = core::slice::from_raw_parts(px_map, len);
-        let _ = driver.flush(x1, y1, x2, y2, data);
+        // Flush ready is signalled from the SPI ISR once DMA is done
+        if driver
+            .flush_async(x1, y1, x2, y2, data, FlushReady::from_raw(disp))
+            .is_ok()
+        {
+            return;
+        }
     }
 
     lvgl::sys::lv_display_flush_ready(disp);
 }
 
-unsafe extern "C" fn touch_read_cb(
-    _indev: *mut lvgl::sys::lv_indev_t,
-    data: *mut lvgl::sys::lv_indev_data_t,
-) {
-    (*data).point.x = TOUCH_POINT.x;
-    (*data).point.y = TOUCH_POINT.y;
-    (*data).state = if TOUCH_POINT.pressed {
-        InputState::Pressed as u32
-    } else {
-        InputState::Released as u32
+/// LVGL clock from the high-resolution ESP timer (keeps counting in light sleep)
+unsafe extern "C" fn tick_ms() -> u32 {
+    (sys::esp_timer_get_time() / 1000) as u32
+}
+
+/// Microsecond clock for frame statistics
+fn now_us() -> u64 {
+    unsafe { sys::esp_timer_get_time() as u64 }
+}
+
+/// Wake hook: notify the UI task (also safe from an ISR)
+fn notify_ui() {
+    if let Some(notifier) = UI_NOTIFIER.get() {
+        unsafe {
+            notifier.notify_and_yield(NonZeroU32::MIN);
+        }
+    }
+}
+
+// =============================================================================
+// Idle handling
+// =============================================================================
+
+/// Blocks the UI task on a FreeRTOS notification between frames
+///
+/// With the FreeRTOS idle task in tickless mode, the chip drops into light
+/// sleep while the UI and every other task are blocked.
+struct TaskIdle {
+    notification: Notification,
+}
+
+impl IdleWait for TaskIdle {
+    fn wait(&mut self, timeout_ms: Option<u32>) {
+        // An acquired SPI bus holds a PM lock that prevents light sleep
+        unsafe {
+            if let Some(ref mut driver) = DISPLAY_DRIVER {
+                let _ = driver.release_bus();
+            }
+        }
+        self.notification.wait(timeout_ms.map_or(BLOCK, ms_to_ticks));
+    }
+}
+
+fn ms_to_ticks(ms: u32) -> u32 {
+    (ms as u64 * sys::CONFIG_FREERTOS_HZ as u64).div_ceil(1000) as u32
+}
+
+/// Scale the CPU clock down and allow automatic light sleep when idle
+#[cfg(esp_idf_pm_enable)]
+fn enable_light_sleep() -> Result<(), sys::EspError> {
+    let config = sys::esp_pm_config_t {
+        max_freq_mhz: 240,
+        min_freq_mhz: 80,
+        light_sleep_enable: true,
     };
+    sys::esp!(unsafe { sys::esp_pm_configure(&config as *const _ as *const core::ffi::c_void) })?;
+
+    // Touch INT (GPIO16, active low, level-triggered like the touch ISR)
+    // wakes the chip so taps are not missed
+    sys::esp!(unsafe { sys::gpio_wakeup_enable(16, sys::gpio_int_type_t_GPIO_INTR_LOW_LEVEL) })?;
+    sys::esp!(unsafe { sys::esp_sleep_enable_gpio_wakeup() })
 }
 
 // =============================================================================
@@ -158,16 +251,28 @@ fn main() -> Result<(), Box<dyn std::error::Error>> {
     let rst = PinDriver::output(peripherals.pins.gpio9)?;
     let mut bl = PinDriver::output(peripherals.pins.gpio14)?;
 
-    let spi_driver = SpiDriver::new(spi, sclk, mosi, None::<Gpio11>, &DriverConfig::default())?;
-
-    let spi_config = SpiConfig::default()
-        .baudrate(60.MHz().into())
-        .write_only(true);
-
-    let spi_device = SpiDeviceDriver::new(&spi_driver, Some(cs), &spi_config)?;
+    // Touch controller
+    let i2c = I2cDriver::new(
+        peripherals.i2c0,
+        peripherals.pins.gpio18,
+        peripherals.pins.gpio17,
+        &I2cConfig::new().baudrate(400.kHz().into()),
+    )?;
+    let touch_rst = PinDriver::output(peripherals.pins.gpio21)?;
+    let touch_int = PinDriver::input(peripherals.pins.gpio16)?;
+
+    let spi_driver = SpiDriver::new(
+        spi,
+        sclk,
+        mosi,
+        None::<Gpio11>,
+        &DriverConfig::new().dma(Dma::Auto(MAX_TRANSFER_SIZE)),
+    )?;
+
+    let panel_bus = SpiPanelBus::new(&spi_driver, cs, dc, 60_000_000)?;
 
     let config = St7789Config::t_display_s3();
-    let mut display_driver = St7789::new(spi_device, dc, Some(rst), config);
+    let mut display_driver = St7789::new(panel_bus, Some(rst), config);
 
     info!("Initializing ST7789 display...");
     display_driver.init()?;
@@ -177,37 +282,270 @@ fn main() -> Result<(), Box<dyn std::error::Error>> {
         DISPLAY_DRIVER = Some(core::mem::transmute(display_driver));
     }
 
+    // LVGL starts its draw threads in lv_init(); let them float across cores
+    #[cfg(feature = "multicore")]
+    ThreadSpawnConfiguration {
+        stack_size: 8192,
+        pin_to_core: None,
+        ..Default::default()
+    }
+    .set()?;
+
     // Initialize LVGL
     lvgl::init()?;
+    #[cfg(feature = "bench")]
+    run_benchmarks()?;
+    lvgl::set_tick_source(tick_ms);
 
     let display = Display::create(DISPLAY_WIDTH, DISPLAY_HEIGHT)?;
-    unsafe {
-        display.set_buffers(&mut DISPLAY_BUF1, None, RenderMode::Partial);
-    }
+    // Prefer DMA-capable internal RAM, fall back to PSRAM if it is full
+    let buffers = DisplayBuffers::allocate(
+        &HeapCaps::internal_dma(),
+        ColorFormat::native(),
+        DISPLAY_WIDTH,
+        DISPLAY_HEIGHT,
+        RenderMode::Partial,
+        BUFFER_LINES,
+        BUFFER_COUNT,
+    )
+    .or_else(|_| {
+        DisplayBuffers::allocate(
+            &HeapCaps::psram(),
+            ColorFormat::native(),
+            DISPLAY_WIDTH,
+            DISPLAY_HEIGHT,
+            RenderMode::Partial,
+            BUFFER_LINES,
+            BUFFER_COUNT,
+        )
+    })?;
+    display.attach_buffers(&buffers);
+    info!(
+        "Draw buffers: {} x {} bytes, {} bytes internal DMA RAM left",
+        buffers.count(),
+        buffers.size(),
+        HeapCaps::internal_dma().free_size()
+    );
     display.set_flush_cb(flush_cb);
+    // ST7789 expects big-endian RGB565
+    display.set_byte_order(ByteOrder::Swapped);
+    display.set_frame_observer(&FRAME_STATS, now_us);
+
+    let mut touch = Cst816::new(
+        i2c,
+        Some(touch_rst),
+        Some(touch_int),
+        DISPLAY_WIDTH as u16,
+        DISPLAY_HEIGHT as u16,
+    );
+    touch.init()?;
 
     let indev = InputDevice::create()?;
     indev.set_type(InputType::Pointer);
-    indev.set_read_cb(touch_read_cb);
+    indev.set_touch_queue(&TOUCH_QUEUE);
+    // Read on touch interrupts only, so an idle UI is not woken to poll
+    indev.set_mode(InputMode::Event);
+
+    let pack = match assets::open() {
+        Ok(Some(pack)) => {
+            info!("Asset pack: {} assets", pack.len());
+            Some(pack)
+        }
+        Ok(None) => None,
+        Err(e) => {
+            warn!("Asset partition not mapped: {:?}", e);
+            None
+        }
+    };
 
     info!("Creating UI...");
-    create_demo_ui()?;
+    let ram_bar = create_demo_ui(pack)?;
+    spawn_heap_monitor(ram_bar)?;
+    spawn_touch_task(touch)?;
+
+    // Sleep until the next LVGL timer, a queued update or an input IRQ
+    let notification = Notification::new();
+    let _ = UI_NOTIFIER.set(notification.notifier());
+    lvgl::set_wake_hook(notify_ui);
+    #[cfg(esp_idf_pm_enable)]
+    enable_light_sleep()?;
 
     info!("UI created, entering main loop...");
 
+    let mut run_loop = RunLoop::new(TaskIdle { notification });
+    let mut rotation = DisplayRotation::None;
     loop {
-        let delay_ms = lvgl::task_handler();
-        FreeRtos::delay_ms(core::cmp::min(delay_ms, 5));
+        UI_UPDATES.drain();
+        if !TOUCH_QUEUE.is_empty() {
+            indev.read();
+        }
+        if let Some(gesture) = TOUCH_QUEUE.take_gesture() {
+            info!("Gesture: {:?}", gesture);
+            // Long press switches between portrait and landscape
+            if gesture == Gesture::LongPress {
+                rotation = match rotation {
+                    DisplayRotation::None => DisplayRotation::Rotate90,
+                    _ => DisplayRotation::None,
+                };
+                rotate_display(&display, rotation);
+            }
+        }
+        run_loop.run_once();
+    }
+}
+
+/// Rotate through the panel's MADCTL and hand the touch mapping to the touch task
+fn rotate_display(display: &Display, rotation: DisplayRotation) {
+    let driver = match unsafe { DISPLAY_DRIVER.as_mut() } {
+        Some(driver) => driver,
+        None => return,
+    };
+    let rotated = display.rotate_with(rotation, driver);
+    info!(
+        "Rotated to {:?}: {}x{} ({})",
+        rotation,
+        rotated.width,
+        rotated.height,
+        if rotated.hardware { "MADCTL" } else { "software" }
+    );
+    *TOUCH_TRANSFORM.lock().unwrap() = Some(rotated.touch);
+}
+
+/// Run the render benchmarks on a headless display and log one row per scene
+///
+/// Uses the panel's resolution and draw buffer height, so the `partial`
+/// rows match the real pipeline minus the SPI transfer.
+#[cfg(feature = "bench")]
+fn run_benchmarks() -> Result<(), lvgl::LvglError> {
+    use lvgl::bench::{self, BenchConfig};
+
+    fn heap_used() -> usize {
+        unsafe {
+            sys::heap_caps_get_total_size(sys::MALLOC_CAP_DEFAULT)
+                - sys::heap_caps_get_free_size(sys::MALLOC_CAP_DEFAULT)
+        }
     }
+
+    let mut config = BenchConfig::new(DISPLAY_WIDTH, DISPLAY_HEIGHT, now_us);
+    config.frames = 60;
+    config.partial_lines = BUFFER_LINES;
+    config.heap_used = Some(heap_used);
+
+    info!("Render benchmark, {} frames per scene", config.frames);
+    info!("{}", bench::HEADER);
+    bench::run(&config, |result| {
+        info!("{}", result);
+        // Let the idle task feed the task watchdog between scenes
+        FreeRtos::delay_ms(1);
+    })
 }
 
 // =============================================================================
 // Demo UI — Scrollable vertical layout for tall narrow screen
 // =============================================================================
 
-fn create_demo_ui() -> Result<(), lvgl::LvglError> {
+/// Report heap usage to the RAM bar from a separate task
+fn spawn_heap_monitor(ram_bar: ObjHandle<Bar>) -> std::io::Result<()> {
+    std::thread::Builder::new()
+        .stack_size(4096)
+        .spawn(move || loop {
+            log_slow_frame();
+            let (free, total) = unsafe {
+                (
+                    esp_idf_hal::sys::heap_caps_get_free_size(esp_idf_hal::sys::MALLOC_CAP_DEFAULT),
+                    esp_idf_hal::sys::heap_caps_get_total_size(esp_idf_hal::sys::MALLOC_CAP_DEFAULT),
+                )
+            };
+            let used_pct = (100 - free * 100 / total.max(1)) as i32;
+            let _ = UI_UPDATES.push(Command::bar_value(ram_bar, used_pct, true));
+            FreeRtos::delay_ms(1000);
+        })?;
+    Ok(())
+}
+
+/// Drain the frame statistics and log the slowest refresh if it was slow
+fn log_slow_frame() {
+    let mut slowest: Option<FrameStats> = None;
+    // The heap monitor is the only reader
+    while let Some(frame) = unsafe { FRAME_STATS.pop() } {
+        if slowest.map_or(true, |s| frame.total_us > s.total_us) {
+            slowest = Some(frame);
+        }
+    }
+    if let Some(f) = slowest.filter(|f| f.total_us > SLOW_FRAME_US) {
+        warn!(
+            "Slow frame: {} us (layout {}, render {}, flush {}, wait {}), {} dirty px, {} bytes",
+            f.total_us,
+            f.layout_us,
+            f.render_us,
+            f.flush_us,
+            f.flush_wait_us,
+            f.dirty_pixels,
+            f.flushed_bytes
+        );
+    }
+}
+
+/// Read the touch controller once per INT pulse and queue the samples
+fn spawn_touch_task(
+    mut touch: Cst816<'static, Gpio21, Gpio16>,
+) -> Result<(), Box<dyn std::error::Error>> {
+    std::thread::Builder::new()
+        .stack_size(4096)
+        .spawn(move || {
+            let notification = Notification::new();
+            let notifier = notification.notifier();
+            // The ISR only wakes this task; the I2C read happens below
+            let subscribed = unsafe {
+                touch.subscribe(move || {
+                    notifier.notify_and_yield(NonZeroU32::MIN);
+                })
+            };
+            if let Err(e) = subscribed {
+                warn!("Touch interrupt unavailable: {}", e);
+                return;
+            }
+
+            let mut pressed = false;
+            loop {
+                let _ = touch.enable_interrupt();
+                notification.wait(if pressed {
+                    ms_to_ticks(TOUCH_HELD_POLL_MS)
+                } else {
+                    BLOCK
+                });
+
+                if let Some(transform) = TOUCH_TRANSFORM.lock().unwrap().take() {
+                    touch.apply_transform(&transform);
+                }
+                match touch.read() {
+                    Ok(data) => {
+                        pressed = data.pressed;
+                        if let Some(gesture) = data.gesture.and_then(|g| g.to_lvgl()) {
+                            TOUCH_QUEUE.set_gesture(gesture);
+                        }
+                        // This task is the only producer
+                        let _ = unsafe { TOUCH_QUEUE.push(data.into()) };
+                        lvgl::wake();
+                    }
+                    Err(e) => warn!("Touch read failed: {}", e),
+                }
+            }
+        })?;
+    Ok(())
+}
+
+/// Build the demo UI, returning the RAM bar for background updates
+fn create_demo_ui(pack: Option<&'static AssetPack>) -> Result<ObjHandle<Bar>, lvgl::LvglError> {
     let screen = lvgl::screen_active().expect("No active screen");
+    // One style refresh for the whole screen instead of one per setter
+    screen.batch(|screen| build_demo_ui(screen, pack))
+}
 
+fn build_demo_ui(
+    screen: &Obj,
+    pack: Option<&'static AssetPack>,
+) -> Result<ObjHandle<Bar>, lvgl::LvglError> {
     // Dark background with vertical flex
     let bg_style = Box::leak(Box::new(Style::new()));
     bg_style.set_bg_color(Color::hex(0x1a1a2e));
@@ -216,21 +554,28 @@ fn create_demo_ui() -> Result<(), lvgl::LvglError> {
     bg_style.set_pad_row(8);
     screen.add_style(bg_style, 0);
 
-    set_flex_flow(&screen, lvgl::sys::LV_FLEX_FLOW_COLUMN);
+    set_flex_flow(screen, lvgl::sys::LV_FLEX_FLOW_COLUMN);
     set_flex_align(
-        &screen,
+        screen,
         lvgl::sys::LV_FLEX_ALIGN_START,
         lvgl::sys::LV_FLEX_ALIGN_CENTER,
         lvgl::sys::LV_FLEX_ALIGN_CENTER,
     );
 
     // Title
-    let title = Label::create(&screen)?;
+    let title = Label::create(screen)?;
     title.set_text(c"LVGL + ESP32");
     title.set_text_color(Color::hex(0x00d4ff));
+    // Optional assets from the flash partition
+    if let Some(font) = pack.and_then(|p| p.font("title")) {
+        title.set_style_text_font(font, 0);
+    }
+    if let Some(logo) = pack.and_then(|p| p.image("logo")) {
+        Image::create(screen)?.set_image(logo);
+    }
 
     // LED + Button row
-    let btn_row = create_row(&screen)?;
+    let btn_row = create_row(screen)?;
     set_pad_column(&btn_row, 10);
 
     let led = Led::create(&btn_row)?;
@@ -254,7 +599,7 @@ fn create_demo_ui() -> Result<(), lvgl::LvglError> {
     });
 
     // Slider with live value
-    let slider_row = create_row(&screen)?;
+    let slider_row = create_row(screen)?;
     set_pad_column(&slider_row, 8);
 
     let slider_val = Label::create(&slider_row)?;
@@ -268,16 +613,14 @@ fn create_demo_ui() -> Result<(), lvgl::LvglError> {
     slider.set_value(50, false);
 
     let slider_ptr = slider.raw();
-    let slider_val_ptr = slider_val.raw();
-    slider.add_event_cb(Event::ValueChanged, move || unsafe {
-        let val = lvgl::sys::lv_slider_get_value(slider_ptr);
-        let mut buf = [0u8; 8];
-        let text = format_int(&mut buf, val);
-        lvgl::sys::lv_label_set_text(slider_val_ptr, text.as_ptr() as *const _);
+    // Only touches the label when the shown number changes
+    let mut slider_val = FormattedLabel::<8>::from_label(slider_val);
+    slider.add_event_cb(Event::ValueChanged, move || {
+        slider_val.set_int(unsafe { lvgl::sys::lv_slider_get_value(slider_ptr) });
     });
 
     // Switch + Checkbox
-    let toggle_row = create_row(&screen)?;
+    let toggle_row = create_row(screen)?;
     set_pad_column(&toggle_row, 12);
 
     let sw_label = Label::create(&toggle_row)?;
@@ -291,12 +634,12 @@ fn create_demo_ui() -> Result<(), lvgl::LvglError> {
     cb.set_text(c"Auto");
 
     // Dropdown
-    let dd = Dropdown::create(&screen)?;
+    let dd = Dropdown::create(screen)?;
     dd.set_width(150);
     dd.set_options(c"115200\n57600\n38400\n19200\n9600");
 
     // Progress bars
-    let bar_row1 = create_row(&screen)?;
+    let bar_row1 = create_row(screen)?;
     set_pad_column(&bar_row1, 6);
     let bl1 = Label::create(&bar_row1)?;
     bl1.set_text(c"CPU");
@@ -307,7 +650,7 @@ fn create_demo_ui() -> Result<(), lvgl::LvglError> {
     b1.set_range(0, 100);
     b1.set_value(72, true);
 
-    let bar_row2 = create_row(&screen)?;
+    let bar_row2 = create_row(screen)?;
     set_pad_column(&bar_row2, 6);
     let bl2 = Label::create(&bar_row2)?;
     bl2.set_text(c"RAM");
@@ -319,87 +662,25 @@ fn create_demo_ui() -> Result<(), lvgl::LvglError> {
     b2.set_value(45, true);
 
     // Arc + Spinner
-    let bottom_row = create_row(&screen)?;
+    let bottom_row = create_row(screen)?;
     set_pad_column(&bottom_row, 16);
 
     let arc = Arc::create(&bottom_row)?;
     arc.set_size(65, 65);
     arc.set_range(0, 100);
-    arc.set_value(65);
     arc.set_bg_angles(135, 45);
 
     let arc_label = Label::create(&arc)?;
-    arc_label.set_text(c"65%");
     arc_label.center();
     arc_label.set_text_color(Color::hex(0x00ff88));
 
-    let arc_ptr = arc.raw();
-    let arc_label_ptr = arc_label.raw();
-    arc.add_event_cb(Event::ValueChanged, move || unsafe {
-        let val = lvgl::sys::lv_arc_get_value(arc_ptr);
-        let mut buf = [0u8; 8];
-        let text = format_int_percent(&mut buf, val);
-        lvgl::sys::lv_label_set_text(arc_label_ptr, text.as_ptr() as *const _);
-    });
+    // Dragging the arc updates the subject, which updates the label
+    arc.bind_value(&ARC_VALUE)?;
+    arc_label.bind_text(&ARC_VALUE, c"%d%%")?;
 
     let spinner = Spinner::create(&bottom_row)?;
     spinner.set_size(40, 40);
     spinner.set_anim_params(1000, 270);
 
-    Ok(())
-}
-
-// =============================================================================
-// Helpers
-// =============================================================================
-
-/// Format an integer as "N%" with null terminator.
-fn format_int_percent(buf: &mut [u8; 8], val: i32) -> &[u8] {
-    let mut n = if val < 0 { 0 } else { val as u32 };
-    let mut tmp = [0u8; 6];
-    let mut len = 0;
-    if n == 0 {
-        tmp[0] = b'0';
-        len = 1;
-    } else {
-        while n > 0 {
-            tmp[len] = b'0' + (n % 10) as u8;
-            n /= 10;
-            len += 1;
-        }
-    }
-    for i in 0..len {
-        buf[i] = tmp[len - 1 - i];
-    }
-    buf[len] = b'%';
-    buf[len + 1] = 0;
-    &buf[..len + 2]
-}
-
-/// Format an integer with null terminator.
-fn format_int(buf: &mut [u8; 8], val: i32) -> &[u8] {
-    let negative = val < 0;
-    let mut n = if negative { (-val) as u32 } else { val as u32 };
-    let mut tmp = [0u8; 6];
-    let mut len = 0;
-    if n == 0 {
-        tmp[0] = b'0';
-        len = 1;
-    } else {
-        while n > 0 {
-            tmp[len] = b'0' + (n % 10) as u8;
-            n /= 10;
-            len += 1;
-        }
-    }
-    let mut pos = 0;
-    if negative {
-        buf[0] = b'-';
-        pos = 1;
-    }
-    for i in 0..len {
-        buf[pos + i] = tmp[len - 1 - i];
-    }
-    buf[pos + len] = 0;
-    &buf[..pos + len + 1]
+    Ok(b2.handle())
 }
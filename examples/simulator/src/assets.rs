@@ -0,0 +1,59 @@
+//! Asset pack from a memory-mapped file
+//!
+//! The simulator counterpart of the ESP32 asset partition: the pack file is
+//! mapped read-only and never unmapped, so assets are used in place exactly
+//! as on the device. Build a pack with `cargo run --bin pack_assets`.
+
+use std::fs::File;
+use std::io;
+use std::path::Path;
+
+use lvgl::assets::AssetPack;
+
+/// Map `path` and open the pack in it
+pub fn open(path: &Path) -> io::Result<&'static AssetPack> {
+    let data = map_file(path)?;
+    AssetPack::from_static(data)
+        .map(AssetPack::leak)
+        .map_err(|_| io::Error::new(io::ErrorKind::InvalidData, "not an asset pack"))
+}
+
+/// Map a whole file read-only for the rest of the program
+#[cfg(unix)]
+fn map_file(path: &Path) -> io::Result<&'static [u8]> {
+    use std::os::fd::AsRawFd;
+
+    let file = File::open(path)?;
+    let len = file.metadata()?.len() as usize;
+    if len == 0 {
+        return Ok(&[]);
+    }
+    unsafe {
+        let data = libc::mmap(
+            std::ptr::null_mut(),
+            len,
+            libc::PROT_READ,
+            libc::MAP_PRIVATE,
+            file.as_raw_fd(),
+            0,
+        );
+        if data == libc::MAP_FAILED {
+            return Err(io::Error::last_os_error());
+        }
+        // The mapping outlives the file descriptor
+        Ok(std::slice::from_raw_parts(data as *const u8, len))
+    }
+}
+
+/// Without mmap, read the file into a 4-byte aligned buffer that is never freed
+#[cfg(not(unix))]
+fn map_file(path: &Path) -> io::Result<&'static [u8]> {
+    use std::io::Read;
+
+    let mut file = File::open(path)?;
+    let len = file.metadata()?.len() as usize;
+    let words: &'static mut [u32] = Vec::leak(vec![0u32; len.div_ceil(4)]);
+    let bytes = unsafe { std::slice::from_raw_parts_mut(words.as_mut_ptr() as *mut u8, len) };
+    file.read_exact(bytes)?;
+    Ok(bytes)
+}
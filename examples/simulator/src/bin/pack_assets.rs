@@ -0,0 +1,39 @@
+//! Build an asset pack from image files
+//!
+//!   cargo run --bin pack_assets -- assets.bin logo=logo.png photo=photo.jpg
+//!
+//! PNG and JPEG files are stored as-is and decoded on first draw (build the
+//! app with the `png` / `jpeg` features). Fonts are added from Rust with
+//! `PackBuilder::add_font`.
+
+use std::path::Path;
+
+use lvgl::assets::PackBuilder;
+
+fn main() -> Result<(), Box<dyn std::error::Error>> {
+    let mut args = std::env::args().skip(1);
+    let out = args
+        .next()
+        .ok_or("usage: pack_assets OUTPUT NAME=FILE...")?;
+
+    let mut pack = PackBuilder::new();
+    for arg in args {
+        let (name, file) = arg.split_once('=').ok_or("expected NAME=FILE")?;
+        let ext = Path::new(file)
+            .extension()
+            .and_then(|e| e.to_str())
+            .unwrap_or("")
+            .to_ascii_lowercase();
+        if !matches!(ext.as_str(), "png" | "jpg" | "jpeg") {
+            return Err(format!("{}: only PNG and JPEG files are supported", file).into());
+        }
+        let data = std::fs::read(file)?;
+        pack.add_encoded_image(name, &data)
+            .map_err(|e| format!("{}: {}", name, e))?;
+    }
+
+    let data = pack.finish();
+    std::fs::write(&out, &data)?;
+    println!("{}: {} bytes", out, data.len());
+    Ok(())
+}
@@ -5,16 +5,20 @@
 //!
 //! Build and run:
 //!   cargo run
+//!   cargo run -- assets.bin    # with an asset pack (see src/bin/pack_assets.rs)
 
+mod assets;
 mod simulator_display;
 
-use std::thread;
-use std::time::{Duration, Instant};
+use std::path::Path;
+use std::sync::OnceLock;
+use std::time::Instant;
 
-use lvgl::display::{Display, RenderMode};
-use lvgl::input::{InputDevice, InputType};
+use lvgl::assets::AssetPack;
+use lvgl::display::{calc_buf_size, AlignedBuffer, ColorFormat, Display, RenderMode};
+use lvgl::input::{InputDevice, InputMode, InputType};
 use lvgl::widgets::*;
-use lvgl::{Color, Event, LvglObj, Obj, Style};
+use lvgl::{Color, Event, IdleWait, LvglObj, Obj, RunLoop, Style};
 
 use simulator_display::SimulatorDisplay;
 
@@ -27,9 +31,8 @@ const DISPLAY_HEIGHT: u32 = 240;
 const WINDOW_SCALE: u32 = 2;
 const BUFFER_LINES: u32 = 24;
 
-#[repr(C, align(4))]
-struct AlignedBuf([u8; (DISPLAY_WIDTH * BUFFER_LINES * 2) as usize]);
-static mut DISPLAY_BUF: AlignedBuf = AlignedBuf([0u8; (DISPLAY_WIDTH * BUFFER_LINES * 2) as usize]);
+const BUF_SIZE: usize = calc_buf_size(DISPLAY_WIDTH, DISPLAY_HEIGHT, BUFFER_LINES);
+static mut DISPLAY_BUF: AlignedBuffer<BUF_SIZE> = AlignedBuffer::new();
 
 static mut SIMULATOR: Option<SimulatorDisplay> = None;
 
@@ -37,6 +40,11 @@ static mut MOUSE_X: i32 = 0;
 static mut MOUSE_Y: i32 = 0;
 static mut MOUSE_PRESSED: bool = false;
 
+/// Input read period while the mouse button is held (long press, scrolling)
+const PRESSED_READ_PERIOD_MS: u32 = 33;
+
+static START_TIME: OnceLock<Instant> = OnceLock::new();
+
 // =============================================================================
 // LVGL Callbacks
 // =============================================================================
@@ -52,9 +60,7 @@ unsafe extern "C" fn flush_cb(
     let x2 = area.x2;
     let y2 = area.y2;
 
-    let width = (x2 - x1 + 1) as usize;
-    let height = (y2 - y1 + 1) as usize;
-    let len = width * height * 2;
+    let len = ColorFormat::native().area_size(area);
 
     if let Some(ref mut sim) = SIMULATOR {
         let data = std::slice::from_raw_parts(px_map, len);
@@ -64,6 +70,11 @@ unsafe extern "C" fn flush_cb(
     lvgl::sys::lv_display_flush_ready(disp);
 }
 
+/// LVGL clock: milliseconds since start-up
+unsafe extern "C" fn tick_ms() -> u32 {
+    START_TIME.get_or_init(Instant::now).elapsed().as_millis() as u32
+}
+
 unsafe extern "C" fn touch_read_cb(
     _indev: *mut lvgl::sys::lv_indev_t,
     data: *mut lvgl::sys::lv_indev_data_t,
@@ -77,6 +88,29 @@ unsafe extern "C" fn touch_read_cb(
     };
 }
 
+// =============================================================================
+// Idle handling
+// =============================================================================
+
+/// Presents the last frame, then blocks on the SDL event queue
+struct SdlIdle;
+
+impl IdleWait for SdlIdle {
+    fn wait(&mut self, timeout_ms: Option<u32>) {
+        let sim = unsafe { SIMULATOR.as_mut().unwrap() };
+        sim.render_if_dirty();
+
+        // Event-mode input is only read on new events; keep reading while
+        // the button is held so long presses still fire
+        let timeout_ms = if sim.mouse_state().2 {
+            Some(timeout_ms.map_or(PRESSED_READ_PERIOD_MS, |t| t.min(PRESSED_READ_PERIOD_MS)))
+        } else {
+            timeout_ms
+        };
+        sim.wait_events(timeout_ms);
+    }
+}
+
 // =============================================================================
 // Layout helpers
 // =============================================================================
@@ -144,46 +178,58 @@ fn main() -> Result<(), Box<dyn std::error::Error>> {
     }
 
     lvgl::init()?;
+    lvgl::set_tick_source(tick_ms);
 
     let display = Display::create(DISPLAY_WIDTH, DISPLAY_HEIGHT)?;
     unsafe {
-        display.set_buffers(&mut DISPLAY_BUF.0, None, RenderMode::Partial);
+        display.set_buffers(DISPLAY_BUF.as_mut_slice(), None, RenderMode::Partial);
     }
     display.set_flush_cb(flush_cb);
 
     let indev = InputDevice::create()?;
     indev.set_type(InputType::Pointer);
     indev.set_read_cb(touch_read_cb);
+    // Read on mouse events instead of polling every refresh period
+    indev.set_mode(InputMode::Event);
+
+    let pack = match std::env::args().nth(1) {
+        Some(path) => match assets::open(Path::new(&path)) {
+            Ok(pack) => {
+                println!("Asset pack {}: {} assets", path, pack.len());
+                Some(pack)
+            }
+            Err(e) => {
+                eprintln!("Asset pack {}: {}", path, e);
+                None
+            }
+        },
+        None => None,
+    };
 
-    create_demo_ui()?;
+    create_demo_ui(pack)?;
 
-    let start_time = Instant::now();
-    let mut last_tick = 0u32;
+    // Sleep on the SDL event queue until input or the next LVGL timer
+    lvgl::set_wake_hook(simulator_display::wake_from_any_thread);
+    let mut run_loop = RunLoop::new(SdlIdle);
 
     loop {
-        let elapsed = start_time.elapsed().as_millis() as u32;
-        if elapsed > last_tick {
-            lvgl::tick_inc(elapsed - last_tick);
-            last_tick = elapsed;
-        }
-
         let sim = unsafe { SIMULATOR.as_mut().unwrap() };
-        sim.poll_events();
-
         if sim.quit_requested() {
             break;
         }
 
+        let input_changed = sim.take_input_changed();
         let (mx, my, pressed) = sim.mouse_state();
         unsafe {
             MOUSE_X = mx;
             MOUSE_Y = my;
             MOUSE_PRESSED = pressed;
         }
+        if input_changed || pressed {
+            indev.read();
+        }
 
-        let delay_ms = lvgl::task_handler();
-        sim.render();
-        thread::sleep(Duration::from_millis(delay_ms.min(16) as u64));
+        run_loop.run_once();
     }
 
     Ok(())
@@ -193,7 +239,7 @@ fn main() -> Result<(), Box<dyn std::error::Error>> {
 // Demo UI — Tabview with 3 tabs
 // =============================================================================
 
-fn create_demo_ui() -> Result<(), lvgl::LvglError> {
+fn create_demo_ui(pack: Option<&'static AssetPack>) -> Result<(), lvgl::LvglError> {
     let screen = lvgl::screen_active().expect("No active screen");
 
     // Screen padding (keep default light theme)
@@ -223,7 +269,7 @@ fn create_demo_ui() -> Result<(), lvgl::LvglError> {
     tab2.add_style(tab_style, 0);
     tab3.add_style(tab_style, 0);
 
-    create_controls_tab(&tab1)?;
+    create_controls_tab(&tab1, pack)?;
     create_data_tab(&tab2)?;
     create_inputs_tab(&tab3)?;
 
@@ -234,7 +280,7 @@ fn create_demo_ui() -> Result<(), lvgl::LvglError> {
 // Tab 1: Controls — Button, Slider, Switch, Checkbox, LED
 // =============================================================================
 
-fn create_controls_tab(tab: &Obj) -> Result<(), lvgl::LvglError> {
+fn create_controls_tab(tab: &Obj, pack: Option<&'static AssetPack>) -> Result<(), lvgl::LvglError> {
     set_flex_flow(tab, lvgl::sys::LV_FLEX_FLOW_COLUMN);
     set_flex_align(
         tab,
@@ -243,6 +289,11 @@ fn create_controls_tab(tab: &Obj) -> Result<(), lvgl::LvglError> {
         lvgl::sys::LV_FLEX_ALIGN_CENTER,
     );
 
+    // Logo from the asset pack, used in place from the mapped file
+    if let Some(logo) = pack.and_then(|p| p.image("logo")) {
+        Image::create(tab)?.set_image(logo);
+    }
+
     // Button with LED indicator
     let btn_row = create_row(tab)?;
     set_pad_column(&btn_row, 12);
@@ -283,12 +334,10 @@ fn create_controls_tab(tab: &Obj) -> Result<(), lvgl::LvglError> {
     slider.set_value(50, false);
 
     let slider_ptr = slider.raw();
-    let slider_val_ptr = slider_val.raw();
-    slider.add_event_cb(Event::ValueChanged, move || unsafe {
-        let val = lvgl::sys::lv_slider_get_value(slider_ptr);
-        let mut buf = [0u8; 8];
-        let text = format_int(&mut buf, val);
-        lvgl::sys::lv_label_set_text(slider_val_ptr, text.as_ptr() as *const _);
+    // Only touches the label when the shown number changes
+    let mut slider_val = FormattedLabel::<8>::from_label(slider_val);
+    slider.add_event_cb(Event::ValueChanged, move || {
+        slider_val.set_int(unsafe { lvgl::sys::lv_slider_get_value(slider_ptr) });
     });
 
     // Switch + Checkbox row
@@ -321,12 +370,10 @@ fn create_controls_tab(tab: &Obj) -> Result<(), lvgl::LvglError> {
     arc_label.set_text_color(Color::hex(0x2e7d32));
 
     let arc_ptr = arc.raw();
-    let arc_label_ptr = arc_label.raw();
-    arc.add_event_cb(Event::ValueChanged, move || unsafe {
-        let val = lvgl::sys::lv_arc_get_value(arc_ptr);
-        let mut buf = [0u8; 8];
-        let text = format_int_percent(&mut buf, val);
-        lvgl::sys::lv_label_set_text(arc_label_ptr, text.as_ptr() as *const _);
+    let mut arc_label = FormattedLabel::<8>::from_label(arc_label);
+    arc.add_event_cb(Event::ValueChanged, move || {
+        let val = unsafe { lvgl::sys::lv_arc_get_value(arc_ptr) };
+        arc_label.set_fmt(format_args!("{}%", val));
     });
 
     let spinner = Spinner::create(&arc_row)?;
@@ -459,58 +506,3 @@ fn create_inputs_tab(tab: &Obj) -> Result<(), lvgl::LvglError> {
 
     Ok(())
 }
-
-// =============================================================================
-// Helpers
-// =============================================================================
-
-/// Format an integer as "N%" with null terminator.
-fn format_int_percent(buf: &mut [u8; 8], val: i32) -> &[u8] {
-    let mut n = if val < 0 { 0 } else { val as u32 };
-    let mut tmp = [0u8; 6];
-    let mut len = 0;
-    if n == 0 {
-        tmp[0] = b'0';
-        len = 1;
-    } else {
-        while n > 0 {
-            tmp[len] = b'0' + (n % 10) as u8;
-            n /= 10;
-            len += 1;
-        }
-    }
-    for i in 0..len {
-        buf[i] = tmp[len - 1 - i];
-    }
-    buf[len] = b'%';
-    buf[len + 1] = 0;
-    &buf[..len + 2]
-}
-
-/// Format an integer with null terminator (no % suffix).
-fn format_int(buf: &mut [u8; 8], val: i32) -> &[u8] {
-    let negative = val < 0;
-    let mut n = if negative { (-val) as u32 } else { val as u32 };
-    let mut tmp = [0u8; 6];
-    let mut len = 0;
-    if n == 0 {
-        tmp[0] = b'0';
-        len = 1;
-    } else {
-        while n > 0 {
-            tmp[len] = b'0' + (n % 10) as u8;
-            n /= 10;
-            len += 1;
-        }
-    }
-    let mut pos = 0;
-    if negative {
-        buf[0] = b'-';
-        pos = 1;
-    }
-    for i in 0..len {
-        buf[pos + i] = tmp[len - 1 - i];
-    }
-    buf[pos + len] = 0;
-    &buf[..pos + len + 1]
-}
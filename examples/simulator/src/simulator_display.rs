@@ -2,18 +2,31 @@
 //!
 //! Allows running LVGL on desktop for development/testing.
 //! Uses SDL2 for window management and rendering.
+//!
+//! The window keeps one streaming texture for its lifetime. Each flushed
+//! area is uploaded straight from LVGL's draw buffer into its rectangle of
+//! the texture, so a frame costs what LVGL redrew rather than a full-screen
+//! copy and upload.
+
+use sdl2::pixels::PixelFormatEnum;
+use sdl2::rect::Rect;
+use sdl2::render::{Canvas, Texture};
+use sdl2::video::Window;
 
 /// SDL2 window wrapper for LVGL simulation
 pub struct SimulatorDisplay {
     width: u32,
     height: u32,
     scale: u32,
-    canvas: sdl2::render::Canvas<sdl2::video::Window>,
+    canvas: Canvas<Window>,
+    /// RGB565 copy of the display, updated per flushed area
+    texture: Texture,
     event_pump: sdl2::EventPump,
-    framebuffer: Vec<u8>,
     mouse_x: i32,
     mouse_y: i32,
     mouse_pressed: bool,
+    input_changed: bool,
+    frame_dirty: bool,
     quit_requested: bool,
 }
 
@@ -44,19 +57,25 @@ impl SimulatorDisplay {
 
         let event_pump = sdl_context.event_pump()?;
 
-        // RGB565 framebuffer (2 bytes per pixel)
-        let framebuffer = vec![0u8; (width * height * 2) as usize];
+        // Not tied to the creator's lifetime (`unsafe_textures`); destroyed
+        // in Drop before the canvas
+        let texture = canvas
+            .texture_creator()
+            .create_texture_streaming(PixelFormatEnum::RGB565, width, height)
+            .map_err(|e| e.to_string())?;
 
         Ok(Self {
             width,
             height,
             scale,
             canvas,
+            texture,
             event_pump,
-            framebuffer,
             mouse_x: 0,
             mouse_y: 0,
             mouse_pressed: false,
+            input_changed: false,
+            frame_dirty: false,
             quit_requested: false,
         })
     }
@@ -81,83 +100,112 @@ impl SimulatorDisplay {
         (self.mouse_x, self.mouse_y, self.mouse_pressed)
     }
 
+    /// True once after mouse input arrived (since the last call)
+    pub fn take_input_changed(&mut self) -> bool {
+        core::mem::take(&mut self.input_changed)
+    }
+
     /// Process SDL events (call this in your main loop)
     pub fn poll_events(&mut self) {
+        while let Some(event) = self.event_pump.poll_event() {
+            self.handle_event(event);
+        }
+    }
+
+    /// Block until an SDL event arrives or `timeout_ms` passes, then process
+    /// all pending events
+    ///
+    /// `None` waits without a deadline. Another thread can end the wait
+    /// with [`wake_from_any_thread`].
+    pub fn wait_events(&mut self, timeout_ms: Option<u32>) {
+        let event = match timeout_ms {
+            Some(ms) => self.event_pump.wait_event_timeout(ms),
+            None => Some(self.event_pump.wait_event()),
+        };
+        if let Some(event) = event {
+            self.handle_event(event);
+        }
+        self.poll_events();
+    }
+
+    fn handle_event(&mut self, event: sdl2::event::Event) {
         use sdl2::event::Event;
         use sdl2::mouse::MouseButton;
 
-        for event in self.event_pump.poll_iter() {
-            match event {
-                Event::Quit { .. } => {
-                    self.quit_requested = true;
-                }
-                Event::MouseMotion { x, y, .. } => {
-                    self.mouse_x = x / self.scale as i32;
-                    self.mouse_y = y / self.scale as i32;
-                }
-                Event::MouseButtonDown {
-                    mouse_btn: MouseButton::Left,
-                    x,
-                    y,
-                    ..
-                } => {
-                    self.mouse_x = x / self.scale as i32;
-                    self.mouse_y = y / self.scale as i32;
-                    self.mouse_pressed = true;
-                }
-                Event::MouseButtonUp {
-                    mouse_btn: MouseButton::Left,
-                    ..
-                } => {
-                    self.mouse_pressed = false;
-                }
-                _ => {}
+        match event {
+            Event::Quit { .. } => {
+                self.quit_requested = true;
+            }
+            Event::MouseMotion { x, y, .. } => {
+                self.mouse_x = x / self.scale as i32;
+                self.mouse_y = y / self.scale as i32;
+                self.input_changed = true;
             }
+            Event::MouseButtonDown {
+                mouse_btn: MouseButton::Left,
+                x,
+                y,
+                ..
+            } => {
+                self.mouse_x = x / self.scale as i32;
+                self.mouse_y = y / self.scale as i32;
+                self.mouse_pressed = true;
+                self.input_changed = true;
+            }
+            Event::MouseButtonUp {
+                mouse_btn: MouseButton::Left,
+                ..
+            } => {
+                self.mouse_pressed = false;
+                self.input_changed = true;
+            }
+            _ => {}
         }
     }
 
     /// Flush a region to the simulated display (for LVGL)
+    ///
+    /// `data` holds the area's RGB565 pixels with rows packed back to back.
     pub fn flush(&mut self, x1: i32, y1: i32, x2: i32, y2: i32, data: &[u8]) {
-        let width = (x2 - x1 + 1) as usize;
-        let height = (y2 - y1 + 1) as usize;
-
-        // Copy data to framebuffer
-        for row in 0..height {
-            let src_offset = row * width * 2;
-            let dst_y = y1 as usize + row;
-            let dst_offset = (dst_y * self.width as usize + x1 as usize) * 2;
-
-            if dst_offset + width * 2 <= self.framebuffer.len()
-                && src_offset + width * 2 <= data.len()
-            {
-                self.framebuffer[dst_offset..dst_offset + width * 2]
-                    .copy_from_slice(&data[src_offset..src_offset + width * 2]);
-            }
+        // Rows of `data` keep the full area's width even when it is clipped
+        let pitch = (x2 - x1 + 1).max(0) as usize * 2;
+        let rows = (y2 - y1 + 1).max(0) as usize;
+        if data.len() < pitch * rows {
+            return;
         }
-    }
 
-    /// Render the framebuffer to the window
-    pub fn render(&mut self) {
-        use sdl2::pixels::PixelFormatEnum;
-        use sdl2::rect::Rect;
+        let cx1 = x1.max(0);
+        let cy1 = y1.max(0);
+        let cx2 = x2.min(self.width as i32 - 1);
+        let cy2 = y2.min(self.height as i32 - 1);
+        if cx2 < cx1 || cy2 < cy1 {
+            return;
+        }
+        // Skip the clipped rows and columns at the top left
+        let offset = (cy1 - y1) as usize * pitch + (cx1 - x1) as usize * 2;
 
-        let texture_creator = self.canvas.texture_creator();
+        let rect = Rect::new(cx1, cy1, (cx2 - cx1 + 1) as u32, (cy2 - cy1 + 1) as u32);
+        self.texture
+            .update(Some(rect), &data[offset..], pitch)
+            .expect("Failed to update texture");
+        self.frame_dirty = true;
+    }
 
-        // Create texture from framebuffer
-        let mut texture = texture_creator
-            .create_texture_streaming(PixelFormatEnum::RGB565, self.width, self.height)
-            .expect("Failed to create texture");
+    /// Present the display if anything was flushed since the last render
+    pub fn render_if_dirty(&mut self) {
+        if self.frame_dirty {
+            self.render();
+        }
+    }
 
-        // Update texture with framebuffer data
-        texture
-            .update(None, &self.framebuffer, (self.width * 2) as usize)
-            .expect("Failed to update texture");
+    /// Present the display texture in the window
+    pub fn render(&mut self) {
+        self.frame_dirty = false;
 
-        // Clear and draw
         self.canvas.clear();
         self.canvas
             .copy(
-                &texture,
+                &self.texture,
                 None,
                 Some(Rect::new(
                     0,
@@ -172,15 +220,36 @@ impl SimulatorDisplay {
 
     /// Fill the entire display with a color (RGB565)
     pub fn clear(&mut self, color: u16) {
-        let hi = (color >> 8) as u8;
-        let lo = (color & 0xFF) as u8;
-        for i in (0..self.framebuffer.len()).step_by(2) {
-            self.framebuffer[i] = hi;
-            self.framebuffer[i + 1] = lo;
+        let row = color.to_ne_bytes().repeat(self.width as usize);
+        let pixels = row.repeat(self.height as usize);
+        self.texture
+            .update(None, &pixels, row.len())
+            .expect("Failed to update texture");
+        self.frame_dirty = true;
+    }
+}
+
+impl Drop for SimulatorDisplay {
+    fn drop(&mut self) {
+        // With `unsafe_textures` a texture has no Drop of its own; free it
+        // while the renderer in `canvas` is still alive
+        unsafe {
+            std::ptr::read(&self.texture).destroy();
         }
     }
 }
 
+/// End a [`SimulatorDisplay::wait_events`] from any thread
+///
+/// Pushes an empty user event; `SDL_PushEvent` is thread-safe.
+pub fn wake_from_any_thread() {
+    let mut event: sdl2::sys::SDL_Event = unsafe { core::mem::zeroed() };
+    event.type_ = sdl2::sys::SDL_EventType::SDL_USEREVENT as u32;
+    unsafe {
+        sdl2::sys::SDL_PushEvent(&mut event);
+    }
+}
+
 /// RGB565 color helpers
 pub mod color {
     pub const fn rgb565(r: u8, g: u8, b: u8) -> u16 {
@@ -26,6 +26,107 @@ fn main() {
 
     let target_os = env::var("CARGO_CFG_TARGET_OS").unwrap_or_default();
     let is_simulator = env::var("CARGO_FEATURE_SIMULATOR").is_ok();
+    let use_os = env::var("CARGO_FEATURE_OS").is_ok();
+    let use_png = env::var("CARGO_FEATURE_PNG").is_ok();
+    let use_jpeg = env::var("CARGO_FEATURE_JPEG").is_ok();
+    let use_image_compress = env::var("CARGO_FEATURE_IMAGE_COMPRESS").is_ok();
+    let use_mem_tlsf = env::var("CARGO_FEATURE_MEM_TLSF").is_ok();
+    let use_mem_rust = env::var("CARGO_FEATURE_MEM_RUST").is_ok();
+    let use_blend_accel = env::var("CARGO_FEATURE_BLEND_ACCEL").is_ok();
+    let use_font_loader = env::var("CARGO_FEATURE_FONT_LOADER").is_ok();
+    let use_tiny_ttf = env::var("CARGO_FEATURE_TINY_TTF").is_ok();
+    if use_mem_tlsf && use_mem_rust {
+        panic!("features `mem-tlsf` and `mem-rust` select different allocators; enable one");
+    }
+    // A custom lv_conf.h decides widgets, fonts, libraries and renderer
+    // itself; the simulator prefers its bundled config when present
+    let custom_conf = env::var("DEP_LV_CONFIG_PATH").is_ok()
+        && !(is_simulator && manifest_dir.join("lv_conf_simulator.h").exists());
+
+    // Config overrides passed to both the C build and bindgen
+    let mut defines: Vec<(&str, String)> = Vec::new();
+    if use_os {
+        // pthreads are available on desktop and on ESP-IDF
+        defines.push(("LV_USE_OS", "LV_OS_PTHREAD".into()));
+        defines.push(("LV_DRAW_SW_DRAW_UNIT_CNT", draw_unit_count().to_string()));
+    }
+    if use_png {
+        defines.push(("LV_USE_LODEPNG", "1".into()));
+    }
+    if use_jpeg {
+        defines.push(("LV_USE_TJPGD", "1".into()));
+    }
+    if use_jpeg || use_font_loader {
+        // TJPGD and lv_binfont_create_from_buffer read through the memory
+        // file system
+        defines.push(("LV_USE_FS_MEMFS", "1".into()));
+    }
+    if feature_enabled("FONT_COMPRESSED") {
+        defines.push(("LV_USE_FONT_COMPRESSED", "1".into()));
+    }
+    if use_tiny_ttf {
+        defines.push(("LV_USE_TINY_TTF", "1".into()));
+    }
+    if use_image_compress {
+        defines.push(("LV_USE_RLE", "1".into()));
+        defines.push(("LV_USE_LZ4_INTERNAL", "1".into()));
+    }
+    if let Some(size) = image_cache_size() {
+        defines.push(("LV_CACHE_DEF_SIZE", size.to_string()));
+    }
+    if use_mem_tlsf {
+        // LVGL's TLSF heap on its LV_MEM_SIZE pool, plus regions added at run time
+        defines.push(("LV_USE_STDLIB_MALLOC", "LV_STDLIB_BUILTIN".into()));
+        if let Some(size) = mem_size() {
+            defines.push(("LV_MEM_SIZE", format!("{}U", size)));
+        }
+    }
+    if use_mem_rust {
+        // lv_malloc_core and friends are implemented by the lvgl crate
+        defines.push(("LV_USE_STDLIB_MALLOC", "LV_STDLIB_CUSTOM".into()));
+    }
+
+    // Widgets, fonts, color depth and renderer from the features, replacing
+    // the fixed values the bundled lv_conf.h files used to have
+    let fonts: Vec<u32> = MONTSERRAT
+        .iter()
+        .filter(|&&(size, _)| montserrat_enabled(size))
+        .map(|&(size, _)| size)
+        .collect();
+    if !custom_conf {
+        for &(feature, define, _) in WIDGETS {
+            defines.push((define, flag(feature_enabled(feature))));
+        }
+        for &(size, define) in MONTSERRAT {
+            defines.push((define, flag(fonts.contains(&size))));
+        }
+        let default_font = if fonts.contains(&14) {
+            14
+        } else {
+            *fonts
+                .first()
+                .expect("enable at least one font-montserrat-* feature for LV_FONT_DEFAULT")
+        };
+        defines.push((
+            "LV_FONT_DEFAULT",
+            format!("&lv_font_montserrat_{}", default_font),
+        ));
+        defines.push(("LV_COLOR_DEPTH", color_depth().to_string()));
+        defines.push(("LV_DRAW_SW_COMPLEX", flag(feature_enabled("DRAW_COMPLEX"))));
+    }
+    if use_blend_accel && target_has_simd() {
+        // RGB565 fills and blends go to the kernels in the lvgl crate's blend.rs
+        defines.push(("LV_USE_DRAW_SW_ASM", "LV_DRAW_SW_ASM_CUSTOM".into()));
+        defines.push((
+            "LV_DRAW_SW_ASM_CUSTOM_INCLUDE",
+            "\"lv_blend_rust.h\"".into(),
+        ));
+    }
+    // No vector kernels from Rust on Xtensa; lv_blend_iram.c runs LVGL's
+    // RGB565 blend loops from IRAM instead
+    let use_blend_iram = use_blend_accel
+        && !target_has_simd()
+        && env::var("CARGO_CFG_TARGET_ARCH").as_deref() == Ok("xtensa");
 
     // Resolve LVGL source path (auto-downloads if needed)
     let lvgl_path = resolve_lvgl_path(&manifest_dir, &out_path);
@@ -61,14 +162,65 @@ fn main() {
     println!("cargo:rerun-if-changed=wrapper.h");
     println!("cargo:rerun-if-changed=lv_conf.h");
     println!("cargo:rerun-if-changed=lv_conf_simulator.h");
+    println!("cargo:rerun-if-changed=lv_blend_rust.h");
+    println!("cargo:rerun-if-changed=lv_blend_iram.c");
     println!("cargo:rerun-if-env-changed=LVGL_PATH");
     println!("cargo:rerun-if-env-changed=DEP_LV_CONFIG_PATH");
+    println!("cargo:rerun-if-env-changed=LVGL_DRAW_UNITS");
+    println!("cargo:rerun-if-env-changed=LVGL_IMAGE_CACHE_SIZE");
+    println!("cargo:rerun-if-env-changed=LVGL_MEM_SIZE");
+
+    // Collect LVGL source files, leaving out what the configuration disables.
+    // Those files compile to nothing anyway, but still cost a compiler run each
+    let src = lvgl_path.join("src");
+    let mut skipped: Vec<PathBuf> = Vec::new();
+    // A custom lv_conf.h may enable anything, so only trim for ours
+    if !custom_conf {
+        for &(feature, _, dir) in WIDGETS {
+            if !feature_enabled(feature) {
+                skipped.push(src.join("widgets").join(dir));
+            }
+        }
+        for &(size, _) in MONTSERRAT {
+            if !fonts.contains(&size) {
+                skipped.push(
+                    src.join("font")
+                        .join(format!("lv_font_montserrat_{}.c", size)),
+                );
+            }
+        }
+        let libs = [
+            ("lodepng", use_png),
+            ("tjpgd", use_jpeg),
+            ("lz4", use_image_compress),
+            ("rle", use_image_compress),
+            ("tiny_ttf", use_tiny_ttf),
+        ];
+        for (dir, enabled) in libs {
+            if !enabled {
+                skipped.push(src.join("libs").join(dir));
+            }
+        }
+        skipped.extend(UNUSED_FONTS.iter().map(|f| src.join("font").join(f)));
+        skipped.extend(UNUSED_LIBS.iter().map(|d| src.join("libs").join(d)));
+        skipped.extend(UNUSED_OTHERS.iter().map(|d| src.join("others").join(d)));
+        skipped.extend(UNUSED_DRAW_UNITS.iter().map(|d| src.join("draw").join(d)));
+        skipped.push(src.join("drivers"));
+    }
 
-    // Collect LVGL source files
-    let lvgl_sources: Vec<PathBuf> = glob::glob(&format!("{}/src/**/*.c", lvgl_path.display()))
+    if use_blend_iram {
+        // Compiled through lv_blend_iram.c instead
+        skipped.push(src.join("draw/sw/blend/lv_draw_sw_blend_to_rgb565.c"));
+    }
+
+    let mut lvgl_sources: Vec<PathBuf> = glob::glob(&format!("{}/src/**/*.c", lvgl_path.display()))
         .expect("Failed to glob LVGL sources")
         .filter_map(|e| e.ok())
+        .filter(|path| !skipped.iter().any(|skip| path.starts_with(skip)))
         .collect();
+    if use_blend_iram {
+        lvgl_sources.push(manifest_dir.join("lv_blend_iram.c"));
+    }
 
     if lvgl_sources.is_empty() {
         panic!(
@@ -88,6 +240,7 @@ fn main() {
         .include(&lvgl_path.join("src"))
         .include(&lv_conf_name)
         .include(&config_path)
+        .include(&manifest_dir)
         .define("LV_CONF_INCLUDE_SIMPLE", None)
         .warnings(false)
         .extra_warnings(false)
@@ -95,6 +248,10 @@ fn main() {
         .flag_if_supported("-Wno-missing-field-initializers")
         .flag_if_supported("-Wno-type-limits");
 
+    for (name, value) in &defines {
+        build.define(name, value.as_str());
+    }
+
     // Windows-specific
     if target_os == "windows" {
         build.flag_if_supported("/W0");
@@ -123,6 +280,10 @@ fn main() {
         .derive_default(true)
         .size_t_is_usize(true);
 
+    for (name, value) in &defines {
+        bindgen_builder = bindgen_builder.clang_arg(format!("-D{}={}", name, value));
+    }
+
     // Use core types unless building with simulator (std) feature
     if !is_simulator {
         bindgen_builder = bindgen_builder.use_core();
@@ -147,6 +308,182 @@ fn main() {
         .expect("Failed to write bindings");
 }
 
+/// Optional widgets as (feature, define, source directory under `src/widgets`)
+const WIDGETS: &[(&str, &str, &str)] = &[
+    ("WIDGET_ANIMIMG", "LV_USE_ANIMIMG", "animimage"),
+    ("WIDGET_ARC", "LV_USE_ARC", "arc"),
+    ("WIDGET_BAR", "LV_USE_BAR", "bar"),
+    ("WIDGET_BUTTON", "LV_USE_BUTTON", "button"),
+    ("WIDGET_BUTTONMATRIX", "LV_USE_BUTTONMATRIX", "buttonmatrix"),
+    ("WIDGET_CALENDAR", "LV_USE_CALENDAR", "calendar"),
+    ("WIDGET_CANVAS", "LV_USE_CANVAS", "canvas"),
+    ("WIDGET_CHART", "LV_USE_CHART", "chart"),
+    ("WIDGET_CHECKBOX", "LV_USE_CHECKBOX", "checkbox"),
+    ("WIDGET_DROPDOWN", "LV_USE_DROPDOWN", "dropdown"),
+    ("WIDGET_IMAGE", "LV_USE_IMAGE", "image"),
+    ("WIDGET_IMAGEBUTTON", "LV_USE_IMAGEBUTTON", "imagebutton"),
+    ("WIDGET_KEYBOARD", "LV_USE_KEYBOARD", "keyboard"),
+    ("WIDGET_LABEL", "LV_USE_LABEL", "label"),
+    ("WIDGET_LED", "LV_USE_LED", "led"),
+    ("WIDGET_LINE", "LV_USE_LINE", "line"),
+    ("WIDGET_LIST", "LV_USE_LIST", "list"),
+    ("WIDGET_MENU", "LV_USE_MENU", "menu"),
+    ("WIDGET_MSGBOX", "LV_USE_MSGBOX", "msgbox"),
+    ("WIDGET_ROLLER", "LV_USE_ROLLER", "roller"),
+    ("WIDGET_SCALE", "LV_USE_SCALE", "scale"),
+    ("WIDGET_SLIDER", "LV_USE_SLIDER", "slider"),
+    ("WIDGET_SPAN", "LV_USE_SPAN", "span"),
+    ("WIDGET_SPINBOX", "LV_USE_SPINBOX", "spinbox"),
+    ("WIDGET_SPINNER", "LV_USE_SPINNER", "spinner"),
+    ("WIDGET_SWITCH", "LV_USE_SWITCH", "switch"),
+    ("WIDGET_TABLE", "LV_USE_TABLE", "table"),
+    ("WIDGET_TABVIEW", "LV_USE_TABVIEW", "tabview"),
+    ("WIDGET_TEXTAREA", "LV_USE_TEXTAREA", "textarea"),
+    ("WIDGET_TILEVIEW", "LV_USE_TILEVIEW", "tileview"),
+    ("WIDGET_WIN", "LV_USE_WIN", "win"),
+];
+
+/// Built-in Montserrat sizes and their defines
+const MONTSERRAT: &[(u32, &str)] = &[
+    (8, "LV_FONT_MONTSERRAT_8"),
+    (10, "LV_FONT_MONTSERRAT_10"),
+    (12, "LV_FONT_MONTSERRAT_12"),
+    (14, "LV_FONT_MONTSERRAT_14"),
+    (16, "LV_FONT_MONTSERRAT_16"),
+    (18, "LV_FONT_MONTSERRAT_18"),
+    (20, "LV_FONT_MONTSERRAT_20"),
+    (22, "LV_FONT_MONTSERRAT_22"),
+    (24, "LV_FONT_MONTSERRAT_24"),
+    (26, "LV_FONT_MONTSERRAT_26"),
+    (28, "LV_FONT_MONTSERRAT_28"),
+    (30, "LV_FONT_MONTSERRAT_30"),
+    (32, "LV_FONT_MONTSERRAT_32"),
+    (34, "LV_FONT_MONTSERRAT_34"),
+    (36, "LV_FONT_MONTSERRAT_36"),
+    (38, "LV_FONT_MONTSERRAT_38"),
+    (40, "LV_FONT_MONTSERRAT_40"),
+    (42, "LV_FONT_MONTSERRAT_42"),
+    (44, "LV_FONT_MONTSERRAT_44"),
+    (46, "LV_FONT_MONTSERRAT_46"),
+    (48, "LV_FONT_MONTSERRAT_48"),
+];
+
+/// Built-in fonts the bundled configs never enable
+const UNUSED_FONTS: &[&str] = &[
+    "lv_font_montserrat_28_compressed.c",
+    "lv_font_dejavu_16_persian_hebrew.c",
+    "lv_font_simsun_14_cjk.c",
+    "lv_font_simsun_16_cjk.c",
+    "lv_font_source_han_sans_sc_14_cjk.c",
+    "lv_font_source_han_sans_sc_16_cjk.c",
+    "lv_font_unscii_8.c",
+    "lv_font_unscii_16.c",
+];
+
+/// Directories under `src/libs` the bundled configs never enable
+const UNUSED_LIBS: &[&str] = &[
+    "barcode",
+    "bmp",
+    "ffmpeg",
+    "freetype",
+    "gif",
+    "libjpeg_turbo",
+    "libpng",
+    "qrcode",
+    "rlottie",
+    "svg",
+    "thorvg",
+];
+
+/// Directories under `src/others` the bundled configs never enable
+const UNUSED_OTHERS: &[&str] = &[
+    "file_explorer",
+    "font_manager",
+    "fragment",
+    "gridnav",
+    "ime",
+    "imgfont",
+    "monkey",
+    "sysmon",
+    "test",
+    "vg_lite_tvg",
+];
+
+/// Draw units besides the software renderer, which is the only one configured
+const UNUSED_DRAW_UNITS: &[&str] = &[
+    "dma2d", "nema_gfx", "nxp", "opengles", "renesas", "sdl", "vg_lite",
+];
+
+/// True if the crate feature with the given env name (`WIDGET_ARC`) is on.
+fn feature_enabled(name: &str) -> bool {
+    env::var(format!("CARGO_FEATURE_{}", name)).is_ok()
+}
+
+/// True if the target has the vector units the blend kernels use
+fn target_has_simd() -> bool {
+    let arch = env::var("CARGO_CFG_TARGET_ARCH").unwrap_or_default();
+    let features = env::var("CARGO_CFG_TARGET_FEATURE").unwrap_or_default();
+    let has = |name: &str| features.split(',').any(|f| f == name);
+    match arch.as_str() {
+        "x86" | "x86_64" => has("sse2"),
+        "aarch64" => has("neon"),
+        _ => false,
+    }
+}
+
+fn montserrat_enabled(size: u32) -> bool {
+    feature_enabled(&format!("FONT_MONTSERRAT_{}", size))
+}
+
+/// `1` or `0` for a boolean config option.
+fn flag(enabled: bool) -> String {
+    if enabled { "1" } else { "0" }.into()
+}
+
+/// `LV_COLOR_DEPTH` from the `color-depth-*` features, 16 without any.
+fn color_depth() -> u32 {
+    let depths: Vec<u32> = [8, 24, 32]
+        .into_iter()
+        .filter(|depth| feature_enabled(&format!("COLOR_DEPTH_{}", depth)))
+        .collect();
+    match depths[..] {
+        [] => 16,
+        [depth] => depth,
+        _ => panic!("enable at most one color-depth-* feature, got {:?}", depths),
+    }
+}
+
+/// Number of software draw units for the `os` feature.
+///
+/// Defaults to 2 (one per core on ESP32-S3); override with `LVGL_DRAW_UNITS`.
+fn draw_unit_count() -> u32 {
+    match env::var("LVGL_DRAW_UNITS") {
+        Ok(v) => match v.trim().parse::<u32>() {
+            Ok(n) if n >= 1 => n,
+            _ => panic!("LVGL_DRAW_UNITS must be a positive integer, got {:?}", v),
+        },
+        Err(_) => 2,
+    }
+}
+
+/// Default image cache size in bytes from `LVGL_IMAGE_CACHE_SIZE`, if set.
+fn image_cache_size() -> Option<u32> {
+    let v = env::var("LVGL_IMAGE_CACHE_SIZE").ok()?;
+    match v.trim().parse::<u32>() {
+        Ok(n) => Some(n),
+        Err(_) => panic!("LVGL_IMAGE_CACHE_SIZE must be a size in bytes, got {:?}", v),
+    }
+}
+
+/// Builtin heap pool size in bytes from `LVGL_MEM_SIZE`, if set.
+fn mem_size() -> Option<u32> {
+    let v = env::var("LVGL_MEM_SIZE").ok()?;
+    match v.trim().parse::<u32>() {
+        Ok(n) if n >= 2048 => Some(n),
+        _ => panic!("LVGL_MEM_SIZE must be at least 2048 bytes, got {:?}", v),
+    }
+}
+
 /// Find the sysroot for a cross-compiler by querying the CC compiler.
 /// Uses the CC_<target> env var or falls back to common toolchain prefixes.
 fn find_cross_sysroot(target: &str) -> Option<String> {
@@ -0,0 +1,14 @@
+/**
+ * @file lv_blend_iram.c
+ * @brief LVGL's RGB565 blend loops placed in IRAM
+ *
+ * Compiled instead of lv_draw_sw_blend_to_rgb565.c when the `blend-accel`
+ * feature is enabled on Xtensa, where the Rust kernels of lv_blend_rust.h
+ * are not available. LV_ATTRIBUTE_FAST_MEM only changes for this file, so
+ * the rest of LVGL stays in flash and the IRAM cost is that of the RGB565
+ * blend functions alone.
+ */
+
+#define LV_ATTRIBUTE_FAST_MEM __attribute__((section(".iram1.lvgl_blend")))
+
+#include "src/draw/sw/blend/lv_draw_sw_blend_to_rgb565.c"
@@ -0,0 +1,28 @@
+/**
+ * @file lv_blend_rust.h
+ * @brief RGB565 blend hooks implemented by the lvgl crate (src/blend.rs)
+ *
+ * Included by LVGL's software blender as LV_DRAW_SW_ASM_CUSTOM_INCLUDE when
+ * the `blend-accel` feature is enabled. Each hook returns LV_RESULT_INVALID
+ * for cases it leaves to LVGL's C code.
+ */
+
+#ifndef LV_BLEND_RUST_H
+#define LV_BLEND_RUST_H
+
+#include "lvgl.h"
+
+lv_result_t lv_rust_blend_color_to_rgb565(const void * dsc);
+lv_result_t lv_rust_blend_color_to_rgb565_with_opa(const void * dsc);
+lv_result_t lv_rust_blend_rgb565_to_rgb565_with_opa(const void * dsc);
+
+#define LV_DRAW_SW_COLOR_BLEND_TO_RGB565(dsc) \
+    lv_rust_blend_color_to_rgb565((const void *)(dsc))
+
+#define LV_DRAW_SW_COLOR_BLEND_TO_RGB565_WITH_OPA(dsc) \
+    lv_rust_blend_color_to_rgb565_with_opa((const void *)(dsc))
+
+#define LV_DRAW_SW_RGB565_BLEND_NORMAL_TO_RGB565_WITH_OPA(dsc) \
+    lv_rust_blend_rgb565_to_rgb565_with_opa((const void *)(dsc))
+
+#endif /* LV_BLEND_RUST_H */
@@ -14,23 +14,44 @@
    COLOR SETTINGS
  *====================*/
 
-/* Color depth: 16 (RGB565) is best for most displays */
-#define LV_COLOR_DEPTH 16
+/* LV_COLOR_DEPTH is set by build.rs: 16 (RGB565, best for most displays),
+ * or 8/24/32 with the `color-depth-*` cargo features */
 
-/* Swap the 2 bytes of RGB565 color. Useful if display uses big-endian */
-#define LV_COLOR_16_SWAP 0
+/* LVGL 9 has no LV_COLOR_16_SWAP; big-endian panels use
+ * Display::set_byte_order(ByteOrder::Swapped) on the Rust side */
 
 /*====================
    MEMORY SETTINGS
  *====================*/
 
-/* Use system malloc (LVGL 9.x) */
+/* Use system malloc (LVGL 9.x). The `mem-tlsf` cargo feature selects
+ * LV_STDLIB_BUILTIN, `mem-rust` LV_STDLIB_CUSTOM (see src/mem.rs) */
+#ifndef LV_USE_STDLIB_MALLOC
 #define LV_USE_STDLIB_MALLOC    LV_STDLIB_CLIB
+#endif
 #define LV_USE_STDLIB_STRING    LV_STDLIB_CLIB
 #define LV_USE_STDLIB_SPRINTF   LV_STDLIB_CLIB
 
-/* Fallback pool size (only used if builtin allocator) */
+/* Builtin allocator pool size (LVGL_MEM_SIZE overrides it) */
+#ifndef LV_MEM_SIZE
 #define LV_MEM_SIZE (48 * 1024U)
+#endif
+
+/*====================
+   OPERATING SYSTEM
+ *====================*/
+
+/* OS abstraction for threaded rendering. The `os` cargo feature selects
+ * LV_OS_PTHREAD and sets the draw unit count (LVGL_DRAW_UNITS, default 2)
+ * from build.rs */
+#ifndef LV_USE_OS
+#define LV_USE_OS LV_OS_NONE
+#endif
+
+/* Number of parallel software render threads (needs LV_USE_OS) */
+#ifndef LV_DRAW_SW_DRAW_UNIT_CNT
+#define LV_DRAW_SW_DRAW_UNIT_CNT 1
+#endif
 
 /*====================
    HAL SETTINGS
@@ -42,12 +63,8 @@
 /* Default DPI (dots per inch) */
 #define LV_DPI_DEF 130
 
-/* Use a custom tick source (REQUIRED for ESP32) */
-#define LV_TICK_CUSTOM 1
-#if LV_TICK_CUSTOM
-    #define LV_TICK_CUSTOM_INCLUDE "esp_timer.h"
-    #define LV_TICK_CUSTOM_SYS_TIME_EXPR ((esp_timer_get_time() / 1000ULL))
-#endif
+/* Tick source: LVGL 9 has no LV_TICK_CUSTOM, register esp_timer_get_time()
+ * at runtime with lvgl::set_tick_source() (lv_tick_set_cb) */
 
 /*====================
    FEATURE CONFIG
@@ -77,33 +94,14 @@
    FONT CONFIG
  *====================*/
 
-/* Montserrat fonts - enable only what you need */
-#define LV_FONT_MONTSERRAT_8  0
-#define LV_FONT_MONTSERRAT_10 0
-#define LV_FONT_MONTSERRAT_12 1
-#define LV_FONT_MONTSERRAT_14 1
-#define LV_FONT_MONTSERRAT_16 1
-#define LV_FONT_MONTSERRAT_18 0
-#define LV_FONT_MONTSERRAT_20 0
-#define LV_FONT_MONTSERRAT_22 0
-#define LV_FONT_MONTSERRAT_24 0
-#define LV_FONT_MONTSERRAT_26 0
-#define LV_FONT_MONTSERRAT_28 0
-#define LV_FONT_MONTSERRAT_30 0
-#define LV_FONT_MONTSERRAT_32 0
-#define LV_FONT_MONTSERRAT_34 0
-#define LV_FONT_MONTSERRAT_36 0
-#define LV_FONT_MONTSERRAT_38 0
-#define LV_FONT_MONTSERRAT_40 0
-#define LV_FONT_MONTSERRAT_42 0
-#define LV_FONT_MONTSERRAT_44 0
-#define LV_FONT_MONTSERRAT_46 0
-#define LV_FONT_MONTSERRAT_48 0
-
-/* Default font */
-#define LV_FONT_DEFAULT &lv_font_montserrat_14
-
-/* Enable FreeType (disabled to save space) */
+/* The LV_FONT_MONTSERRAT_* sizes and LV_FONT_DEFAULT are set by build.rs
+ * from the `font-montserrat-*` cargo features (default 12, 14 and 16, with
+ * 14 as the default font) */
+
+/* LV_USE_FONT_COMPRESSED and LV_USE_TINY_TTF are set by build.rs from the
+ * `font-compressed` and `tiny-ttf` cargo features (see src/font.rs) */
+
+/* Enable FreeType (disabled to save space; needs an external libfreetype) */
 #define LV_USE_FREETYPE 0
 
 /*====================
@@ -122,42 +120,8 @@
    WIDGET CONFIG
  *====================*/
 
-/* Core widgets - enable what you need */
-#define LV_USE_ARC        1
-#define LV_USE_BAR        1
-#define LV_USE_BUTTON     1
-#define LV_USE_BUTTONMATRIX 1
-#define LV_USE_CANVAS     0  /* Needs large pixel buffer — enable if you have PSRAM */
-#define LV_USE_CHECKBOX   1
-#define LV_USE_DROPDOWN   1
-#define LV_USE_IMAGE      1
-#define LV_USE_LABEL      1
-#define LV_USE_LINE       1
-#define LV_USE_ROLLER     1
-#define LV_USE_SCALE      1
-#define LV_USE_SLIDER     1
-#define LV_USE_SWITCH     1
-#define LV_USE_TEXTAREA   1
-#define LV_USE_TABLE      1
-
-/* Extra widgets */
-#define LV_USE_ANIMIMG    0
-#define LV_USE_CALENDAR   1
-#define LV_USE_CHART      1
-#define LV_USE_COLORWHEEL 0
-#define LV_USE_IMGBTN     0
-#define LV_USE_KEYBOARD   1
-#define LV_USE_LED        1
-#define LV_USE_LIST       1
-#define LV_USE_MENU       1
-#define LV_USE_METER      1
-#define LV_USE_MSGBOX     1
-#define LV_USE_SPAN       0
-#define LV_USE_SPINBOX    1
-#define LV_USE_SPINNER    1
-#define LV_USE_TABVIEW    1
-#define LV_USE_TILEVIEW   1
-#define LV_USE_WIN        1
+/* LV_USE_<widget> is set by build.rs from the `widget-*` cargo features
+ * (`all-widgets` by default); sources of disabled widgets are not compiled */
 
 /*====================
    LAYOUTS
@@ -173,6 +137,14 @@
 /* Use SW renderer (no GPU) */
 #define LV_USE_DRAW_SW 1
 
+/* LV_DRAW_SW_COMPLEX (shadows, rounded corners, arcs, masks) is set by
+ * build.rs from the `draw-complex` cargo feature */
+
+/* `blend-accel` sets LV_USE_DRAW_SW_ASM to LV_DRAW_SW_ASM_CUSTOM with the
+ * Rust kernels of lv_blend_rust.h on SSE2/NEON targets. On Xtensa it builds
+ * the RGB565 blend loops through lv_blend_iram.c, which places only them in
+ * IRAM */
+
 /* Use ARM2D acceleration (for some ESP32 variants) */
 #define LV_USE_DRAW_ARM2D 0
 
@@ -189,14 +161,39 @@
 #define LV_USE_FS_POSIX 0
 #define LV_USE_FS_FATFS 0
 
-/* PNG decoder */
-#define LV_USE_PNG 0
+/* Memory "file system", lets TJPGD decode C arrays (set with `jpeg`) */
+#ifndef LV_USE_FS_MEMFS
+#define LV_USE_FS_MEMFS 0
+#endif
+#define LV_FS_MEMFS_LETTER 'M'
+
+/* Decoded image cache in bytes (0 = decode on every draw). Resize at runtime
+ * with lvgl::image::set_cache_size(); with CONFIG_SPIRAM_USE_MALLOC large
+ * decoded images land in PSRAM */
+#ifndef LV_CACHE_DEF_SIZE
+#define LV_CACHE_DEF_SIZE 0
+#endif
 
-/* BMP decoder */
+/* PNG decoder for in-memory PNGs (cargo feature `png`) */
+#ifndef LV_USE_LODEPNG
+#define LV_USE_LODEPNG 0
+#endif
+
+/* BMP decoder (files only) */
 #define LV_USE_BMP 0
 
-/* JPG decoder */
+/* JPG decoder (cargo feature `jpeg`) */
+#ifndef LV_USE_TJPGD
 #define LV_USE_TJPGD 0
+#endif
+
+/* RLE and LZ4 compressed images (cargo feature `image-compress`) */
+#ifndef LV_USE_RLE
+#define LV_USE_RLE 0
+#endif
+#ifndef LV_USE_LZ4_INTERNAL
+#define LV_USE_LZ4_INTERNAL 0
+#endif
 
 /* GIF decoder */
 #define LV_USE_GIF 0
@@ -205,7 +202,7 @@
 #define LV_USE_QRCODE 0
 
 /* Snapshot */
-#define LV_USE_SNAPSHOT 0
+#define LV_USE_SNAPSHOT 1  /* Used by lvgl::screen::ScreenCache */
 
 /*====================
    OTHERS
@@ -15,20 +15,37 @@
    COLOR SETTINGS
  *====================*/
 
-#define LV_COLOR_DEPTH 16
-#define LV_COLOR_16_SWAP 0
+/* LV_COLOR_DEPTH is set by build.rs: 16 (RGB565, best for most displays),
+ * or 8/24/32 with the `color-depth-*` cargo features */
 
 /*====================
    MEMORY SETTINGS
  *====================*/
 
-/* Use system malloc (LVGL 9.x) */
+/* Use system malloc (LVGL 9.x). The `mem-tlsf` cargo feature selects
+ * LV_STDLIB_BUILTIN, `mem-rust` LV_STDLIB_CUSTOM (see src/mem.rs) */
+#ifndef LV_USE_STDLIB_MALLOC
 #define LV_USE_STDLIB_MALLOC    LV_STDLIB_CLIB
+#endif
 #define LV_USE_STDLIB_STRING    LV_STDLIB_CLIB
 #define LV_USE_STDLIB_SPRINTF   LV_STDLIB_CLIB
 
-/* Fallback pool size (only used if builtin allocator) */
+/* Builtin allocator pool size (LVGL_MEM_SIZE overrides it) */
+#ifndef LV_MEM_SIZE
 #define LV_MEM_SIZE (512 * 1024U)
+#endif
+
+/*====================
+   OPERATING SYSTEM
+ *====================*/
+
+/* Set by build.rs with the `os` feature */
+#ifndef LV_USE_OS
+#define LV_USE_OS LV_OS_NONE
+#endif
+#ifndef LV_DRAW_SW_DRAW_UNIT_CNT
+#define LV_DRAW_SW_DRAW_UNIT_CNT 1
+#endif
 
 /*====================
    HAL SETTINGS
@@ -37,8 +54,7 @@
 #define LV_DEF_REFR_PERIOD 16  /* ~60 FPS */
 #define LV_DPI_DEF 130
 
-/* Use custom tick (provided by application) */
-#define LV_TICK_CUSTOM 0
+/* Tick source: registered at runtime with lvgl::set_tick_source() */
 
 /*====================
    FEATURE CONFIG
@@ -63,29 +79,12 @@
    FONT CONFIG
  *====================*/
 
-#define LV_FONT_MONTSERRAT_8  0
-#define LV_FONT_MONTSERRAT_10 0
-#define LV_FONT_MONTSERRAT_12 1
-#define LV_FONT_MONTSERRAT_14 1
-#define LV_FONT_MONTSERRAT_16 1
-#define LV_FONT_MONTSERRAT_18 0
-#define LV_FONT_MONTSERRAT_20 0
-#define LV_FONT_MONTSERRAT_22 0
-#define LV_FONT_MONTSERRAT_24 0
-#define LV_FONT_MONTSERRAT_26 0
-#define LV_FONT_MONTSERRAT_28 0
-#define LV_FONT_MONTSERRAT_30 0
-#define LV_FONT_MONTSERRAT_32 0
-#define LV_FONT_MONTSERRAT_34 0
-#define LV_FONT_MONTSERRAT_36 0
-#define LV_FONT_MONTSERRAT_38 0
-#define LV_FONT_MONTSERRAT_40 0
-#define LV_FONT_MONTSERRAT_42 0
-#define LV_FONT_MONTSERRAT_44 0
-#define LV_FONT_MONTSERRAT_46 0
-#define LV_FONT_MONTSERRAT_48 0
-
-#define LV_FONT_DEFAULT &lv_font_montserrat_14
+/* The LV_FONT_MONTSERRAT_* sizes and LV_FONT_DEFAULT are set by build.rs
+ * from the `font-montserrat-*` cargo features (default 12, 14 and 16, with
+ * 14 as the default font) */
+
+/* LV_USE_FONT_COMPRESSED and LV_USE_TINY_TTF are set by build.rs from the
+ * `font-compressed` and `tiny-ttf` cargo features (see src/font.rs) */
 
 #define LV_USE_FREETYPE 0
 
@@ -101,40 +100,8 @@
    WIDGET CONFIG
  *====================*/
 
-#define LV_USE_ARC        1
-#define LV_USE_BAR        1
-#define LV_USE_BUTTON     1
-#define LV_USE_BUTTONMATRIX 1
-#define LV_USE_CANVAS     1
-#define LV_USE_CHECKBOX   1
-#define LV_USE_DROPDOWN   1
-#define LV_USE_IMAGE      1
-#define LV_USE_LABEL      1
-#define LV_USE_LINE       1
-#define LV_USE_ROLLER     1
-#define LV_USE_SCALE      1
-#define LV_USE_SLIDER     1
-#define LV_USE_SWITCH     1
-#define LV_USE_TEXTAREA   1
-#define LV_USE_TABLE      1
-
-#define LV_USE_ANIMIMG    1
-#define LV_USE_CALENDAR   1
-#define LV_USE_CHART      1
-#define LV_USE_COLORWHEEL 1
-#define LV_USE_IMGBTN     1
-#define LV_USE_KEYBOARD   1
-#define LV_USE_LED        1
-#define LV_USE_LIST       1
-#define LV_USE_MENU       1
-#define LV_USE_METER      1
-#define LV_USE_MSGBOX     1
-#define LV_USE_SPAN       1
-#define LV_USE_SPINBOX    1
-#define LV_USE_SPINNER    1
-#define LV_USE_TABVIEW    1
-#define LV_USE_TILEVIEW   1
-#define LV_USE_WIN        1
+/* LV_USE_<widget> is set by build.rs from the `widget-*` cargo features
+ * (`all-widgets` by default); sources of disabled widgets are not compiled */
 
 /*====================
    LAYOUTS
@@ -148,6 +115,15 @@
  *====================*/
 
 #define LV_USE_DRAW_SW 1
+
+/* LV_DRAW_SW_COMPLEX (shadows, rounded corners, arcs, masks) is set by
+ * build.rs from the `draw-complex` cargo feature */
+
+/* `blend-accel` sets LV_USE_DRAW_SW_ASM to LV_DRAW_SW_ASM_CUSTOM with the
+ * Rust kernels of lv_blend_rust.h on SSE2/NEON targets. On Xtensa it builds
+ * the RGB565 blend loops through lv_blend_iram.c, which places only them in
+ * IRAM */
+
 #define LV_USE_DRAW_ARM2D 0
 #define LV_USE_DRAW_VG_LITE 0
 #define LV_USE_VECTOR_GRAPHIC 0
@@ -159,12 +135,31 @@
 #define LV_USE_FS_STDIO 0
 #define LV_USE_FS_POSIX 0
 #define LV_USE_FS_FATFS 0
-#define LV_USE_PNG 0
+
+/* Decoders and image cache; see lv_conf.h */
+#ifndef LV_USE_FS_MEMFS
+#define LV_USE_FS_MEMFS 0
+#endif
+#define LV_FS_MEMFS_LETTER 'M'
+#ifndef LV_CACHE_DEF_SIZE
+#define LV_CACHE_DEF_SIZE (8 * 1024 * 1024)
+#endif
+#ifndef LV_USE_LODEPNG
+#define LV_USE_LODEPNG 0
+#endif
 #define LV_USE_BMP 0
+#ifndef LV_USE_TJPGD
 #define LV_USE_TJPGD 0
+#endif
+#ifndef LV_USE_RLE
+#define LV_USE_RLE 0
+#endif
+#ifndef LV_USE_LZ4_INTERNAL
+#define LV_USE_LZ4_INTERNAL 0
+#endif
 #define LV_USE_GIF 0
 #define LV_USE_QRCODE 0
-#define LV_USE_SNAPSHOT 0
+#define LV_USE_SNAPSHOT 1  /* Used by lvgl::screen::ScreenCache */
 
 /*====================
    OTHERS
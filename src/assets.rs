@@ -0,0 +1,728 @@
+//! Read-only asset packs for images and fonts
+//!
+//! An asset pack is one blob with an index of named images and fonts. It is
+//! meant to be memory-mapped (an ESP32 flash partition, a file in the
+//! simulator), so changing assets does not need an app rebuild. Images and
+//! fonts are used straight from the mapping: only a small descriptor is built
+//! in RAM, when an asset is first looked up. Opening a pack reads just its
+//! header, so startup cost does not depend on the number of assets.
+//!
+//! ```ignore
+//! let pack = AssetPack::from_static(mapped)?.leak();
+//! if let Some(logo) = pack.image("logo") {
+//!     image.set_image(logo);
+//! }
+//! if let Some(font) = pack.font("digits_48") {
+//!     label.set_style_text_font(font, 0);
+//! }
+//! ```
+//!
+//! Packs are written with [`PackBuilder`] (`std` feature).
+//!
+//! # Format
+//!
+//! All integers are little-endian and every table starts 4-byte aligned:
+//!
+//! - header: `b"LVPK"`, version `u16`, entry count `u16`, total size `u32`,
+//!   glyph descriptor size `u16`, reserved `u16`
+//! - entries, sorted by name: name offset `u32`, name length `u16`,
+//!   kind `u16`, data offset `u32`, data size `u32`, info `[u32; 3]`
+//! - names and data
+//!
+//! For images the info words are the `lv_image_header_t`. A font's data is
+//! a font header followed by LVGL's `lv_font_fmt_txt` tables (glyph
+//! bitmaps, glyph descriptors, character maps and class kerning), with
+//! pointers replaced by offsets from the start of the font's data.
+
+use crate::display::ColorFormat;
+use crate::font::Font;
+use crate::image::{packed_stride, ImageDsc, COMPRESSED_HEADER};
+use crate::{LvglError, Result};
+use alloc::boxed::Box;
+use alloc::vec::Vec;
+use core::cell::UnsafeCell;
+use core::ffi::c_void;
+use core::mem;
+use lvgl_sys as sys;
+
+/// Pack magic
+const MAGIC: [u8; 4] = *b"LVPK";
+
+/// Format version written by [`PackBuilder`]
+const VERSION: u16 = 1;
+
+const HEADER_SIZE: usize = 16;
+const ENTRY_SIZE: usize = 28;
+const CMAP_SIZE: usize = 20;
+
+const KIND_IMAGE: u16 = 1;
+const KIND_FONT: u16 = 2;
+
+/// Font record at the start of a font's data
+///
+/// Offsets are relative to the start of the font's data; 0 means absent.
+#[derive(Clone, Copy, Debug, Default)]
+struct FontHeader {
+    line_height: i32,
+    base_line: i32,
+    glyph_count: u32,
+    bitmap: u32,
+    bitmap_len: u32,
+    glyph_dsc: u32,
+    cmaps: u32,
+    kern_values: u32,
+    kern_left: u32,
+    kern_right: u32,
+    cmap_num: u16,
+    kern_scale: u16,
+    bpp: u8,
+    subpx: u8,
+    underline_position: i8,
+    underline_thickness: i8,
+    left_class_cnt: u8,
+    right_class_cnt: u8,
+}
+
+/// Encoded size of [`FontHeader`]
+const FONT_HEADER_SIZE: usize = 52;
+
+impl FontHeader {
+    fn parse(data: &[u8]) -> Option<Self> {
+        Some(Self {
+            line_height: read_u32(data, 0)? as i32,
+            base_line: read_u32(data, 4)? as i32,
+            glyph_count: read_u32(data, 8)?,
+            bitmap: read_u32(data, 12)?,
+            bitmap_len: read_u32(data, 16)?,
+            glyph_dsc: read_u32(data, 20)?,
+            cmaps: read_u32(data, 24)?,
+            kern_values: read_u32(data, 28)?,
+            kern_left: read_u32(data, 32)?,
+            kern_right: read_u32(data, 36)?,
+            cmap_num: read_u16(data, 40)?,
+            kern_scale: read_u16(data, 42)?,
+            bpp: *data.get(44)?,
+            subpx: *data.get(45)?,
+            underline_position: *data.get(46)? as i8,
+            underline_thickness: *data.get(47)? as i8,
+            left_class_cnt: *data.get(48)?,
+            right_class_cnt: *data.get(49)?,
+        })
+    }
+}
+
+fn read_u16(data: &[u8], at: usize) -> Option<u16> {
+    let b = data.get(at..at + 2)?;
+    Some(u16::from_le_bytes([b[0], b[1]]))
+}
+
+fn read_u32(data: &[u8], at: usize) -> Option<u32> {
+    let b = data.get(at..at + 4)?;
+    Some(u32::from_le_bytes([b[0], b[1], b[2], b[3]]))
+}
+
+/// `len` bytes at `offset`, if in bounds and aligned to `align`
+fn table(data: &'static [u8], offset: u32, len: usize, align: usize) -> Option<&'static [u8]> {
+    let table = data.get(offset as usize..(offset as usize).checked_add(len)?)?;
+    (table.as_ptr() as usize % align == 0).then_some(table)
+}
+
+// =============================================================================
+// Loader
+// =============================================================================
+
+/// Descriptor built in RAM for an asset that has been looked up
+enum Loaded {
+    Image(Box<ImageDsc>),
+    Font(Box<MappedFont>),
+}
+
+/// A font whose tables live in the pack
+struct MappedFont {
+    font: sys::lv_font_t,
+    dsc: sys::lv_font_fmt_txt_dsc_t,
+    kern: sys::lv_font_fmt_txt_kern_classes_t,
+    cmaps: Box<[sys::lv_font_fmt_txt_cmap_t]>,
+}
+
+/// A memory-mapped asset pack
+pub struct AssetPack {
+    data: &'static [u8],
+    count: usize,
+    /// (entry index, descriptor) for assets looked up so far
+    loaded: UnsafeCell<Vec<(usize, Loaded)>>,
+}
+
+impl AssetPack {
+    /// Open a pack from mapped or embedded data
+    ///
+    /// Only the header and index bounds are checked here; each asset is
+    /// validated when it is first looked up.
+    pub fn from_static(data: &'static [u8]) -> Result<Self> {
+        if data.len() < HEADER_SIZE || data[..4] != MAGIC || data.as_ptr() as usize % 4 != 0 {
+            return Err(LvglError::InvalidParameter);
+        }
+        let version = read_u16(data, 4).unwrap_or(0);
+        let count = read_u16(data, 6).unwrap_or(0) as usize;
+        let size = read_u32(data, 8).unwrap_or(0) as usize;
+        let glyph_dsc_size = read_u16(data, 12).unwrap_or(0) as usize;
+        // A different glyph descriptor size means a different LV_FONT_FMT_TXT_LARGE
+        if version != VERSION
+            || size > data.len()
+            || HEADER_SIZE + count * ENTRY_SIZE > size
+            || glyph_dsc_size != mem::size_of::<sys::lv_font_fmt_txt_glyph_dsc_t>()
+        {
+            return Err(LvglError::InvalidParameter);
+        }
+        Ok(Self {
+            data: &data[..size],
+            count,
+            loaded: UnsafeCell::new(Vec::new()),
+        })
+    }
+
+    /// Keep the pack for the rest of the program
+    pub fn leak(self) -> &'static Self {
+        Box::leak(Box::new(self))
+    }
+
+    /// Number of assets
+    pub fn len(&self) -> usize {
+        self.count
+    }
+
+    /// True if the pack holds no assets
+    pub fn is_empty(&self) -> bool {
+        self.count == 0
+    }
+
+    /// Look up an image by name
+    pub fn image(&'static self, name: &str) -> Option<&'static ImageDsc> {
+        let index = self.find(name)?;
+        if let Some(Loaded::Image(image)) = self.loaded(index) {
+            return Some(image);
+        }
+        let (kind, data, info) = self.entry(index)?;
+        if kind != KIND_IMAGE || !check_image(info, data) {
+            return None;
+        }
+        let image = Box::new(ImageDsc::from_header(info, data));
+        let ptr: *const ImageDsc = &*image;
+        self.store(index, Loaded::Image(image));
+        Some(unsafe { &*ptr })
+    }
+
+    /// Look up a font by name
+    pub fn font(&'static self, name: &str) -> Option<&'static Font> {
+        let index = self.find(name)?;
+        if let Some(Loaded::Font(font)) = self.loaded(index) {
+            return Some(unsafe { Font::from_raw(&font.font) });
+        }
+        let (kind, data, _) = self.entry(index)?;
+        if kind != KIND_FONT {
+            return None;
+        }
+        let font = map_font(data)?;
+        let ptr: *const sys::lv_font_t = &font.font;
+        self.store(index, Loaded::Font(font));
+        Some(unsafe { Font::from_raw(ptr) })
+    }
+
+    /// Binary search the sorted index
+    fn find(&self, name: &str) -> Option<usize> {
+        let (mut lo, mut hi) = (0, self.count);
+        while lo < hi {
+            let mid = (lo + hi) / 2;
+            let at = HEADER_SIZE + mid * ENTRY_SIZE;
+            let off = read_u32(self.data, at)? as usize;
+            let len = read_u16(self.data, at + 4)? as usize;
+            let entry_name = self.data.get(off..off + len)?;
+            match entry_name.cmp(name.as_bytes()) {
+                core::cmp::Ordering::Less => lo = mid + 1,
+                core::cmp::Ordering::Greater => hi = mid,
+                core::cmp::Ordering::Equal => return Some(mid),
+            }
+        }
+        None
+    }
+
+    /// Kind, data and info words of entry `index`
+    fn entry(&self, index: usize) -> Option<(u16, &'static [u8], [u32; 3])> {
+        let at = HEADER_SIZE + index * ENTRY_SIZE;
+        let kind = read_u16(self.data, at + 6)?;
+        let offset = read_u32(self.data, at + 8)?;
+        let size = read_u32(self.data, at + 12)? as usize;
+        let info = [
+            read_u32(self.data, at + 16)?,
+            read_u32(self.data, at + 20)?,
+            read_u32(self.data, at + 24)?,
+        ];
+        Some((kind, table(self.data, offset, size, 4)?, info))
+    }
+
+    fn loaded(&self, index: usize) -> Option<&Loaded> {
+        let loaded = unsafe { &*self.loaded.get() };
+        loaded.iter().find(|(i, _)| *i == index).map(|(_, l)| l)
+    }
+
+    fn store(&self, index: usize, asset: Loaded) {
+        // Boxed, so references handed out stay valid as the list grows
+        unsafe { (*self.loaded.get()).push((index, asset)) }
+    }
+}
+
+/// Check an image header against the data it describes
+///
+/// LVGL trusts the header, so the pixels (or the decompressed size) must
+/// cover `palette + stride * h`.
+fn check_image(info: [u32; 3], data: &[u8]) -> bool {
+    let magic = info[0] & 0xff;
+    let cf = (info[0] >> 8) & 0xff;
+    let flags = info[0] >> 16;
+    let (w, h) = ((info[1] & 0xffff) as u16, (info[1] >> 16) as usize);
+    let stride = (info[2] & 0xffff) as usize;
+    if magic != sys::LV_IMAGE_HEADER_MAGIC {
+        return false;
+    }
+    // PNG or JPEG: the decoder reads size and format from the file
+    if cf == sys::LV_COLOR_FORMAT_RAW {
+        return flags == 0 && !data.is_empty();
+    }
+    let format = match ColorFormat::from_raw(cf) {
+        Some(format) => format,
+        None => return false,
+    };
+    if w == 0 || h == 0 || stride < packed_stride(w, format) {
+        return false;
+    }
+    let pixels = format.palette_size() + stride * h;
+    if flags == sys::LV_IMAGE_FLAGS_COMPRESSED {
+        // Method, compressed and decompressed size
+        let (Some(method), Some(compressed), Some(decompressed)) =
+            (read_u32(data, 0), read_u32(data, 4), read_u32(data, 8))
+        else {
+            return false;
+        };
+        matches!(method & 0x0f, 1 | 2)
+            && compressed as usize <= data.len() - COMPRESSED_HEADER
+            && decompressed as usize >= pixels
+    } else {
+        flags == 0 && data.len() >= pixels
+    }
+}
+
+/// Build the RAM descriptors of a font stored in `data`
+fn map_font(data: &'static [u8]) -> Option<Box<MappedFont>> {
+    let h = FontHeader::parse(data)?;
+    let glyphs = h.glyph_count as usize;
+    let glyph_dsc_size = mem::size_of::<sys::lv_font_fmt_txt_glyph_dsc_t>();
+    let bitmap = table(data, h.bitmap, h.bitmap_len as usize, 1)?;
+    let glyph_dsc = table(data, h.glyph_dsc, glyphs * glyph_dsc_size, 4)?;
+    if !matches!(h.bpp, 1 | 2 | 4 | 8) {
+        return None;
+    }
+
+    // Every glyph bitmap must be inside the bitmap table
+    let glyph_dsc: &'static [sys::lv_font_fmt_txt_glyph_dsc_t] =
+        unsafe { core::slice::from_raw_parts(glyph_dsc.as_ptr() as *const _, glyphs) };
+    for g in glyph_dsc {
+        let bits = g.box_w as usize * g.box_h as usize * h.bpp as usize;
+        if g.bitmap_index() as usize + (bits + 7) / 8 > bitmap.len() {
+            return None;
+        }
+    }
+
+    let mut cmaps = Vec::with_capacity(h.cmap_num as usize);
+    for i in 0..h.cmap_num as usize {
+        let at = (h.cmaps as usize).checked_add(i * CMAP_SIZE)?;
+        cmaps.push(map_cmap(data, at, glyphs)?);
+    }
+
+    let mut font = Box::new(MappedFont {
+        font: unsafe { mem::zeroed() },
+        dsc: unsafe { mem::zeroed() },
+        kern: unsafe { mem::zeroed() },
+        cmaps: cmaps.into_boxed_slice(),
+    });
+
+    font.dsc.glyph_bitmap = bitmap.as_ptr();
+    font.dsc.glyph_dsc = glyph_dsc.as_ptr();
+    font.dsc.kern_scale = h.kern_scale;
+    font.dsc.set_cmap_num(h.cmap_num as _);
+    font.dsc.set_bpp(h.bpp as _);
+    font.dsc.set_bitmap_format(sys::LV_FONT_FMT_TXT_PLAIN as _);
+    if h.kern_values != 0 {
+        let (l, r) = (h.left_class_cnt as usize, h.right_class_cnt as usize);
+        font.kern.class_pair_values = table(data, h.kern_values, l * r, 1)?.as_ptr() as *const i8;
+        font.kern.left_class_mapping = table(data, h.kern_left, glyphs, 1)?.as_ptr();
+        font.kern.right_class_mapping = table(data, h.kern_right, glyphs, 1)?.as_ptr();
+        font.kern.left_class_cnt = h.left_class_cnt;
+        font.kern.right_class_cnt = h.right_class_cnt;
+        let classes = |map: *const u8, cnt: u8| unsafe {
+            core::slice::from_raw_parts(map, glyphs)
+                .iter()
+                .all(|&c| c <= cnt)
+        };
+        if !classes(font.kern.left_class_mapping, h.left_class_cnt)
+            || !classes(font.kern.right_class_mapping, h.right_class_cnt)
+        {
+            return None;
+        }
+        font.dsc.set_kern_classes(1);
+        font.dsc.kern_dsc = &font.kern as *const _ as *const c_void;
+    }
+    // The box keeps these addresses stable
+    font.dsc.cmaps = font.cmaps.as_ptr();
+    font.font.dsc = &font.dsc as *const _ as *const c_void;
+
+    font.font.get_glyph_dsc = Some(sys::lv_font_get_glyph_dsc_fmt_txt);
+    font.font.get_glyph_bitmap = Some(sys::lv_font_get_bitmap_fmt_txt);
+    font.font.line_height = h.line_height;
+    font.font.base_line = h.base_line;
+    font.font.set_subpx(h.subpx as _);
+    font.font.underline_position = h.underline_position;
+    font.font.underline_thickness = h.underline_thickness;
+    Some(font)
+}
+
+/// Decode one character map record and check its lists
+fn map_cmap(data: &'static [u8], at: usize, glyphs: usize) -> Option<sys::lv_font_fmt_txt_cmap_t> {
+    let range_start = read_u32(data, at)?;
+    let range_length = read_u16(data, at + 4)?;
+    let glyph_id_start = read_u16(data, at + 6)?;
+    let unicode_list = read_u32(data, at + 8)?;
+    let ofs_list = read_u32(data, at + 12)?;
+    let list_length = read_u16(data, at + 16)?;
+    let kind = *data.get(at + 18)? as u32;
+
+    let (unicode_len, ofs_len, ofs_size, max_id) = match kind {
+        sys::LV_FONT_FMT_TXT_CMAP_FORMAT0_TINY => (0, 0, 1, range_length as usize),
+        sys::LV_FONT_FMT_TXT_CMAP_FORMAT0_FULL => (0, range_length as usize, 1, 0),
+        sys::LV_FONT_FMT_TXT_CMAP_SPARSE_TINY => (list_length as usize, 0, 1, list_length as usize),
+        sys::LV_FONT_FMT_TXT_CMAP_SPARSE_FULL => (list_length as usize, list_length as usize, 2, 0),
+        _ => return None,
+    };
+
+    let mut cmap: sys::lv_font_fmt_txt_cmap_t = unsafe { mem::zeroed() };
+    cmap.range_start = range_start;
+    cmap.range_length = range_length;
+    cmap.glyph_id_start = glyph_id_start;
+    cmap.list_length = list_length;
+    cmap.type_ = kind as _;
+    if unicode_len > 0 {
+        cmap.unicode_list = table(data, unicode_list, unicode_len * 2, 2)?.as_ptr() as *const u16;
+    }
+
+    // Largest glyph id the map can produce must exist
+    let mut last = glyph_id_start as usize + max_id;
+    if ofs_len > 0 {
+        let ofs = table(data, ofs_list, ofs_len * ofs_size, ofs_size)?;
+        let max_ofs = if ofs_size == 1 {
+            ofs.iter().map(|&o| o as usize).max()
+        } else {
+            ofs.chunks_exact(2)
+                .map(|o| u16::from_le_bytes([o[0], o[1]]) as usize)
+                .max()
+        };
+        last = glyph_id_start as usize + max_ofs.unwrap_or(0) + 1;
+        cmap.glyph_id_ofs_list = ofs.as_ptr() as *const c_void;
+    }
+    (last <= glyphs).then_some(cmap)
+}
+
+// =============================================================================
+// Builder
+// =============================================================================
+
+#[cfg(feature = "std")]
+pub use builder::PackBuilder;
+
+#[cfg(feature = "std")]
+mod builder {
+    use super::*;
+    use crate::image::header_words;
+    use alloc::string::String;
+
+    struct Asset {
+        name: String,
+        kind: u16,
+        info: [u32; 3],
+        data: Vec<u8>,
+    }
+
+    /// Writes asset packs, e.g. from a host-side build tool
+    #[derive(Default)]
+    pub struct PackBuilder {
+        assets: Vec<Asset>,
+    }
+
+    impl PackBuilder {
+        /// Create an empty pack
+        pub fn new() -> Self {
+            Self::default()
+        }
+
+        /// Add uncompressed pixels, rows packed without padding
+        pub fn add_raw_image(
+            &mut self,
+            name: &str,
+            width: u16,
+            height: u16,
+            format: ColorFormat,
+            data: &[u8],
+        ) -> Result<()> {
+            let stride = packed_stride(width, format);
+            if data.len() < format.palette_size() + stride * height as usize {
+                return Err(LvglError::InvalidParameter);
+            }
+            let info = header_words(format as u32, 0, width, height, stride as u16);
+            self.add(name, KIND_IMAGE, info, data.to_vec())
+        }
+
+        /// Add RLE or LZ4 compressed pixels with their compression header
+        pub fn add_compressed_image(
+            &mut self,
+            name: &str,
+            width: u16,
+            height: u16,
+            format: ColorFormat,
+            data: &[u8],
+        ) -> Result<()> {
+            if data.len() < 12 || !matches!(data[0] & 0x0f, 1 | 2) {
+                return Err(LvglError::InvalidParameter);
+            }
+            let stride = packed_stride(width, format) as u16;
+            let flags = sys::LV_IMAGE_FLAGS_COMPRESSED as u16;
+            let info = header_words(format as u32, flags, width, height, stride);
+            self.add(name, KIND_IMAGE, info, data.to_vec())
+        }
+
+        /// Add a PNG or JPEG file
+        pub fn add_encoded_image(&mut self, name: &str, data: &[u8]) -> Result<()> {
+            let info = header_words(sys::LV_COLOR_FORMAT_RAW, 0, 0, 0, 0);
+            self.add(name, KIND_IMAGE, info, data.to_vec())
+        }
+
+        /// Add a bitmap font, e.g. a C font from `lv_font_conv`
+        ///
+        /// Only uncompressed fonts (`--no-compress`) can be mapped; kerning
+        /// pairs are dropped, class kerning is kept.
+        ///
+        /// # Safety
+        /// `font` must be a valid `lv_font_fmt_txt` font.
+        pub unsafe fn add_font(&mut self, name: &str, font: &sys::lv_font_t) -> Result<()> {
+            if font.dsc.is_null() {
+                return Err(LvglError::InvalidParameter);
+            }
+            let dsc = &*(font.dsc as *const sys::lv_font_fmt_txt_dsc_t);
+            if dsc.bitmap_format() != sys::LV_FONT_FMT_TXT_PLAIN as _
+                || dsc.cmaps.is_null()
+                || dsc.glyph_dsc.is_null()
+                || dsc.glyph_bitmap.is_null()
+            {
+                return Err(LvglError::InvalidParameter);
+            }
+            let bpp = dsc.bpp() as usize;
+            let cmaps = core::slice::from_raw_parts(dsc.cmaps, dsc.cmap_num() as usize);
+
+            let glyphs = cmaps
+                .iter()
+                .map(|c| cmap_glyph_end(c))
+                .max()
+                .unwrap_or(1)
+                .max(1);
+            let glyph_dsc = core::slice::from_raw_parts(dsc.glyph_dsc, glyphs);
+            let bitmap_len = glyph_dsc
+                .iter()
+                .map(|g| {
+                    g.bitmap_index() as usize + (g.box_w as usize * g.box_h as usize * bpp + 7) / 8
+                })
+                .max()
+                .unwrap_or(0);
+
+            let mut h = FontHeader {
+                line_height: font.line_height,
+                base_line: font.base_line,
+                glyph_count: glyphs as u32,
+                cmap_num: cmaps.len() as u16,
+                kern_scale: dsc.kern_scale,
+                bpp: bpp as u8,
+                subpx: font.subpx() as u8,
+                underline_position: font.underline_position,
+                underline_thickness: font.underline_thickness,
+                ..Default::default()
+            };
+            let mut out = vec![0u8; FONT_HEADER_SIZE];
+
+            h.glyph_dsc = push(&mut out, bytes_of(glyph_dsc), 4);
+            h.bitmap = push(
+                &mut out,
+                core::slice::from_raw_parts(dsc.glyph_bitmap, bitmap_len),
+                4,
+            );
+            h.bitmap_len = bitmap_len as u32;
+            let mut records = Vec::new();
+            for c in cmaps {
+                let mut unicode_list = 0;
+                let mut ofs_list = 0;
+                if !c.unicode_list.is_null() {
+                    let list = core::slice::from_raw_parts(c.unicode_list, c.list_length as usize);
+                    unicode_list = push(&mut out, bytes_of(list), 4);
+                }
+                if !c.glyph_id_ofs_list.is_null() {
+                    let len = match c.type_ {
+                        sys::LV_FONT_FMT_TXT_CMAP_FORMAT0_FULL => c.range_length as usize,
+                        _ => c.list_length as usize * 2,
+                    };
+                    let list = core::slice::from_raw_parts(c.glyph_id_ofs_list as *const u8, len);
+                    ofs_list = push(&mut out, list, 4);
+                }
+                records.extend_from_slice(&c.range_start.to_le_bytes());
+                records.extend_from_slice(&c.range_length.to_le_bytes());
+                records.extend_from_slice(&c.glyph_id_start.to_le_bytes());
+                records.extend_from_slice(&unicode_list.to_le_bytes());
+                records.extend_from_slice(&ofs_list.to_le_bytes());
+                records.extend_from_slice(&c.list_length.to_le_bytes());
+                records.extend_from_slice(&[c.type_ as u8, 0]);
+            }
+            h.cmaps = push(&mut out, &records, 4);
+
+            if dsc.kern_classes() == 1 && !dsc.kern_dsc.is_null() {
+                let kern = &*(dsc.kern_dsc as *const sys::lv_font_fmt_txt_kern_classes_t);
+                let (l, r) = (kern.left_class_cnt as usize, kern.right_class_cnt as usize);
+                let values =
+                    core::slice::from_raw_parts(kern.class_pair_values as *const u8, l * r);
+                h.kern_values = push(&mut out, values, 4);
+                h.kern_left = push(
+                    &mut out,
+                    core::slice::from_raw_parts(kern.left_class_mapping, glyphs),
+                    4,
+                );
+                h.kern_right = push(
+                    &mut out,
+                    core::slice::from_raw_parts(kern.right_class_mapping, glyphs),
+                    4,
+                );
+                h.left_class_cnt = kern.left_class_cnt;
+                h.right_class_cnt = kern.right_class_cnt;
+            }
+
+            write_font_header(&mut out, &h);
+            self.add(name, KIND_FONT, [0; 3], out)
+        }
+
+        /// Serialize the pack
+        pub fn finish(mut self) -> Vec<u8> {
+            self.assets
+                .sort_by(|a, b| a.name.as_bytes().cmp(b.name.as_bytes()));
+            let mut out = Vec::new();
+            out.extend_from_slice(&MAGIC);
+            out.extend_from_slice(&VERSION.to_le_bytes());
+            out.extend_from_slice(&(self.assets.len() as u16).to_le_bytes());
+            out.extend_from_slice(&0u32.to_le_bytes());
+            let glyph_dsc_size = mem::size_of::<sys::lv_font_fmt_txt_glyph_dsc_t>() as u16;
+            out.extend_from_slice(&glyph_dsc_size.to_le_bytes());
+            out.extend_from_slice(&0u16.to_le_bytes());
+
+            let index = out.len();
+            out.resize(index + self.assets.len() * ENTRY_SIZE, 0);
+            for (i, asset) in self.assets.iter().enumerate() {
+                let name = push(&mut out, asset.name.as_bytes(), 1);
+                let data = push(&mut out, &asset.data, 4);
+                let at = index + i * ENTRY_SIZE;
+                out[at..at + 4].copy_from_slice(&name.to_le_bytes());
+                out[at + 4..at + 6].copy_from_slice(&(asset.name.len() as u16).to_le_bytes());
+                out[at + 6..at + 8].copy_from_slice(&asset.kind.to_le_bytes());
+                out[at + 8..at + 12].copy_from_slice(&data.to_le_bytes());
+                out[at + 12..at + 16].copy_from_slice(&(asset.data.len() as u32).to_le_bytes());
+                for (w, word) in asset.info.iter().enumerate() {
+                    out[at + 16 + w * 4..at + 20 + w * 4].copy_from_slice(&word.to_le_bytes());
+                }
+            }
+            let size = out.len() as u32;
+            out[8..12].copy_from_slice(&size.to_le_bytes());
+            out
+        }
+
+        fn add(&mut self, name: &str, kind: u16, info: [u32; 3], data: Vec<u8>) -> Result<()> {
+            if name.len() > u16::MAX as usize
+                || self.assets.len() == u16::MAX as usize
+                || self.assets.iter().any(|a| a.name == name)
+                // The loader would reject it
+                || (kind == KIND_IMAGE && !check_image(info, &data))
+            {
+                return Err(LvglError::InvalidParameter);
+            }
+            self.assets.push(Asset {
+                name: name.into(),
+                kind,
+                info,
+                data,
+            });
+            Ok(())
+        }
+    }
+
+    /// Append `bytes` aligned to `align`, returning their offset
+    fn push(out: &mut Vec<u8>, bytes: &[u8], align: usize) -> u32 {
+        while out.len() % align != 0 {
+            out.push(0);
+        }
+        let at = out.len() as u32;
+        out.extend_from_slice(bytes);
+        at
+    }
+
+    fn bytes_of<T>(items: &[T]) -> &[u8] {
+        unsafe { core::slice::from_raw_parts(items.as_ptr() as *const u8, mem::size_of_val(items)) }
+    }
+
+    /// One past the largest glyph id a character map refers to
+    unsafe fn cmap_glyph_end(c: &sys::lv_font_fmt_txt_cmap_t) -> usize {
+        let start = c.glyph_id_start as usize;
+        match c.type_ {
+            sys::LV_FONT_FMT_TXT_CMAP_FORMAT0_TINY => start + c.range_length as usize,
+            sys::LV_FONT_FMT_TXT_CMAP_SPARSE_TINY => start + c.list_length as usize,
+            sys::LV_FONT_FMT_TXT_CMAP_FORMAT0_FULL => {
+                let ofs = core::slice::from_raw_parts(
+                    c.glyph_id_ofs_list as *const u8,
+                    c.range_length as usize,
+                );
+                start + ofs.iter().map(|&o| o as usize + 1).max().unwrap_or(0)
+            }
+            _ => {
+                let ofs = core::slice::from_raw_parts(
+                    c.glyph_id_ofs_list as *const u16,
+                    c.list_length as usize,
+                );
+                start + ofs.iter().map(|&o| o as usize + 1).max().unwrap_or(0)
+            }
+        }
+    }
+
+    fn write_font_header(out: &mut [u8], h: &FontHeader) {
+        let words = [
+            h.line_height as u32,
+            h.base_line as u32,
+            h.glyph_count,
+            h.bitmap,
+            h.bitmap_len,
+            h.glyph_dsc,
+            h.cmaps,
+            h.kern_values,
+            h.kern_left,
+            h.kern_right,
+        ];
+        for (i, w) in words.iter().enumerate() {
+            out[i * 4..i * 4 + 4].copy_from_slice(&w.to_le_bytes());
+        }
+        out[40..42].copy_from_slice(&h.cmap_num.to_le_bytes());
+        out[42..44].copy_from_slice(&h.kern_scale.to_le_bytes());
+        out[44] = h.bpp;
+        out[45] = h.subpx;
+        out[46] = h.underline_position as u8;
+        out[47] = h.underline_thickness as u8;
+        out[48] = h.left_class_cnt;
+        out[49] = h.right_class_cnt;
+    }
+}
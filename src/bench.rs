@@ -0,0 +1,561 @@
+//! Render benchmark scenes
+//!
+//! A fixed set of scripted scenes, each redrawing part of the screen every
+//! frame, run on a [`Headless`] display in every [`RenderMode`]. The scenes
+//! follow LVGL's `lv_demo_benchmark` (rectangles, gradients, arcs, charts,
+//! text and layouts), rebuilt from this crate's widgets since the LVGL demos
+//! are not part of the build.
+//!
+//! ```ignore
+//! lvgl::init()?;
+//! let config = BenchConfig::new(320, 240, now_us);
+//! lvgl::bench::run(&config, |result| println!("{result}"))?;
+//! ```
+//!
+//! Times come from the caller's microsecond clock, so the same suite runs on
+//! the host (`cargo bench`) and on a device. Per scene it reports frames per
+//! second, render and flush time per frame, and the peak heap use above the
+//! level before the scene was built, if `heap_used` is set.
+
+use crate::display::{ColorFormat, RenderMode};
+use crate::headless::Headless;
+use crate::style::{GradDir, Style};
+use crate::widgets::{Arc, Chart, ChartAxis, ChartType, Label, LabelLongMode, List};
+use crate::{Color, LvglObj, Obj, Result};
+use alloc::boxed::Box;
+use alloc::vec::Vec;
+use core::ffi::CStr;
+use core::fmt::{self, Write};
+use lvgl_sys as sys;
+
+/// Virtual time per frame
+const FRAME_MS: u32 = 16;
+
+/// Largest LVGL coordinate (`LV_COORD_MAX`, not exported by bindgen)
+const COORD_MAX: i32 = (1 << 29) - 1;
+
+/// `LV_GRID_FR(1)`
+const GRID_FR_1: i32 = COORD_MAX - 100 + 1;
+
+/// `LV_GRID_TEMPLATE_LAST`
+const GRID_END: i32 = COORD_MAX;
+
+/// Called once per frame with the frame number
+pub type Animate = Box<dyn FnMut(u32)>;
+
+/// A benchmark scene
+pub struct Scene {
+    /// Short name for reports
+    pub name: &'static str,
+    /// Build the scene on an empty screen and return its per-frame update
+    pub build: fn(&Obj, u32, u32) -> Result<Animate>,
+}
+
+/// Every scene, in run order
+pub const SCENES: &[Scene] = &[
+    Scene {
+        name: "rectangles",
+        build: rectangles,
+    },
+    Scene {
+        name: "gradients",
+        build: gradients,
+    },
+    Scene {
+        name: "arcs",
+        build: arcs,
+    },
+    Scene {
+        name: "chart",
+        build: chart,
+    },
+    Scene {
+        name: "labels",
+        build: labels,
+    },
+    Scene {
+        name: "list_flex",
+        build: list_flex,
+    },
+    Scene {
+        name: "grid",
+        build: grid,
+    },
+];
+
+/// Render modes the suite runs every scene in
+pub const MODES: [RenderMode; 3] = [RenderMode::Partial, RenderMode::Full, RenderMode::Direct];
+
+/// Benchmark settings
+#[derive(Clone, Copy, Debug)]
+pub struct BenchConfig {
+    /// Horizontal resolution in pixels
+    pub width: u32,
+    /// Vertical resolution in pixels
+    pub height: u32,
+    /// Pixel format of the frame
+    pub format: ColorFormat,
+    /// Measured frames per scene
+    pub frames: u32,
+    /// Draw buffer height in `Partial` mode
+    pub partial_lines: u32,
+    /// Microsecond clock
+    pub now_us: fn() -> u64,
+    /// Bytes of heap in use, sampled after every frame
+    pub heap_used: Option<fn() -> usize>,
+}
+
+impl BenchConfig {
+    /// 120 native-format frames per scene, `Partial` buffers of 1/10 screen
+    pub fn new(width: u32, height: u32, now_us: fn() -> u64) -> Self {
+        Self {
+            width,
+            height,
+            format: ColorFormat::native(),
+            frames: 120,
+            partial_lines: (height / 10).max(1),
+            now_us,
+            heap_used: None,
+        }
+    }
+}
+
+/// Measurements of one scene in one render mode
+#[derive(Clone, Copy, Debug)]
+pub struct SceneResult {
+    /// Scene name
+    pub scene: &'static str,
+    /// Render mode of the display
+    pub mode: RenderMode,
+    /// Measured frames
+    pub frames: u32,
+    /// Building the scene and its first frame, in microseconds
+    pub setup_us: u64,
+    /// All measured frames, in microseconds
+    pub total_us: u64,
+    /// Part of `total_us` spent flushing
+    pub flush_us: u64,
+    /// Flushed pixels over all frames
+    pub pixels: u64,
+    /// Peak heap use above the level before setup
+    pub peak_heap: Option<usize>,
+}
+
+impl SceneResult {
+    /// Frames per second, if the renderer did nothing else
+    pub fn fps(&self) -> f32 {
+        if self.total_us == 0 {
+            return 0.0;
+        }
+        self.frames as f32 * 1_000_000.0 / self.total_us as f32
+    }
+
+    /// Average render time per frame in milliseconds, flushing excluded
+    pub fn render_ms(&self) -> f32 {
+        self.per_frame_ms(self.total_us.saturating_sub(self.flush_us))
+    }
+
+    /// Average flush time per frame in milliseconds
+    pub fn flush_ms(&self) -> f32 {
+        self.per_frame_ms(self.flush_us)
+    }
+
+    fn per_frame_ms(&self, us: u64) -> f32 {
+        us as f32 / 1000.0 / self.frames.max(1) as f32
+    }
+}
+
+impl fmt::Display for SceneResult {
+    /// One report row; see [`HEADER`]
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        write!(
+            f,
+            "{:<12} {:<8} {:>8.1} {:>9.3} {:>9.3} {:>9.2} {:>10}",
+            self.scene,
+            mode_name(self.mode),
+            self.fps(),
+            self.render_ms(),
+            self.flush_ms(),
+            self.setup_us as f32 / 1000.0,
+            self.pixels / self.frames.max(1) as u64,
+        )?;
+        match self.peak_heap {
+            Some(bytes) => write!(f, " {:>10}", bytes),
+            None => write!(f, " {:>10}", "-"),
+        }
+    }
+}
+
+/// Column titles for [`SceneResult`] rows
+pub const HEADER: &str =
+    "scene        mode          fps render_ms  flush_ms  setup_ms  px/frame  peak_heap";
+
+/// Short name of a render mode
+pub fn mode_name(mode: RenderMode) -> &'static str {
+    match mode {
+        RenderMode::Partial => "partial",
+        RenderMode::Full => "full",
+        RenderMode::Direct => "direct",
+    }
+}
+
+/// Run every scene in every render mode and report each result
+///
+/// Call after [`init`](crate::init). Each mode gets its own [`Headless`]
+/// display, deleted when the mode is done; the virtual clock stays LVGL's
+/// tick source afterwards.
+pub fn run(config: &BenchConfig, mut report: impl FnMut(&SceneResult)) -> Result<()> {
+    for mode in MODES {
+        let lines = match mode {
+            RenderMode::Partial => config.partial_lines,
+            _ => 0,
+        };
+        let hl = Headless::with_mode(config.width, config.height, config.format, mode, lines)?;
+        hl.set_flush_clock(config.now_us);
+        for scene in SCENES {
+            report(&run_scene(&hl, scene, config)?);
+        }
+    }
+    Ok(())
+}
+
+/// Run one scene on `hl` on a screen of its own
+pub fn run_scene(hl: &Headless, scene: &Scene, config: &BenchConfig) -> Result<SceneResult> {
+    let now = config.now_us;
+    let heap_base = config.heap_used.map(|used| used());
+    let mut peak = heap_base;
+    let sample = |peak: &mut Option<usize>| {
+        if let (Some(used), Some(peak)) = (config.heap_used, peak.as_mut()) {
+            *peak = (*peak).max(used());
+        }
+    };
+
+    // Declared before the screen so it is dropped after it: the closure
+    // owns styles the scene's objects still point at
+    let mut animate;
+    let screen = SceneScreen {
+        previous: crate::screen_active(),
+        screen: crate::screen_create()?,
+    };
+    let start = now();
+    animate = (scene.build)(&screen.screen, config.width, config.height)?;
+    crate::screen_load(&screen.screen);
+    hl.refresh();
+    let setup_us = now() - start;
+    sample(&mut peak);
+    hl.take_stats();
+
+    let start = now();
+    for frame in 0..config.frames {
+        animate(frame);
+        hl.step(FRAME_MS);
+        hl.refresh();
+        sample(&mut peak);
+    }
+    let total_us = now() - start;
+    let stats = hl.take_stats();
+
+    Ok(SceneResult {
+        scene: scene.name,
+        mode: hl.render_mode(),
+        frames: config.frames,
+        setup_us,
+        total_us,
+        flush_us: stats.flush_us,
+        pixels: stats.pixels,
+        peak_heap: peak
+            .zip(heap_base)
+            .map(|(peak, base)| peak.saturating_sub(base)),
+    })
+}
+
+/// A scene's screen, deleted on drop after the previous screen is reloaded
+struct SceneScreen {
+    screen: Obj,
+    previous: Option<Obj>,
+}
+
+impl Drop for SceneScreen {
+    fn drop(&mut self) {
+        if let Some(previous) = &self.previous {
+            crate::screen_load(previous);
+        }
+        self.screen.delete();
+    }
+}
+
+// =============================================================================
+// Scenes
+// =============================================================================
+
+/// Small linear congruential generator, so every run draws the same frames
+struct Lcg(u32);
+
+impl Lcg {
+    fn next(&mut self, bound: u32) -> u32 {
+        self.0 = self.0.wrapping_mul(1_103_515_245).wrapping_add(12_345);
+        (self.0 >> 16) % bound.max(1)
+    }
+}
+
+fn palette(i: u32) -> Color {
+    const COLORS: [u32; 6] = [0xe53935, 0x8e24aa, 0x1e88e5, 0x00897b, 0xfdd835, 0xfb8c00];
+    Color::hex(COLORS[i as usize % COLORS.len()])
+}
+
+fn remove_scrolling(obj: &impl LvglObj) {
+    unsafe { sys::lv_obj_remove_flag(obj.raw(), sys::LV_OBJ_FLAG_SCROLLABLE) }
+}
+
+/// Rounded rectangles with border and shadow, moved every frame
+///
+/// The style is attached once every object exists, so a failed build drops
+/// it while nothing points at it.
+fn rectangles(screen: &Obj, width: u32, height: u32) -> Result<Animate> {
+    let size = (width.min(height) / 5).max(8) as i32;
+    let mut rects = Vec::new();
+    for _ in 0..16 {
+        rects.push(Obj::create(screen)?);
+    }
+
+    let mut style = Box::new(Style::new());
+    style.set_radius(8);
+    style.set_border_width(2);
+    style.set_shadow_width(12);
+    style.set_shadow_opa(128);
+    for (i, rect) in rects.iter().enumerate() {
+        let i = i as u32;
+        rect.add_style(&style, 0);
+        rect.set_size(size, size);
+        rect.set_style_bg_color(palette(i), 0);
+        remove_scrolling(rect);
+    }
+
+    let mut rng = Lcg(1);
+    let (w, h) = (width - size as u32, height - size as u32);
+    Ok(Box::new(move |_| {
+        let _style = &style;
+        for rect in &rects {
+            rect.set_pos(rng.next(w) as i32, rng.next(h) as i32);
+        }
+    }))
+}
+
+/// Full-width vertical and horizontal gradient bands, recolored every frame
+///
+/// Styles are attached after the objects exist, as in [`rectangles`].
+fn gradients(screen: &Obj, width: u32, height: u32) -> Result<Animate> {
+    let mut bands = Vec::new();
+    for _ in 0..4 {
+        bands.push(Obj::create(screen)?);
+    }
+
+    let mut vertical = Box::new(Style::new());
+    vertical.set_bg_grad_color(Color::black());
+    vertical.set_bg_grad_dir(GradDir::Vertical);
+    vertical.set_radius(0);
+    let mut horizontal = Box::new(Style::new());
+    horizontal.set_bg_grad_color(Color::white());
+    horizontal.set_bg_grad_dir(GradDir::Horizontal);
+    horizontal.set_radius(0);
+
+    let band = (height / 4) as i32;
+    for (i, obj) in bands.iter().enumerate() {
+        let i = i as i32;
+        obj.add_style(if i % 2 == 0 { &vertical } else { &horizontal }, 0);
+        obj.set_style_border_width(0, 0);
+        obj.set_pos(0, i * band);
+        obj.set_size(width as i32, band);
+        remove_scrolling(obj);
+    }
+
+    Ok(Box::new(move |frame| {
+        let _styles = (&vertical, &horizontal);
+        for (i, band) in bands.iter().enumerate() {
+            band.set_style_bg_color(palette(frame + i as u32), 0);
+        }
+    }))
+}
+
+/// A grid of arcs whose values change every frame
+fn arcs(screen: &Obj, width: u32, height: u32) -> Result<Animate> {
+    let (cols, rows) = (4, 2);
+    let size = (width / cols).min(height / rows) as i32 - 8;
+    let mut arcs = Vec::new();
+    for i in 0..cols * rows {
+        let arc = Arc::create(screen)?;
+        arc.set_size(size, size);
+        arc.set_pos(
+            (i % cols * width / cols) as i32 + 4,
+            (i / cols * height / rows) as i32 + 4,
+        );
+        arc.set_range(0, 100);
+        arc.set_rotation(i as i32 * 45);
+        arcs.push(arc);
+    }
+
+    Ok(Box::new(move |frame| {
+        for (i, arc) in arcs.iter().enumerate() {
+            arc.set_value(((frame * 3 + i as u32 * 13) % 101) as i32);
+        }
+    }))
+}
+
+/// A full-screen line chart with two series, one new point per frame
+fn chart(screen: &Obj, width: u32, height: u32) -> Result<Animate> {
+    let chart = Chart::create(screen)?;
+    chart.set_size(width as i32, height as i32);
+    chart.set_type(ChartType::Line);
+    chart.set_point_count(100);
+    chart.set_range(ChartAxis::PrimaryY, 0, 100);
+    chart.set_div_line_count(5, 8);
+    let series = [
+        chart.add_series(palette(0), ChartAxis::PrimaryY),
+        chart.add_series(palette(2), ChartAxis::PrimaryY),
+    ];
+
+    let mut rng = Lcg(7);
+    Ok(Box::new(move |_| {
+        for s in &series {
+            chart.set_next_value(s, rng.next(101) as i32);
+        }
+    }))
+}
+
+const PARAGRAPHS: [&CStr; 3] = [
+    c"Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore et dolore magna aliqua.",
+    c"Ut enim ad minim veniam, quis nostrud exercitation ullamco laboris nisi ut aliquip ex ea commodo consequat.",
+    c"Duis aute irure dolor in reprehenderit in voluptate velit esse cillum dolore eu fugiat nulla pariatur.",
+];
+
+/// Wrapped paragraphs whose text is replaced every frame (text layout)
+fn labels(screen: &Obj, width: u32, height: u32) -> Result<Animate> {
+    let rows = 6;
+    let mut labels = Vec::new();
+    for i in 0..rows {
+        let label = Label::create(screen)?;
+        label.set_long_mode(LabelLongMode::Wrap);
+        label.set_width(width as i32 - 8);
+        label.set_pos(4, (i * height / rows) as i32);
+        label.set_text_color(palette(i));
+        labels.push(label);
+    }
+
+    Ok(Box::new(move |frame| {
+        for (i, label) in labels.iter().enumerate() {
+            label.set_text(PARAGRAPHS[(frame as usize + i) % PARAGRAPHS.len()]);
+        }
+    }))
+}
+
+/// A 100-button list (flex column) scrolled a few pixels every frame
+fn list_flex(screen: &Obj, width: u32, height: u32) -> Result<Animate> {
+    let list = List::create(screen)?;
+    list.set_size(width as i32, height as i32);
+    let mut text = TextBuf::new();
+    for i in 0..100 {
+        text.clear();
+        let _ = write!(text, "Item {}", i);
+        list.add_button(core::ptr::null(), text.as_c_str());
+    }
+
+    let mut step = 7;
+    Ok(Box::new(move |_| unsafe {
+        let raw = list.raw();
+        let top = sys::lv_obj_get_scroll_top(raw);
+        let bottom = sys::lv_obj_get_scroll_bottom(raw);
+        if (step > 0 && bottom <= 0) || (step < 0 && top <= 0) {
+            step = -step;
+        }
+        sys::lv_obj_scroll_by(raw, 0, -step, sys::LV_ANIM_OFF);
+    }))
+}
+
+static GRID_COLS: [i32; 7] = [
+    GRID_FR_1, GRID_FR_1, GRID_FR_1, GRID_FR_1, GRID_FR_1, GRID_FR_1, GRID_END,
+];
+static GRID_ROWS: [i32; 9] = [
+    GRID_FR_1, GRID_FR_1, GRID_FR_1, GRID_FR_1, GRID_FR_1, GRID_FR_1, GRID_FR_1, GRID_FR_1,
+    GRID_END,
+];
+
+/// A 6 x 8 grid of labelled cells, resized every frame (grid relayout)
+fn grid(screen: &Obj, width: u32, height: u32) -> Result<Animate> {
+    let cont = Obj::create(screen)?;
+    cont.set_size(width as i32, height as i32);
+    cont.set_style_pad_all(2, 0);
+    remove_scrolling(&cont);
+    unsafe {
+        sys::lv_obj_set_grid_dsc_array(cont.raw(), GRID_COLS.as_ptr(), GRID_ROWS.as_ptr());
+    }
+
+    let mut text = TextBuf::new();
+    for i in 0..48u32 {
+        let cell = Obj::create(&cont)?;
+        cell.set_style_pad_all(0, 0);
+        remove_scrolling(&cell);
+        unsafe {
+            sys::lv_obj_set_grid_cell(
+                cell.raw(),
+                sys::LV_GRID_ALIGN_STRETCH,
+                (i % 6) as i32,
+                1,
+                sys::LV_GRID_ALIGN_STRETCH,
+                (i / 6) as i32,
+                1,
+            );
+        }
+        let label = Label::create(&cell)?;
+        text.clear();
+        let _ = write!(text, "{}", i);
+        label.set_text(text.as_c_str());
+        label.center();
+    }
+
+    let min_width = width as i32 * 2 / 3;
+    let span = width as i32 - min_width;
+    Ok(Box::new(move |frame| {
+        // Triangle wave between min_width and the full width
+        let phase = (frame as i32 * 4) % (2 * span.max(1));
+        let grow = if phase < span {
+            phase
+        } else {
+            2 * span - phase
+        };
+        cont.set_width(min_width + grow);
+    }))
+}
+
+/// Short NUL-terminated text built with `write!`
+struct TextBuf {
+    buf: [u8; 16],
+    len: usize,
+}
+
+impl TextBuf {
+    fn new() -> Self {
+        Self {
+            buf: [0; 16],
+            len: 0,
+        }
+    }
+
+    fn clear(&mut self) {
+        self.len = 0;
+    }
+
+    fn as_c_str(&mut self) -> &CStr {
+        self.buf[self.len] = 0;
+        CStr::from_bytes_until_nul(&self.buf[..=self.len]).unwrap_or(c"")
+    }
+}
+
+impl Write for TextBuf {
+    fn write_str(&mut self, s: &str) -> fmt::Result {
+        let room = self.buf.len() - 1 - self.len;
+        let n = s.len().min(room);
+        self.buf[self.len..self.len + n].copy_from_slice(&s.as_bytes()[..n]);
+        self.len += n;
+        Ok(())
+    }
+}
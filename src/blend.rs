@@ -0,0 +1,349 @@
+//! Vectorized RGB565 blend kernels for LVGL's software renderer
+//!
+//! With the `blend-accel` feature LVGL's RGB565 blender hands these cases to
+//! the kernels here, through its `LV_DRAW_SW_ASM_CUSTOM` hooks:
+//!
+//! - solid fills,
+//! - translucent fills, the cost behind large semi-transparent panels,
+//! - RGB565 images drawn with an opacity.
+//!
+//! They process 8 pixels at a time with SSE2 on x86 and NEON on aarch64.
+//! Masked blends, other formats and other targets stay on LVGL's C code;
+//! on Xtensa (ESP32-S3) the feature places that code in IRAM instead.
+//!
+//! Results are bit-identical to LVGL's own blending, so the kernels can be
+//! switched off at run time to compare frame times:
+//!
+//! ```ignore
+//! lvgl::blend::set_enabled(false);
+//! lvgl::bench::run(&config, |result| log::info!("C:    {}", result));
+//! lvgl::blend::set_enabled(true);
+//! lvgl::bench::run(&config, |result| log::info!("SIMD: {}", result));
+//! ```
+
+use core::sync::atomic::{AtomicBool, Ordering};
+
+/// Instruction set of the kernels on this target, `"c"` if LVGL's C code runs
+pub const BACKEND: &str = if cfg!(all(
+    any(target_arch = "x86", target_arch = "x86_64"),
+    target_feature = "sse2"
+)) {
+    "sse2"
+} else if cfg!(all(target_arch = "aarch64", target_feature = "neon")) {
+    "neon"
+} else {
+    "c"
+};
+
+static ENABLED: AtomicBool = AtomicBool::new(true);
+
+/// Use the kernels (the default) or LVGL's C blending
+pub fn set_enabled(enabled: bool) {
+    ENABLED.store(enabled, Ordering::Relaxed);
+}
+
+/// True if the kernels are used
+pub fn is_enabled() -> bool {
+    BACKEND != "c" && ENABLED.load(Ordering::Relaxed)
+}
+
+#[cfg(any(
+    all(
+        any(target_arch = "x86", target_arch = "x86_64"),
+        target_feature = "sse2"
+    ),
+    all(target_arch = "aarch64", target_feature = "neon")
+))]
+pub use self::hooks::*;
+
+/// Reference the hooks from [`init`](crate::init), so the linker keeps them
+/// for LVGL's static library
+pub(crate) fn keep_hooks() {
+    #[cfg(any(
+        all(
+            any(target_arch = "x86", target_arch = "x86_64"),
+            target_feature = "sse2"
+        ),
+        all(target_arch = "aarch64", target_feature = "neon")
+    ))]
+    core::hint::black_box([
+        lv_rust_blend_color_to_rgb565 as *const (),
+        lv_rust_blend_color_to_rgb565_with_opa as *const (),
+        lv_rust_blend_rgb565_to_rgb565_with_opa as *const (),
+    ]);
+}
+
+// =============================================================================
+// Hooks
+// =============================================================================
+
+#[cfg(any(
+    all(
+        any(target_arch = "x86", target_arch = "x86_64"),
+        target_feature = "sse2"
+    ),
+    all(target_arch = "aarch64", target_feature = "neon")
+))]
+mod hooks {
+    use super::{simd, ENABLED};
+    use core::ffi::c_void;
+    use core::slice;
+    use core::sync::atomic::Ordering;
+    use lvgl_sys as sys;
+
+    /// `lv_draw_sw_blend_fill_dsc_t` (LVGL 9.2, `lv_draw_sw_blend_private.h`)
+    #[doc(hidden)]
+    #[repr(C)]
+    pub struct FillDsc {
+        dest_buf: *mut c_void,
+        dest_w: i32,
+        dest_h: i32,
+        dest_stride: i32,
+        mask_buf: *const sys::lv_opa_t,
+        mask_stride: i32,
+        color: sys::lv_color_t,
+        opa: sys::lv_opa_t,
+        relative_area: sys::lv_area_t,
+    }
+
+    /// `lv_draw_sw_blend_image_dsc_t` (LVGL 9.2, `lv_draw_sw_blend_private.h`)
+    #[doc(hidden)]
+    #[repr(C)]
+    pub struct BlitDsc {
+        dest_buf: *mut c_void,
+        dest_w: i32,
+        dest_h: i32,
+        dest_stride: i32,
+        mask_buf: *const sys::lv_opa_t,
+        mask_stride: i32,
+        src_buf: *const c_void,
+        src_stride: i32,
+        src_color_format: sys::lv_color_format_t,
+        opa: sys::lv_opa_t,
+        blend_mode: sys::lv_blend_mode_t,
+        relative_area: sys::lv_area_t,
+        src_area: sys::lv_area_t,
+    }
+
+    /// Row `y` of an RGB565 buffer with a stride in bytes
+    unsafe fn row<'a>(buf: *const c_void, stride: i32, y: i32, w: i32) -> &'a mut [u16] {
+        let start = (buf as *mut u8).offset(y as isize * stride as isize);
+        slice::from_raw_parts_mut(start as *mut u16, w as usize)
+    }
+
+    /// `lv_color_to_u16`
+    fn color_to_u16(c: sys::lv_color_t) -> u16 {
+        ((c.red as u16 & 0xF8) << 8) | ((c.green as u16 & 0xFC) << 3) | (c.blue as u16 >> 3)
+    }
+
+    /// The 5-bit weight LVGL's RGB565 mix uses for `opa`
+    fn mix_weight(opa: sys::lv_opa_t) -> u16 {
+        (opa as u16 + 4) >> 3
+    }
+
+    /// Opaque fill (`LV_DRAW_SW_COLOR_BLEND_TO_RGB565`)
+    #[doc(hidden)]
+    #[no_mangle]
+    pub unsafe extern "C" fn lv_rust_blend_color_to_rgb565(
+        dsc: *const FillDsc,
+    ) -> sys::lv_result_t {
+        let dsc = &*dsc;
+        if !ENABLED.load(Ordering::Relaxed) || !dsc.mask_buf.is_null() {
+            return sys::LV_RESULT_INVALID;
+        }
+        let color = color_to_u16(dsc.color);
+        for y in 0..dsc.dest_h {
+            // A plain fill becomes vector stores
+            row(dsc.dest_buf, dsc.dest_stride, y, dsc.dest_w).fill(color);
+        }
+        sys::LV_RESULT_OK
+    }
+
+    /// Translucent fill (`LV_DRAW_SW_COLOR_BLEND_TO_RGB565_WITH_OPA`)
+    #[doc(hidden)]
+    #[no_mangle]
+    pub unsafe extern "C" fn lv_rust_blend_color_to_rgb565_with_opa(
+        dsc: *const FillDsc,
+    ) -> sys::lv_result_t {
+        let dsc = &*dsc;
+        if !ENABLED.load(Ordering::Relaxed) || !dsc.mask_buf.is_null() {
+            return sys::LV_RESULT_INVALID;
+        }
+        let color = color_to_u16(dsc.color);
+        let mix = mix_weight(dsc.opa);
+        for y in 0..dsc.dest_h {
+            simd::fill_opa_row(
+                row(dsc.dest_buf, dsc.dest_stride, y, dsc.dest_w),
+                color,
+                mix,
+            );
+        }
+        sys::LV_RESULT_OK
+    }
+
+    /// RGB565 image with opacity (`LV_DRAW_SW_RGB565_BLEND_NORMAL_TO_RGB565_WITH_OPA`)
+    #[doc(hidden)]
+    #[no_mangle]
+    pub unsafe extern "C" fn lv_rust_blend_rgb565_to_rgb565_with_opa(
+        dsc: *const BlitDsc,
+    ) -> sys::lv_result_t {
+        let dsc = &*dsc;
+        if !ENABLED.load(Ordering::Relaxed) || !dsc.mask_buf.is_null() {
+            return sys::LV_RESULT_INVALID;
+        }
+        let mix = mix_weight(dsc.opa);
+        for y in 0..dsc.dest_h {
+            let dest = row(dsc.dest_buf, dsc.dest_stride, y, dsc.dest_w);
+            let src = row(dsc.src_buf, dsc.src_stride, y, dsc.dest_w);
+            simd::blend_opa_row(dest, src, mix);
+        }
+        sys::LV_RESULT_OK
+    }
+}
+
+// =============================================================================
+// Kernels
+// =============================================================================
+
+/// LVGL's `lv_color_16_16_mix` for a 5-bit weight `mix`
+///
+/// Equal to `bg + ((fg - bg) * mix >> 5)` per channel, which is what the
+/// vector kernels compute.
+#[allow(dead_code)]
+fn mix_rgb565(fg: u16, bg: u16, mix: u16) -> u16 {
+    const MASK: u32 = 0x07E0_F81F;
+    let spread = |c: u16| (c as u32 | (c as u32) << 16) & MASK;
+    let (fg, bg) = (spread(fg), spread(bg));
+    let mixed = ((fg.wrapping_sub(bg).wrapping_mul(mix as u32) >> 5).wrapping_add(bg)) & MASK;
+    (mixed >> 16) as u16 | mixed as u16
+}
+
+#[cfg(all(
+    any(target_arch = "x86", target_arch = "x86_64"),
+    target_feature = "sse2"
+))]
+mod simd {
+    use super::mix_rgb565;
+    #[cfg(target_arch = "x86")]
+    use core::arch::x86::*;
+    #[cfg(target_arch = "x86_64")]
+    use core::arch::x86_64::*;
+
+    /// Red, green and blue of 8 pixels
+    #[inline(always)]
+    unsafe fn split(v: __m128i) -> [__m128i; 3] {
+        [
+            _mm_srli_epi16(v, 11),
+            _mm_and_si128(_mm_srli_epi16(v, 5), _mm_set1_epi16(0x3F)),
+            _mm_and_si128(v, _mm_set1_epi16(0x1F)),
+        ]
+    }
+
+    /// `bg + ((fg - bg) * mix >> 5)`; the product fits in 16 bits
+    #[inline(always)]
+    unsafe fn lerp(fg: __m128i, bg: __m128i, mix: __m128i) -> __m128i {
+        let scaled = _mm_mullo_epi16(_mm_sub_epi16(fg, bg), mix);
+        _mm_add_epi16(bg, _mm_srai_epi16(scaled, 5))
+    }
+
+    #[inline(always)]
+    unsafe fn mix8(fg: &[__m128i; 3], bg: __m128i, mix: __m128i) -> __m128i {
+        let bg = split(bg);
+        let r = _mm_slli_epi16(lerp(fg[0], bg[0], mix), 11);
+        let g = _mm_slli_epi16(lerp(fg[1], bg[1], mix), 5);
+        _mm_or_si128(_mm_or_si128(r, g), lerp(fg[2], bg[2], mix))
+    }
+
+    pub unsafe fn fill_opa_row(row: &mut [u16], color: u16, mix: u16) {
+        let fg = split(_mm_set1_epi16(color as i16));
+        let weight = _mm_set1_epi16(mix as i16);
+        let mut chunks = row.chunks_exact_mut(8);
+        for chunk in &mut chunks {
+            let p = chunk.as_mut_ptr() as *mut __m128i;
+            _mm_storeu_si128(p, mix8(&fg, _mm_loadu_si128(p), weight));
+        }
+        for px in chunks.into_remainder() {
+            *px = mix_rgb565(color, *px, mix);
+        }
+    }
+
+    pub unsafe fn blend_opa_row(dest: &mut [u16], src: &[u16], mix: u16) {
+        let weight = _mm_set1_epi16(mix as i16);
+        let mut dest_chunks = dest.chunks_exact_mut(8);
+        let mut src_chunks = src.chunks_exact(8);
+        for (d, s) in (&mut dest_chunks).zip(&mut src_chunks) {
+            let p = d.as_mut_ptr() as *mut __m128i;
+            let fg = split(_mm_loadu_si128(s.as_ptr() as *const __m128i));
+            _mm_storeu_si128(p, mix8(&fg, _mm_loadu_si128(p), weight));
+        }
+        for (d, s) in dest_chunks
+            .into_remainder()
+            .iter_mut()
+            .zip(src_chunks.remainder())
+        {
+            *d = mix_rgb565(*s, *d, mix);
+        }
+    }
+}
+
+#[cfg(all(target_arch = "aarch64", target_feature = "neon"))]
+mod simd {
+    use super::mix_rgb565;
+    use core::arch::aarch64::*;
+
+    /// Red, green and blue of 8 pixels
+    #[inline(always)]
+    unsafe fn split(v: uint16x8_t) -> [int16x8_t; 3] {
+        [
+            vreinterpretq_s16_u16(vshrq_n_u16::<11>(v)),
+            vreinterpretq_s16_u16(vandq_u16(vshrq_n_u16::<5>(v), vdupq_n_u16(0x3F))),
+            vreinterpretq_s16_u16(vandq_u16(v, vdupq_n_u16(0x1F))),
+        ]
+    }
+
+    /// `bg + ((fg - bg) * mix >> 5)`; the product fits in 16 bits
+    #[inline(always)]
+    unsafe fn lerp(fg: int16x8_t, bg: int16x8_t, mix: int16x8_t) -> uint16x8_t {
+        let scaled = vmulq_s16(vsubq_s16(fg, bg), mix);
+        vreinterpretq_u16_s16(vaddq_s16(bg, vshrq_n_s16::<5>(scaled)))
+    }
+
+    #[inline(always)]
+    unsafe fn mix8(fg: &[int16x8_t; 3], bg: uint16x8_t, mix: int16x8_t) -> uint16x8_t {
+        let bg = split(bg);
+        let r = vshlq_n_u16::<11>(lerp(fg[0], bg[0], mix));
+        let g = vshlq_n_u16::<5>(lerp(fg[1], bg[1], mix));
+        vorrq_u16(vorrq_u16(r, g), lerp(fg[2], bg[2], mix))
+    }
+
+    pub unsafe fn fill_opa_row(row: &mut [u16], color: u16, mix: u16) {
+        let fg = split(vdupq_n_u16(color));
+        let weight = vdupq_n_s16(mix as i16);
+        let mut chunks = row.chunks_exact_mut(8);
+        for chunk in &mut chunks {
+            let p = chunk.as_mut_ptr();
+            vst1q_u16(p, mix8(&fg, vld1q_u16(p), weight));
+        }
+        for px in chunks.into_remainder() {
+            *px = mix_rgb565(color, *px, mix);
+        }
+    }
+
+    pub unsafe fn blend_opa_row(dest: &mut [u16], src: &[u16], mix: u16) {
+        let weight = vdupq_n_s16(mix as i16);
+        let mut dest_chunks = dest.chunks_exact_mut(8);
+        let mut src_chunks = src.chunks_exact(8);
+        for (d, s) in (&mut dest_chunks).zip(&mut src_chunks) {
+            let p = d.as_mut_ptr();
+            let fg = split(vld1q_u16(s.as_ptr()));
+            vst1q_u16(p, mix8(&fg, vld1q_u16(p), weight));
+        }
+        for (d, s) in dest_chunks
+            .into_remainder()
+            .iter_mut()
+            .zip(src_chunks.remainder())
+        {
+            *d = mix_rgb565(*s, *d, mix);
+        }
+    }
+}
@@ -0,0 +1,445 @@
+//! Cross-thread widget updates
+//!
+//! LVGL objects are `!Send`, so other threads and tasks can't touch widgets
+//! directly. Instead they push [`Command`]s into a [`CommandQueue`], a
+//! fixed-capacity lock-free MPSC queue, and the UI loop applies them in one
+//! batch right before `lv_timer_handler` via [`CommandQueue::drain`].
+//!
+//! ```ignore
+//! static UPDATES: CommandQueue<64> = CommandQueue::new();
+//!
+//! // UI thread
+//! let bar_handle = bar.handle();
+//!
+//! // Sensor task
+//! UPDATES.push(Command::bar_value(bar_handle, 42, false)).ok();
+//!
+//! // UI loop
+//! UPDATES.drain();
+//! lvgl::task_handler();
+//! ```
+
+#[cfg(feature = "widget-arc")]
+use crate::widgets::Arc;
+#[cfg(feature = "widget-bar")]
+use crate::widgets::Bar;
+#[cfg(feature = "widget-label")]
+use crate::widgets::Label;
+#[cfg(feature = "widget-slider")]
+use crate::widgets::Slider;
+#[cfg(feature = "widget-chart")]
+use crate::widgets::{Chart, ChartSeries};
+use core::cell::UnsafeCell;
+use core::marker::PhantomData;
+use core::mem::MaybeUninit;
+use core::sync::atomic::{AtomicUsize, Ordering};
+use lvgl_sys as sys;
+
+// =============================================================================
+// Handles
+// =============================================================================
+
+/// `Send` reference to an LVGL object of type `T`
+///
+/// An address and the object's class. Before use the address is checked
+/// with `lv_obj_is_valid` and the class with `lv_obj_check_type`, so a
+/// command for a deleted widget is dropped even if its memory now holds a
+/// widget of another type. A new widget of the same type at the same
+/// address can't be told apart, so drop handles along with their screen.
+pub struct ObjHandle<T> {
+    addr: usize,
+    class: usize,
+    _marker: PhantomData<fn() -> T>,
+}
+
+impl<T> ObjHandle<T> {
+    pub(crate) fn new(raw: *mut sys::lv_obj_t) -> Self {
+        let class = if raw.is_null() {
+            0
+        } else {
+            unsafe { sys::lv_obj_get_class(raw) as usize }
+        };
+        Self {
+            addr: raw as usize,
+            class,
+            _marker: PhantomData,
+        }
+    }
+
+    /// Raw object pointer (only meaningful on the UI thread)
+    pub fn raw(&self) -> *mut sys::lv_obj_t {
+        self.addr as *mut sys::lv_obj_t
+    }
+
+    /// True if the object still exists and has the handle's class
+    ///
+    /// Must only be called from the thread that runs LVGL.
+    pub fn is_valid(&self) -> bool {
+        let obj = self.raw();
+        unsafe {
+            self.class != 0
+                && sys::lv_obj_is_valid(obj)
+                && sys::lv_obj_check_type(obj, self.class as *const sys::lv_obj_class_t)
+        }
+    }
+
+    /// Same object, without the widget type
+    fn erase(self) -> ObjHandle<()> {
+        ObjHandle {
+            addr: self.addr,
+            class: self.class,
+            _marker: PhantomData,
+        }
+    }
+}
+
+impl<T> Clone for ObjHandle<T> {
+    fn clone(&self) -> Self {
+        *self
+    }
+}
+
+impl<T> Copy for ObjHandle<T> {}
+
+impl<T> core::fmt::Debug for ObjHandle<T> {
+    fn fmt(&self, f: &mut core::fmt::Formatter<'_>) -> core::fmt::Result {
+        write!(f, "ObjHandle({:#x})", self.addr)
+    }
+}
+
+/// `Send` reference to a chart series
+#[cfg(feature = "widget-chart")]
+#[derive(Clone, Copy, Debug)]
+pub struct SeriesHandle(usize);
+
+#[cfg(feature = "widget-chart")]
+impl ChartSeries {
+    /// Get a handle for use in [`Command::chart_next`]
+    pub fn handle(&self) -> SeriesHandle {
+        SeriesHandle(self.raw as usize)
+    }
+}
+
+// =============================================================================
+// Commands
+// =============================================================================
+
+/// Maximum label text length in a [`Command`], in bytes
+pub const INLINE_TEXT_LEN: usize = 31;
+
+/// Short NUL-terminated text stored inline in a command
+#[derive(Clone, Copy)]
+pub struct InlineText {
+    buf: [u8; INLINE_TEXT_LEN + 1],
+}
+
+impl InlineText {
+    /// Copy `text`, truncated to [`INLINE_TEXT_LEN`] bytes on a char boundary
+    pub fn new(text: &str) -> Self {
+        let mut len = text.len().min(INLINE_TEXT_LEN);
+        while !text.is_char_boundary(len) {
+            len -= 1;
+        }
+        let mut buf = [0u8; INLINE_TEXT_LEN + 1];
+        buf[..len].copy_from_slice(&text.as_bytes()[..len]);
+        Self { buf }
+    }
+
+    fn as_ptr(&self) -> *const core::ffi::c_char {
+        self.buf.as_ptr() as *const _
+    }
+}
+
+/// A widget update sent from another thread
+#[derive(Clone, Copy)]
+pub struct Command {
+    target: ObjHandle<()>,
+    kind: CommandKind,
+}
+
+#[derive(Clone, Copy)]
+enum CommandKind {
+    #[cfg(feature = "widget-bar")]
+    BarValue { value: i32, anim: bool },
+    #[cfg(feature = "widget-slider")]
+    SliderValue { value: i32, anim: bool },
+    #[cfg(feature = "widget-arc")]
+    ArcValue { value: i32 },
+    #[cfg(feature = "widget-label")]
+    LabelText { text: InlineText },
+    #[cfg(feature = "widget-chart")]
+    ChartNext { series: usize, value: i32 },
+}
+
+impl Command {
+    /// Set a bar's value
+    #[cfg(feature = "widget-bar")]
+    pub fn bar_value(bar: ObjHandle<Bar>, value: i32, anim: bool) -> Self {
+        Self::new(bar.erase(), CommandKind::BarValue { value, anim })
+    }
+
+    /// Set a slider's value
+    #[cfg(feature = "widget-slider")]
+    pub fn slider_value(slider: ObjHandle<Slider>, value: i32, anim: bool) -> Self {
+        Self::new(slider.erase(), CommandKind::SliderValue { value, anim })
+    }
+
+    /// Set an arc's value
+    #[cfg(feature = "widget-arc")]
+    pub fn arc_value(arc: ObjHandle<Arc>, value: i32) -> Self {
+        Self::new(arc.erase(), CommandKind::ArcValue { value })
+    }
+
+    /// Set a label's text (truncated to [`INLINE_TEXT_LEN`] bytes)
+    #[cfg(feature = "widget-label")]
+    pub fn label_text(label: ObjHandle<Label>, text: &str) -> Self {
+        Self::new(
+            label.erase(),
+            CommandKind::LabelText {
+                text: InlineText::new(text),
+            },
+        )
+    }
+
+    /// Append a value to a chart series
+    ///
+    /// Unlike the other commands these are never coalesced, as each one is
+    /// a sample.
+    #[cfg(feature = "widget-chart")]
+    pub fn chart_next(chart: ObjHandle<Chart>, series: SeriesHandle, value: i32) -> Self {
+        Self::new(
+            chart.erase(),
+            CommandKind::ChartNext {
+                series: series.0,
+                value,
+            },
+        )
+    }
+
+    fn new(target: ObjHandle<()>, kind: CommandKind) -> Self {
+        Self { target, kind }
+    }
+
+    /// True if `later` makes this command redundant
+    fn superseded_by(&self, later: &Command) -> bool {
+        #[cfg(feature = "widget-chart")]
+        if matches!(self.kind, CommandKind::ChartNext { .. }) {
+            return false;
+        }
+        self.target.addr == later.target.addr
+            && self.target.class == later.target.class
+            && core::mem::discriminant(&self.kind) == core::mem::discriminant(&later.kind)
+    }
+
+    /// Apply on the UI thread
+    unsafe fn apply(&self) {
+        if !self.target.is_valid() {
+            return;
+        }
+        let obj = self.target.raw();
+        match self.kind {
+            #[cfg(feature = "widget-bar")]
+            CommandKind::BarValue { value, anim } => {
+                sys::lv_bar_set_value(obj, value, anim_flag(anim));
+            }
+            #[cfg(feature = "widget-slider")]
+            CommandKind::SliderValue { value, anim } => {
+                sys::lv_slider_set_value(obj, value, anim_flag(anim));
+            }
+            #[cfg(feature = "widget-arc")]
+            CommandKind::ArcValue { value } => {
+                sys::lv_arc_set_value(obj, value);
+            }
+            #[cfg(feature = "widget-label")]
+            CommandKind::LabelText { ref text } => {
+                sys::lv_label_set_text(obj, text.as_ptr());
+            }
+            #[cfg(feature = "widget-chart")]
+            CommandKind::ChartNext { series, value } => {
+                let series = series as *mut sys::lv_chart_series_t;
+                if crate::widgets::chart_has_series(obj, series) {
+                    sys::lv_chart_set_next_value(obj, series, value);
+                }
+            }
+        }
+    }
+}
+
+#[cfg(any(feature = "widget-bar", feature = "widget-slider"))]
+fn anim_flag(anim: bool) -> sys::lv_anim_enable_t {
+    if anim {
+        sys::LV_ANIM_ON
+    } else {
+        sys::LV_ANIM_OFF
+    }
+}
+
+// =============================================================================
+// Queue
+// =============================================================================
+
+/// Commands applied per coalescing pass in [`CommandQueue::drain`]
+const DRAIN_BATCH: usize = 16;
+
+struct Slot {
+    /// Sequence number, stored relative to the slot index
+    seq: AtomicUsize,
+    cmd: UnsafeCell<MaybeUninit<Command>>,
+}
+
+#[allow(clippy::declare_interior_mutable_const)]
+const EMPTY_SLOT: Slot = Slot {
+    seq: AtomicUsize::new(0),
+    cmd: UnsafeCell::new(MaybeUninit::uninit()),
+};
+
+/// Fixed-capacity lock-free multi-producer, single-consumer command queue
+///
+/// `N` must be a power of two. Any thread may [`push`](Self::push); only the
+/// UI thread may [`drain`](Self::drain).
+pub struct CommandQueue<const N: usize> {
+    slots: [Slot; N],
+    enqueue_pos: AtomicUsize,
+    dequeue_pos: AtomicUsize,
+}
+
+// Commands only carry addresses and plain data; they are dereferenced on
+// the UI thread in drain().
+unsafe impl<const N: usize> Sync for CommandQueue<N> {}
+unsafe impl<const N: usize> Send for CommandQueue<N> {}
+
+impl<const N: usize> CommandQueue<N> {
+    const VALID_CAPACITY: () = assert!(N.is_power_of_two(), "capacity must be a power of two");
+
+    /// Create an empty queue (usable in a `static`)
+    pub const fn new() -> Self {
+        let () = Self::VALID_CAPACITY;
+        Self {
+            slots: [EMPTY_SLOT; N],
+            enqueue_pos: AtomicUsize::new(0),
+            dequeue_pos: AtomicUsize::new(0),
+        }
+    }
+
+    /// Queue a command from any thread
+    ///
+    /// Wakes a sleeping [`RunLoop`](crate::RunLoop). Returns the command back
+    /// if the queue is full.
+    pub fn push(&self, cmd: Command) -> core::result::Result<(), Command> {
+        let mut pos = self.enqueue_pos.load(Ordering::Relaxed);
+        loop {
+            let idx = pos & (N - 1);
+            let slot = &self.slots[idx];
+            let seq = slot.seq.load(Ordering::Acquire).wrapping_add(idx);
+            let diff = seq.wrapping_sub(pos) as isize;
+
+            if diff == 0 {
+                match self.enqueue_pos.compare_exchange_weak(
+                    pos,
+                    pos.wrapping_add(1),
+                    Ordering::Relaxed,
+                    Ordering::Relaxed,
+                ) {
+                    Ok(_) => {
+                        unsafe { (*slot.cmd.get()).write(cmd) };
+                        slot.seq
+                            .store(pos.wrapping_add(1).wrapping_sub(idx), Ordering::Release);
+                        crate::wake();
+                        return Ok(());
+                    }
+                    Err(current) => pos = current,
+                }
+            } else if diff < 0 {
+                return Err(cmd);
+            } else {
+                pos = self.enqueue_pos.load(Ordering::Relaxed);
+            }
+        }
+    }
+
+    /// Take the oldest command
+    fn pop(&self) -> Option<Command> {
+        let mut pos = self.dequeue_pos.load(Ordering::Relaxed);
+        loop {
+            let idx = pos & (N - 1);
+            let slot = &self.slots[idx];
+            let seq = slot.seq.load(Ordering::Acquire).wrapping_add(idx);
+            let diff = seq.wrapping_sub(pos.wrapping_add(1)) as isize;
+
+            if diff == 0 {
+                match self.dequeue_pos.compare_exchange_weak(
+                    pos,
+                    pos.wrapping_add(1),
+                    Ordering::Relaxed,
+                    Ordering::Relaxed,
+                ) {
+                    Ok(_) => {
+                        let cmd = unsafe { (*slot.cmd.get()).assume_init_read() };
+                        slot.seq
+                            .store(pos.wrapping_add(N).wrapping_sub(idx), Ordering::Release);
+                        return Some(cmd);
+                    }
+                    Err(current) => pos = current,
+                }
+            } else if diff < 0 {
+                return None;
+            } else {
+                pos = self.dequeue_pos.load(Ordering::Relaxed);
+            }
+        }
+    }
+
+    /// Apply queued commands on the UI thread
+    ///
+    /// Call right before [`crate::task_handler`]. Commands are applied in
+    /// order; within a batch, an update superseded by a later one to the same
+    /// target is skipped. Stops after `N` commands so busy producers can't
+    /// stall the UI loop. Returns the number of commands taken.
+    ///
+    /// Must only be called from the thread that runs LVGL.
+    pub fn drain(&self) -> usize {
+        let mut taken = 0;
+        while taken < N {
+            let mut batch = [MaybeUninit::<Command>::uninit(); DRAIN_BATCH];
+            let mut len = 0;
+            while len < DRAIN_BATCH && taken + len < N {
+                match self.pop() {
+                    Some(cmd) => {
+                        batch[len].write(cmd);
+                        len += 1;
+                    }
+                    None => break,
+                }
+            }
+            if len == 0 {
+                break;
+            }
+            taken += len;
+
+            // The first `len` entries were written above
+            let batch =
+                unsafe { &*(&batch[..len] as *const [MaybeUninit<Command>] as *const [Command]) };
+            for (i, cmd) in batch.iter().enumerate() {
+                if !batch[i + 1..].iter().any(|later| cmd.superseded_by(later)) {
+                    unsafe { cmd.apply() };
+                }
+            }
+
+            if len < DRAIN_BATCH {
+                break;
+            }
+        }
+        taken
+    }
+
+    /// Capacity of the queue
+    pub const fn capacity(&self) -> usize {
+        N
+    }
+}
+
+impl<const N: usize> Default for CommandQueue<N> {
+    fn default() -> Self {
+        Self::new()
+    }
+}
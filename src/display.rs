@@ -2,9 +2,14 @@
 //!
 //! Provides safe wrappers for creating and managing LVGL displays.
 
+use crate::perf::{FrameObserver, Probe};
 use crate::{LvglError, Result};
+use alloc::boxed::Box;
+use alloc::vec::Vec;
+use core::ffi::c_void;
 use core::marker::PhantomData;
 use core::ptr;
+use core::slice;
 use lvgl_sys as sys;
 
 /// Type alias for the flush callback function
@@ -60,6 +65,7 @@ impl Display {
             .map(|b| b.as_mut_ptr() as *mut _)
             .unwrap_or(ptr::null_mut());
 
+        display_state(self.raw).render_mode = render_mode;
         sys::lv_display_set_buffers(
             self.raw,
             buf1.as_mut_ptr() as *mut _,
@@ -69,10 +75,115 @@ impl Display {
         );
     }
 
+    /// Set two equally sized draw buffers for double-buffering
+    ///
+    /// LVGL renders into one buffer while the other is being flushed, so a
+    /// flush callback that only starts a DMA transfer can return immediately
+    /// and signal completion later through [`FlushReady`].
+    ///
+    /// # Arguments
+    /// * `buf1` - First draw buffer
+    /// * `buf2` - Second draw buffer, must have the same length as `buf1`
+    /// * `render_mode` - How rendering should work
+    pub fn set_double_buffers(
+        &self,
+        buf1: &'static mut [u8],
+        buf2: &'static mut [u8],
+        render_mode: RenderMode,
+    ) -> Result<()> {
+        if buf1.is_empty() || buf1.len() != buf2.len() {
+            return Err(LvglError::InvalidParameter);
+        }
+
+        unsafe {
+            display_state(self.raw).render_mode = render_mode;
+            sys::lv_display_set_buffers(
+                self.raw,
+                buf1.as_mut_ptr() as *mut _,
+                buf2.as_mut_ptr() as *mut _,
+                buf1.len() as u32,
+                render_mode as u32,
+            );
+        }
+        Ok(())
+    }
+
+    /// Attach buffers created with [`DisplayBuffers`]
+    ///
+    /// Also switches the display to the buffers' color format. The first two
+    /// buffers are handed to LVGL; a third buffer stays available through
+    /// [`DisplayBuffers::spare`].
+    pub fn attach_buffers(&self, buffers: &DisplayBuffers) {
+        let buf2 = if buffers.count >= 2 {
+            buffers.bufs[1]
+        } else {
+            ptr::null_mut()
+        };
+
+        unsafe {
+            display_state(self.raw).render_mode = buffers.render_mode;
+            sys::lv_display_set_color_format(self.raw, buffers.format as u32);
+            sys::lv_display_set_buffers(
+                self.raw,
+                buffers.bufs[0] as *mut _,
+                buf2 as *mut _,
+                buffers.size as u32,
+                buffers.render_mode as u32,
+            );
+        }
+    }
+
     /// Set the flush callback
+    ///
+    /// The callback is invoked through the library's flush dispatcher, which
+    /// keeps its state in the display's driver data. Don't overwrite it with
+    /// `lv_display_set_driver_data`.
     pub fn set_flush_cb(&self, flush_cb: FlushCb) {
         unsafe {
-            sys::lv_display_set_flush_cb(self.raw, Some(flush_cb));
+            display_state(self.raw).flush_cb = Some(flush_cb);
+            sys::lv_display_set_flush_cb(self.raw, Some(flush_trampoline));
+        }
+    }
+
+    /// Flush through a [`FlushBatcher`] instead of a raw callback
+    ///
+    /// In `Direct` and `Full` mode the areas of one refresh cycle are
+    /// collected until LVGL reports the last one, merged where a larger
+    /// window is cheaper than separate ones, and handed to `sink`. In
+    /// `Partial` mode the pixels of an area are gone once it is flushed, so
+    /// areas are passed through unchanged.
+    ///
+    /// # Arguments
+    /// * `sink` - Receives the (merged) areas
+    /// * `render_mode` - Render mode the display buffers were set up with
+    /// * `setup_cost` - Cost of starting a window write, in pixels
+    pub fn set_flush_batcher<S: FlushSink + 'static>(
+        &self,
+        sink: S,
+        render_mode: RenderMode,
+        setup_cost: u32,
+    ) {
+        unsafe {
+            display_state(self.raw).batcher =
+                Some(Box::new(FlushBatcher::new(sink, render_mode, setup_cost)));
+            sys::lv_display_set_flush_cb(self.raw, Some(flush_trampoline));
+        }
+    }
+
+    /// Set the byte order of RGB565 pixels handed to the flush callback
+    ///
+    /// Most SPI panels expect big-endian RGB565 while LVGL renders
+    /// little-endian. With [`ByteOrder::Swapped`] each area is swapped once
+    /// in place, row by row with LVGL's word-wise `lv_draw_sw_rgb565_swap`,
+    /// before the flush callback or batcher sees it, so drivers can DMA the
+    /// buffer as is. Stride padding is left alone.
+    ///
+    /// `Direct` mode keeps drawing into the same frame buffer, so it can't be
+    /// swapped in place; there the setting is ignored.
+    pub fn set_byte_order(&self, order: ByteOrder) {
+        unsafe {
+            display_state(self.raw).byte_order = order;
+            sys::lv_display_set_flush_cb(self.raw, Some(flush_trampoline));
         }
     }
 
@@ -85,6 +196,16 @@ impl Display {
         }
     }
 
+    /// Get a handle that can signal flush completion from another context
+    ///
+    /// # Safety
+    /// The handle holds the raw display pointer. The display must not be
+    /// dropped or deleted while a copy can still be signalled, e.g. by a
+    /// DMA transfer that is still in flight.
+    pub unsafe fn flush_ready_handle(&self) -> FlushReady {
+        FlushReady(self.raw)
+    }
+
     /// Get raw display pointer (for use in flush callbacks)
     pub fn raw(&self) -> *mut sys::lv_display_t {
         self.raw
@@ -100,10 +221,213 @@ impl Display {
         unsafe { sys::lv_display_get_vertical_resolution(self.raw) }
     }
 
+    /// Set the color format LVGL renders in
+    ///
+    /// Call before setting the buffers, as LVGL derives the buffer stride
+    /// from the format.
+    pub fn set_color_format(&self, format: ColorFormat) {
+        unsafe { sys::lv_display_set_color_format(self.raw, format as u32) }
+    }
+
     /// Set display rotation
+    ///
+    /// LVGL rotates every rendered area in software before flushing it. For
+    /// panels that can rotate in their controller use
+    /// [`rotate_with`](Self::rotate_with) instead; don't mix the two.
     pub fn set_rotation(&self, rotation: DisplayRotation) {
         unsafe { sys::lv_display_set_rotation(self.raw, rotation as u32) }
     }
+
+    /// Rotate the display, in the panel controller if it supports it
+    ///
+    /// `panel` is asked to switch to `rotation`, counted from the
+    /// orientation the display was created in. If it does, LVGL keeps
+    /// rendering unrotated at the swapped resolution. Otherwise the panel
+    /// returns to its native orientation and LVGL rotates in software.
+    ///
+    /// Either way the screen is redrawn. Pass the returned
+    /// [`Rotation::touch`] to the touch driver so touch points follow the
+    /// image.
+    pub fn rotate_with(
+        &self,
+        rotation: DisplayRotation,
+        panel: &mut dyn PanelRotation,
+    ) -> Rotation {
+        unsafe {
+            let state = display_state(self.raw);
+            let mut width = sys::lv_display_get_physical_horizontal_resolution(self.raw);
+            let mut height = sys::lv_display_get_physical_vertical_resolution(self.raw);
+            if state.panel_rotation.swaps_axes() {
+                core::mem::swap(&mut width, &mut height);
+            }
+
+            let hardware = panel.set_panel_rotation(rotation);
+            if !hardware && state.panel_rotation != DisplayRotation::None {
+                panel.set_panel_rotation(DisplayRotation::None);
+            }
+            state.panel_rotation = if hardware {
+                rotation
+            } else {
+                DisplayRotation::None
+            };
+
+            let (hor, ver) = if hardware && rotation.swaps_axes() {
+                (height, width)
+            } else {
+                (width, height)
+            };
+            sys::lv_display_set_rotation(
+                self.raw,
+                if hardware {
+                    sys::LV_DISPLAY_ROTATION_0
+                } else {
+                    rotation as u32
+                },
+            );
+            sys::lv_display_set_resolution(self.raw, hor, ver);
+
+            Rotation {
+                rotation,
+                hardware,
+                width: self.get_hor_res(),
+                height: self.get_ver_res(),
+                // LVGL maps pointer input itself when it rotates
+                touch: if hardware {
+                    TouchTransform::for_rotation(rotation, width, height)
+                } else {
+                    TouchTransform::for_rotation(DisplayRotation::None, width, height)
+                },
+            }
+        }
+    }
+
+    /// Send a [`FrameStats`](crate::perf::FrameStats) record of every
+    /// refresh to `observer`
+    ///
+    /// `now_us` is a microsecond clock, read a few times per refresh and
+    /// once per flushed area. Replaces an earlier observer.
+    pub fn set_frame_observer(&self, observer: &'static dyn FrameObserver, now_us: fn() -> u64) {
+        unsafe {
+            let state = display_state(self.raw);
+            if state.probe.is_none() {
+                sys::lv_display_add_event_cb(
+                    self.raw,
+                    Some(crate::perf::probe_cb),
+                    sys::LV_EVENT_ALL,
+                    ptr::null_mut(),
+                );
+            }
+            state.probe = Some(Box::new(Probe::new(observer, now_us)));
+        }
+    }
+
+    /// Stop sending frame records
+    pub fn clear_frame_observer(&self) {
+        unsafe {
+            let state = display_state(self.raw);
+            if state.probe.take().is_some() {
+                sys::lv_display_remove_event_cb_with_user_data(
+                    self.raw,
+                    Some(crate::perf::probe_cb),
+                    ptr::null_mut(),
+                );
+            }
+        }
+    }
+}
+
+/// Rectangle in display coordinates (inclusive corners)
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub struct Area {
+    pub x1: i32,
+    pub y1: i32,
+    pub x2: i32,
+    pub y2: i32,
+}
+
+impl Area {
+    /// Create an area from its corners
+    pub const fn new(x1: i32, y1: i32, x2: i32, y2: i32) -> Self {
+        Self { x1, y1, x2, y2 }
+    }
+
+    /// Width in pixels
+    pub const fn width(&self) -> i32 {
+        self.x2 - self.x1 + 1
+    }
+
+    /// Height in pixels
+    pub const fn height(&self) -> i32 {
+        self.y2 - self.y1 + 1
+    }
+
+    /// Number of pixels
+    pub const fn size(&self) -> u32 {
+        (self.width() * self.height()) as u32
+    }
+
+    /// Smallest area containing both areas
+    pub fn union(&self, other: &Area) -> Area {
+        Area {
+            x1: self.x1.min(other.x1),
+            y1: self.y1.min(other.y1),
+            x2: self.x2.max(other.x2),
+            y2: self.y2.max(other.y2),
+        }
+    }
+
+    /// Check if the areas share at least one pixel
+    pub fn intersects(&self, other: &Area) -> bool {
+        self.x1 <= other.x2 && other.x1 <= self.x2 && self.y1 <= other.y2 && other.y1 <= self.y2
+    }
+}
+
+impl From<sys::lv_area_t> for Area {
+    fn from(area: sys::lv_area_t) -> Self {
+        Self::new(area.x1, area.y1, area.x2, area.y2)
+    }
+}
+
+impl From<Area> for sys::lv_area_t {
+    fn from(area: Area) -> Self {
+        sys::lv_area_t {
+            x1: area.x1,
+            y1: area.y1,
+            x2: area.x2,
+            y2: area.y2,
+        }
+    }
+}
+
+/// Handle for signalling flush completion from an ISR or DMA callback
+///
+/// `lv_display_flush_ready` only clears the display's flushing flags, so it
+/// may be called from interrupt context while LVGL renders the other buffer.
+/// The handle doesn't keep the display alive: creating one is `unsafe`, and
+/// the creator promises the display outlives every copy.
+#[derive(Clone, Copy, Debug)]
+pub struct FlushReady(*mut sys::lv_display_t);
+
+// The handle only touches LVGL's volatile flushing flags.
+unsafe impl Send for FlushReady {}
+unsafe impl Sync for FlushReady {}
+
+impl FlushReady {
+    /// Create a handle from the display pointer passed to a flush callback
+    ///
+    /// # Safety
+    /// `disp` must point to a live LVGL display that stays alive as long as
+    /// the handle (and its copies) can be signalled.
+    pub unsafe fn from_raw(disp: *mut sys::lv_display_t) -> Self {
+        Self(disp)
+    }
+
+    /// Signal that the pending flush has finished
+    pub fn signal(&self) {
+        unsafe {
+            sys::lv_display_flush_ready(self.0);
+        }
+    }
 }
 
 /// Render mode for the display
@@ -118,8 +442,18 @@ pub enum RenderMode {
     Direct = sys::LV_DISPLAY_RENDER_MODE_DIRECT,
 }
 
-/// Display rotation
-#[derive(Clone, Copy, Debug)]
+/// Byte order of RGB565 pixels sent to the panel
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub enum ByteOrder {
+    /// LVGL's native little-endian order (SDL, parallel RGB panels)
+    #[default]
+    Native,
+    /// High byte first, as expected by SPI panels like ST7789/ILI9341
+    Swapped,
+}
+
+/// Display rotation, clockwise
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
 #[repr(u32)]
 pub enum DisplayRotation {
     None = sys::LV_DISPLAY_ROTATION_0,
@@ -128,24 +462,723 @@ pub enum DisplayRotation {
     Rotate270 = sys::LV_DISPLAY_ROTATION_270,
 }
 
+impl DisplayRotation {
+    /// Number of clockwise quarter turns
+    pub fn quarter_turns(self) -> u8 {
+        match self {
+            DisplayRotation::None => 0,
+            DisplayRotation::Rotate90 => 1,
+            DisplayRotation::Rotate180 => 2,
+            DisplayRotation::Rotate270 => 3,
+        }
+    }
+
+    /// True if width and height trade places
+    pub fn swaps_axes(self) -> bool {
+        self.quarter_turns() % 2 == 1
+    }
+}
+
+// =============================================================================
+// Hardware rotation
+// =============================================================================
+
+/// Panel driver that can rotate the image in its controller
+///
+/// Implemented by drivers whose controller has an address-order register
+/// (MADCTL on ST7789 and ILI9341), so rotation costs nothing per frame. See
+/// [`Display::rotate_with`].
+pub trait PanelRotation {
+    /// Switch to `rotation`, clockwise from the native orientation
+    ///
+    /// Return false if the panel can't; it must then be left in, or
+    /// returned to, its native orientation when asked for
+    /// [`DisplayRotation::None`]. Called on the LVGL thread, possibly while
+    /// a flush is still in progress, so the panel command must be ordered
+    /// after pending pixel transfers.
+    fn set_panel_rotation(&mut self, rotation: DisplayRotation) -> bool;
+}
+
+/// Result of [`Display::rotate_with`]
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub struct Rotation {
+    /// Requested rotation
+    pub rotation: DisplayRotation,
+    /// True if the panel rotates, false if LVGL does
+    pub hardware: bool,
+    /// Horizontal resolution after rotation
+    pub width: i32,
+    /// Vertical resolution after rotation
+    pub height: i32,
+    /// Transform for points read from the touch controller
+    pub touch: TouchTransform,
+}
+
+/// Mapping of raw touch points to display coordinates
+///
+/// Points are swapped first, then mirrored within `width` x `height`, the
+/// range of the mapped points. This is the order touch drivers such as the
+/// CST816 apply it in.
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub struct TouchTransform {
+    pub swap_xy: bool,
+    pub invert_x: bool,
+    pub invert_y: bool,
+    pub width: i32,
+    pub height: i32,
+}
+
+impl TouchTransform {
+    /// Transform for a display rotated by `rotation` from a native
+    /// `width` x `height`, matching LVGL's own pointer rotation
+    pub fn for_rotation(rotation: DisplayRotation, width: i32, height: i32) -> Self {
+        let (swap_xy, invert_x, invert_y) = match rotation {
+            DisplayRotation::None => (false, false, false),
+            DisplayRotation::Rotate90 => (true, true, false),
+            DisplayRotation::Rotate180 => (false, true, true),
+            DisplayRotation::Rotate270 => (true, false, true),
+        };
+        let (width, height) = if swap_xy {
+            (height, width)
+        } else {
+            (width, height)
+        };
+        Self {
+            swap_xy,
+            invert_x,
+            invert_y,
+            width,
+            height,
+        }
+    }
+
+    /// Map a raw point
+    pub fn apply(&self, x: i32, y: i32) -> (i32, i32) {
+        let (mut x, mut y) = if self.swap_xy { (y, x) } else { (x, y) };
+        if self.invert_x {
+            x = self.width - 1 - x;
+        }
+        if self.invert_y {
+            y = self.height - 1 - y;
+        }
+        (x, y)
+    }
+}
+
+/// Pixel formats usable for draw buffers
+///
+/// Values follow `lv_color_format_t`.
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+#[repr(u32)]
+pub enum ColorFormat {
+    /// 8-bit grayscale
+    L8 = sys::LV_COLOR_FORMAT_L8,
+    /// 1-bit indexed (monochrome, e.g. e-paper)
+    I1 = sys::LV_COLOR_FORMAT_I1,
+    /// 2-bit indexed
+    I2 = sys::LV_COLOR_FORMAT_I2,
+    /// 4-bit indexed
+    I4 = sys::LV_COLOR_FORMAT_I4,
+    /// 8-bit indexed
+    I8 = sys::LV_COLOR_FORMAT_I8,
+    /// 8-bit alpha only
+    A8 = sys::LV_COLOR_FORMAT_A8,
+    /// 16-bit RGB565
+    Rgb565 = sys::LV_COLOR_FORMAT_RGB565,
+    /// 24-bit RGB888
+    Rgb888 = sys::LV_COLOR_FORMAT_RGB888,
+    /// 32-bit ARGB8888
+    Argb8888 = sys::LV_COLOR_FORMAT_ARGB8888,
+    /// 32-bit XRGB8888 (alpha byte ignored)
+    Xrgb8888 = sys::LV_COLOR_FORMAT_XRGB8888,
+}
+
+impl ColorFormat {
+    /// Convert an `lv_color_format_t` value
+    pub fn from_raw(raw: u32) -> Option<Self> {
+        const FORMATS: [ColorFormat; 10] = [
+            ColorFormat::L8,
+            ColorFormat::I1,
+            ColorFormat::I2,
+            ColorFormat::I4,
+            ColorFormat::I8,
+            ColorFormat::A8,
+            ColorFormat::Rgb565,
+            ColorFormat::Rgb888,
+            ColorFormat::Argb8888,
+            ColorFormat::Xrgb8888,
+        ];
+        FORMATS.into_iter().find(|f| *f as u32 == raw)
+    }
+
+    /// Format LVGL uses for the configured `LV_COLOR_DEPTH`
+    pub const fn native() -> Self {
+        match sys::LV_COLOR_DEPTH {
+            1 => Self::I1,
+            8 => Self::L8,
+            24 => Self::Rgb888,
+            32 => Self::Argb8888,
+            _ => Self::Rgb565,
+        }
+    }
+
+    /// Bits per pixel
+    pub const fn bpp(self) -> u32 {
+        match self {
+            Self::I1 => 1,
+            Self::I2 => 2,
+            Self::I4 => 4,
+            Self::L8 | Self::I8 | Self::A8 => 8,
+            Self::Rgb565 => 16,
+            Self::Rgb888 => 24,
+            Self::Argb8888 | Self::Xrgb8888 => 32,
+        }
+    }
+
+    /// Bytes per row, rounded up to `LV_DRAW_BUF_STRIDE_ALIGN`
+    pub const fn stride(self, width: u32) -> usize {
+        let bytes = (width as usize * self.bpp() as usize + 7) / 8;
+        let align = sys::LV_DRAW_BUF_STRIDE_ALIGN as usize;
+        (bytes + align - 1) / align * align
+    }
+
+    /// Bytes of palette stored in front of the pixels (indexed formats)
+    pub const fn palette_size(self) -> usize {
+        match self {
+            Self::I1 | Self::I2 | Self::I4 | Self::I8 => 4 << self.bpp(),
+            _ => 0,
+        }
+    }
+
+    /// Bytes needed for `lines` rows of `width` pixels, including palette
+    pub const fn buf_size(self, width: u32, lines: u32) -> usize {
+        self.palette_size() + self.stride(width) * lines as usize
+    }
+
+    /// Bytes of pixel data LVGL passes to the flush callback for `area`
+    ///
+    /// The palette of indexed formats comes first, then rows of the area's
+    /// width.
+    pub fn area_size(self, area: &sys::lv_area_t) -> usize {
+        let width = (area.x2 - area.x1 + 1).max(0) as u32;
+        let height = (area.y2 - area.y1 + 1).max(0) as u32;
+        self.buf_size(width, height)
+    }
+}
+
+// =============================================================================
+// Flush dispatch and batching
+// =============================================================================
+
+/// Default cost of a window write in pixels
+///
+/// On SPI panels the CASET/RASET/RAMWR sequence takes about as long as
+/// sending a hundred or so pixels.
+pub const DEFAULT_SETUP_COST: u32 = 128;
+
+/// Receiver of flushed areas behind a [`FlushBatcher`]
+pub trait FlushSink {
+    /// Send `area` to the panel
+    ///
+    /// `data` starts at the area's first pixel and rows are `stride` bytes
+    /// apart. The batcher signals flush completion after this returns.
+    fn flush_area(&mut self, area: &Area, data: &[u8], stride: usize);
+}
+
+/// Flush stage called from the dispatcher
+trait FlushStage {
+    unsafe fn flush(&mut self, disp: *mut sys::lv_display_t, area: &sys::lv_area_t, px_map: *mut u8);
+}
+
+/// Per-display state, stored as LVGL driver data
+struct DisplayState {
+    flush_cb: Option<FlushCb>,
+    batcher: Option<Box<dyn FlushStage>>,
+    render_mode: RenderMode,
+    byte_order: ByteOrder,
+    probe: Option<Box<Probe>>,
+    /// Rotation applied by the panel through [`PanelRotation`]
+    panel_rotation: DisplayRotation,
+}
+
+impl Default for DisplayState {
+    fn default() -> Self {
+        Self {
+            flush_cb: None,
+            batcher: None,
+            render_mode: RenderMode::Partial,
+            byte_order: ByteOrder::Native,
+            probe: None,
+            panel_rotation: DisplayRotation::None,
+        }
+    }
+}
+
+/// Get the state for `disp`, creating it on first use
+unsafe fn display_state<'a>(disp: *mut sys::lv_display_t) -> &'a mut DisplayState {
+    let mut state = sys::lv_display_get_driver_data(disp) as *mut DisplayState;
+    if state.is_null() {
+        state = Box::into_raw(Box::<DisplayState>::default());
+        sys::lv_display_set_driver_data(disp, state as *mut c_void);
+        sys::lv_display_add_event_cb(
+            disp,
+            Some(display_delete_cb),
+            sys::LV_EVENT_DELETE,
+            state as *mut c_void,
+        );
+    }
+    &mut *state
+}
+
+/// Frame probe of `disp`, without creating display state
+pub(crate) unsafe fn frame_probe<'a>(disp: *mut sys::lv_display_t) -> Option<&'a mut Probe> {
+    let state = sys::lv_display_get_driver_data(disp) as *mut DisplayState;
+    if state.is_null() {
+        return None;
+    }
+    (*state).probe.as_deref_mut()
+}
+
+unsafe extern "C" fn display_delete_cb(e: *mut sys::lv_event_t) {
+    let state = sys::lv_event_get_user_data(e) as *mut DisplayState;
+    if !state.is_null() {
+        drop(Box::from_raw(state));
+    }
+}
+
+unsafe extern "C" fn flush_trampoline(
+    disp: *mut sys::lv_display_t,
+    area: *const sys::lv_area_t,
+    px_map: *mut u8,
+) {
+    let state = display_state(disp);
+
+    if state.byte_order == ByteOrder::Swapped
+        && !matches!(state.render_mode, RenderMode::Direct)
+        && sys::lv_display_get_color_format(disp) == ColorFormat::Rgb565 as u32
+    {
+        swap_rgb565(disp, state.render_mode, Area::from(*area), px_map);
+    }
+
+    if let Some(batcher) = state.batcher.as_mut() {
+        batcher.flush(disp, &*area, px_map);
+    } else if let Some(flush_cb) = state.flush_cb {
+        flush_cb(disp, area, px_map);
+    } else {
+        sys::lv_display_flush_ready(disp);
+    }
+}
+
+/// Swap the bytes of the RGB565 pixels of `area`, one row at a time
+///
+/// Rows are stride aligned, so a single run over `area.size()` pixels would
+/// swap the padding and miss the end of the last rows. In `Full` mode the
+/// rows are those of the whole frame.
+unsafe fn swap_rgb565(disp: *mut sys::lv_display_t, mode: RenderMode, area: Area, px_map: *mut u8) {
+    let width = area.width() as usize;
+    let (stride, start) = match mode {
+        RenderMode::Full => {
+            let hor_res = sys::lv_display_get_horizontal_resolution(disp) as u32;
+            let stride = ColorFormat::Rgb565.stride(hor_res);
+            (stride, area.y1 as usize * stride + area.x1 as usize * 2)
+        }
+        _ => (ColorFormat::Rgb565.stride(width as u32), 0),
+    };
+    let rows = area.height() as usize;
+    if stride == width * 2 {
+        sys::lv_draw_sw_rgb565_swap(px_map.add(start) as *mut c_void, area.size());
+        return;
+    }
+    for row in 0..rows {
+        let line = px_map.add(start + row * stride);
+        sys::lv_draw_sw_rgb565_swap(line as *mut c_void, width as u32);
+    }
+}
+
+/// Collects the areas of a refresh cycle and merges them before flushing
+pub struct FlushBatcher<S: FlushSink> {
+    sink: S,
+    render_mode: RenderMode,
+    setup_cost: u32,
+    areas: Vec<Area>,
+}
+
+impl<S: FlushSink> FlushBatcher<S> {
+    /// Create a batcher for the given render mode
+    pub fn new(sink: S, render_mode: RenderMode, setup_cost: u32) -> Self {
+        Self {
+            sink,
+            render_mode,
+            setup_cost,
+            areas: Vec::new(),
+        }
+    }
+
+    /// Get the wrapped sink
+    pub fn sink(&mut self) -> &mut S {
+        &mut self.sink
+    }
+}
+
+impl<S: FlushSink> FlushStage for FlushBatcher<S> {
+    unsafe fn flush(&mut self, disp: *mut sys::lv_display_t, area: &sys::lv_area_t, px_map: *mut u8) {
+        let format = ColorFormat::from_raw(sys::lv_display_get_color_format(disp))
+            .unwrap_or(ColorFormat::native());
+        let pixels = px_map.add(format.palette_size());
+        let mut area = Area::from(*area);
+
+        if let RenderMode::Partial = self.render_mode {
+            let stride = format.stride(area.width() as u32);
+            let data = slice::from_raw_parts(pixels, stride * area.height() as usize);
+            self.sink.flush_area(&area, data, stride);
+            sys::lv_display_flush_ready(disp);
+            return;
+        }
+
+        // The buffer holds the whole frame, px_map points at its start
+        let hor_res = sys::lv_display_get_horizontal_resolution(disp);
+        let bpp = format.bpp() as usize;
+        if bpp < 8 {
+            // Sub-byte formats can't start mid-byte, send whole rows
+            area.x1 = 0;
+            area.x2 = hor_res - 1;
+        }
+        self.areas.push(area);
+
+        if sys::lv_display_flush_is_last(disp) {
+            coalesce_areas(&mut self.areas, self.setup_cost);
+
+            let stride = format.stride(hor_res as u32);
+            for area in self.areas.drain(..) {
+                let offset = area.y1 as usize * stride + area.x1 as usize * bpp / 8;
+                let row_bytes = (area.width() as usize * bpp + 7) / 8;
+                let len = (area.height() as usize - 1) * stride + row_bytes;
+                let data = slice::from_raw_parts(pixels.add(offset), len);
+                self.sink.flush_area(&area, data, stride);
+            }
+        }
+
+        sys::lv_display_flush_ready(disp);
+    }
+}
+
+/// Merge areas while one window is cheaper than two
+///
+/// Each window costs `setup_cost` plus its pixel count; two areas are
+/// replaced by their bounding box when that lowers the total.
+pub fn coalesce_areas(areas: &mut Vec<Area>, setup_cost: u32) {
+    let mut merged = true;
+    while merged {
+        merged = false;
+        'search: for i in 0..areas.len() {
+            for j in (i + 1)..areas.len() {
+                let union = areas[i].union(&areas[j]);
+                let separate = 2 * setup_cost + areas[i].size() + areas[j].size();
+                if setup_cost + union.size() <= separate {
+                    areas[i] = union;
+                    areas.swap_remove(j);
+                    merged = true;
+                    break 'search;
+                }
+            }
+        }
+    }
+}
+
+/// Alignment used for allocated draw buffers
+///
+/// Covers LVGL's draw buffer alignment, DMA word alignment and the PSRAM
+/// cache line size on ESP32-S3.
+pub const DRAW_BUF_ALIGN: usize = 64;
+
+/// Draw buffer storage with DMA-friendly alignment
+///
+/// Use this for `static` buffers instead of a plain `[u8; N]`, which is only
+/// byte aligned.
+#[repr(C, align(64))]
+pub struct AlignedBuffer<const N: usize>([u8; N]);
+
+impl<const N: usize> AlignedBuffer<N> {
+    /// Create a zeroed buffer
+    pub const fn new() -> Self {
+        Self([0u8; N])
+    }
+
+    /// Get the buffer as a byte slice
+    pub fn as_mut_slice(&mut self) -> &mut [u8] {
+        &mut self.0
+    }
+}
+
+impl<const N: usize> Default for AlignedBuffer<N> {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+/// Memory source for draw buffers
+///
+/// Implement this to place buffers in a specific memory region, e.g. DMA
+/// capable internal RAM or PSRAM via `heap_caps_aligned_alloc` on ESP-IDF.
+pub trait BufferAllocator {
+    /// Allocate `size` bytes aligned to `align`
+    ///
+    /// Returns a null pointer if the allocation fails.
+    ///
+    /// # Safety
+    /// `align` must be a power of two.
+    unsafe fn allocate(&self, size: usize, align: usize) -> *mut u8;
+
+    /// Free a buffer returned by [`allocate`](Self::allocate)
+    ///
+    /// # Safety
+    /// `ptr` must come from `allocate` on this allocator with the same
+    /// `size` and `align`, and must no longer be used.
+    unsafe fn deallocate(&self, ptr: *mut u8, size: usize, align: usize);
+}
+
+/// Allocator that uses the global Rust allocator
+#[derive(Clone, Copy, Debug, Default)]
+pub struct HeapAllocator;
+
+impl BufferAllocator for HeapAllocator {
+    unsafe fn allocate(&self, size: usize, align: usize) -> *mut u8 {
+        match core::alloc::Layout::from_size_align(size, align) {
+            Ok(layout) if size > 0 => alloc::alloc::alloc_zeroed(layout),
+            _ => ptr::null_mut(),
+        }
+    }
+
+    unsafe fn deallocate(&self, ptr: *mut u8, size: usize, align: usize) {
+        if let Ok(layout) = core::alloc::Layout::from_size_align(size, align) {
+            alloc::alloc::dealloc(ptr, layout);
+        }
+    }
+}
+
+/// One to three draw buffers sized for a color format and render mode
+///
+/// Buffers stay allocated as long as LVGL may use them, i.e. for the
+/// lifetime of the display. A deleted display's buffers can be handed back
+/// with [`release`](Self::release).
+pub struct DisplayBuffers {
+    bufs: [*mut u8; 3],
+    count: usize,
+    size: usize,
+    format: ColorFormat,
+    render_mode: RenderMode,
+}
+
+impl DisplayBuffers {
+    /// Allocate `count` (1 to 3) equally sized draw buffers
+    ///
+    /// # Arguments
+    /// * `allocator` - Memory source for the buffers
+    /// * `format` - Pixel format (usually [`ColorFormat::native`])
+    /// * `width` - Horizontal resolution in pixels
+    /// * `height` - Vertical resolution in pixels
+    /// * `render_mode` - Render mode the buffers are used with
+    /// * `lines` - Buffer height in lines (only used for `Partial`)
+    /// * `count` - Number of buffers
+    pub fn allocate(
+        allocator: &impl BufferAllocator,
+        format: ColorFormat,
+        width: u32,
+        height: u32,
+        render_mode: RenderMode,
+        lines: u32,
+        count: usize,
+    ) -> Result<Self> {
+        if !(1..=3).contains(&count) || width == 0 || height == 0 {
+            return Err(LvglError::InvalidParameter);
+        }
+
+        let size = Self::required_size(format, width, height, render_mode, lines);
+        let mut bufs = [ptr::null_mut(); 3];
+        for i in 0..count {
+            let buf = unsafe { allocator.allocate(size, DRAW_BUF_ALIGN) };
+            if buf.is_null() {
+                // Undo the partial allocation, e.g. so a caller can retry in
+                // another memory region
+                for &buf in &bufs[..i] {
+                    unsafe { allocator.deallocate(buf, size, DRAW_BUF_ALIGN) };
+                }
+                return Err(LvglError::OutOfMemory);
+            }
+            bufs[i] = buf;
+        }
+
+        Ok(Self {
+            bufs,
+            count,
+            size,
+            format,
+            render_mode,
+        })
+    }
+
+    /// Wrap static buffers after checking them against the render mode
+    ///
+    /// All buffers must have the same length, and `Full`/`Direct` modes need
+    /// room for a whole frame.
+    pub fn from_static(
+        format: ColorFormat,
+        buf1: &'static mut [u8],
+        buf2: Option<&'static mut [u8]>,
+        buf3: Option<&'static mut [u8]>,
+        width: u32,
+        height: u32,
+        render_mode: RenderMode,
+    ) -> Result<Self> {
+        if buf2.is_none() && buf3.is_some() {
+            return Err(LvglError::InvalidParameter);
+        }
+
+        let size = buf1.len();
+        let min_size = match render_mode {
+            RenderMode::Partial => format.buf_size(width, 1),
+            RenderMode::Full | RenderMode::Direct => format.buf_size(width, height),
+        };
+        if size == 0 || size < min_size {
+            return Err(LvglError::InvalidParameter);
+        }
+
+        let mut bufs = [buf1.as_mut_ptr(), ptr::null_mut(), ptr::null_mut()];
+        let mut count = 1;
+        for buf in [buf2, buf3].into_iter().flatten() {
+            if buf.len() != size {
+                return Err(LvglError::InvalidParameter);
+            }
+            bufs[count] = buf.as_mut_ptr();
+            count += 1;
+        }
+
+        Ok(Self {
+            bufs,
+            count,
+            size,
+            format,
+            render_mode,
+        })
+    }
+
+    /// Size of each buffer for the given format, resolution and render mode
+    ///
+    /// `Full` and `Direct` modes always need a full frame; `Partial` mode
+    /// uses `lines` rows, clamped to the screen height.
+    pub const fn required_size(
+        format: ColorFormat,
+        width: u32,
+        height: u32,
+        render_mode: RenderMode,
+        lines: u32,
+    ) -> usize {
+        match render_mode {
+            RenderMode::Partial => {
+                let lines = if lines == 0 || lines > height { height } else { lines };
+                format.buf_size(width, lines)
+            }
+            RenderMode::Full | RenderMode::Direct => format.buf_size(width, height),
+        }
+    }
+
+    /// Number of buffers
+    pub fn count(&self) -> usize {
+        self.count
+    }
+
+    /// Size of each buffer in bytes
+    pub fn size(&self) -> usize {
+        self.size
+    }
+
+    /// Color format the buffers were sized for
+    pub fn format(&self) -> ColorFormat {
+        self.format
+    }
+
+    /// Render mode the buffers were sized for
+    pub fn render_mode(&self) -> RenderMode {
+        self.render_mode
+    }
+
+    /// Contents of buffer `index`, e.g. the frame in `Direct` mode
+    ///
+    /// LVGL may be rendering into the buffer; read it between
+    /// [`task_handler`](crate::task_handler) calls.
+    pub fn get(&self, index: usize) -> Option<&[u8]> {
+        if index < self.count {
+            Some(unsafe { slice::from_raw_parts(self.bufs[index], self.size) })
+        } else {
+            None
+        }
+    }
+
+    /// Third buffer, which LVGL does not use
+    ///
+    /// LVGL 9.2 renders into at most two buffers. The third one is kept for
+    /// the application, e.g. as a scan-out copy for panels with their own
+    /// frame memory.
+    pub fn spare(&mut self) -> Option<&mut [u8]> {
+        if self.count == 3 {
+            Some(unsafe { slice::from_raw_parts_mut(self.bufs[2], self.size) })
+        } else {
+            None
+        }
+    }
+
+    /// Free buffers from [`allocate`](Self::allocate), leaving none
+    ///
+    /// # Safety
+    /// `allocator` must be the one passed to `allocate`, and the display the
+    /// buffers were attached to must be deleted. Not for buffers from
+    /// [`from_static`](Self::from_static).
+    pub unsafe fn release(&mut self, allocator: &impl BufferAllocator) {
+        for &buf in &self.bufs[..self.count] {
+            allocator.deallocate(buf, self.size, DRAW_BUF_ALIGN);
+        }
+        self.bufs = [ptr::null_mut(); 3];
+        self.count = 0;
+    }
+}
+
 /// Helper to convert an area to coordinates
 pub fn area_to_coords(area: &sys::lv_area_t) -> (i32, i32, i32, i32) {
     (area.x1, area.y1, area.x2, area.y2)
 }
 
-/// Calculate buffer size needed for a given resolution and color depth
+/// Calculate buffer size needed for a given resolution in the native format
 ///
-/// For partial rendering, a buffer of 1/10th the screen is common.
+/// `lines` is clamped to `height`. For partial rendering, a buffer of 1/10th
+/// the screen is common.
 pub const fn calc_buf_size(width: u32, height: u32, lines: u32) -> usize {
-    // RGB565 = 2 bytes per pixel
-    (width * lines * 2) as usize
+    calc_buf_size_for(ColorFormat::native(), width, height, lines)
+}
+
+/// Calculate buffer size for a specific color format, including stride
+/// alignment and palette
+pub const fn calc_buf_size_for(format: ColorFormat, width: u32, height: u32, lines: u32) -> usize {
+    let lines = if lines > height { height } else { lines };
+    format.buf_size(width, lines)
 }
 
 /// Macro to create a static display buffer
+///
+/// An optional fifth argument selects a [`ColorFormat`] other than the
+/// native one.
 #[macro_export]
 macro_rules! display_buffer {
     ($name:ident, $width:expr, $height:expr, $lines:expr) => {
-        static mut $name: [u8; $crate::display::calc_buf_size($width, $height, $lines)] =
-            [0u8; $crate::display::calc_buf_size($width, $height, $lines)];
+        $crate::display_buffer!(
+            $name,
+            $width,
+            $height,
+            $lines,
+            $crate::display::ColorFormat::native()
+        );
+    };
+    ($name:ident, $width:expr, $height:expr, $lines:expr, $format:expr) => {
+        static mut $name: [u8; $crate::display::calc_buf_size_for($format, $width, $height, $lines)] =
+            [0u8; $crate::display::calc_buf_size_for($format, $width, $height, $lines)];
     };
 }
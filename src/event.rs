@@ -0,0 +1,215 @@
+//! Object event callbacks
+//!
+//! Callbacks registered with [`LvglObj::add_event_cb`](crate::LvglObj::add_event_cb)
+//! and friends are dropped when their object is deleted (`LV_EVENT_DELETE`),
+//! so screens can be created and deleted repeatedly without the heap growing.
+//!
+//! Where a callback lives depends on its size:
+//! - `fn` pointers and capture-less closures: nowhere, the pointer travels in
+//!   the event's user data
+//! - closures capturing up to [`INLINE_WORDS`] machine words: a slot in a
+//!   static slab
+//! - larger closures, or once the slab is full: a heap box
+//!
+//! Each callback gets its own monomorphized trampoline, so there is no
+//! second dynamic dispatch between LVGL and the closure.
+
+use crate::{Event, Obj};
+use alloc::boxed::Box;
+use alloc::vec::Vec;
+use core::ffi::c_void;
+use core::mem::{self, MaybeUninit};
+use core::ptr::{self, NonNull};
+use lvgl_sys as sys;
+
+// =============================================================================
+// Event info
+// =============================================================================
+
+/// The `lv_event_t` being dispatched, passed to event callbacks
+pub struct EventInfo {
+    raw: *mut sys::lv_event_t,
+}
+
+impl EventInfo {
+    /// Wrap a raw event (only valid during its dispatch)
+    ///
+    /// # Safety
+    /// `raw` must point to the event currently being dispatched.
+    pub unsafe fn from_raw(raw: *mut sys::lv_event_t) -> Self {
+        Self { raw }
+    }
+
+    /// Raw event pointer
+    pub fn raw(&self) -> *mut sys::lv_event_t {
+        self.raw
+    }
+
+    /// Event code (`LV_EVENT_*`)
+    pub fn code(&self) -> u32 {
+        unsafe { sys::lv_event_get_code(self.raw) }
+    }
+
+    /// True if this is `event`
+    pub fn is(&self, event: Event) -> bool {
+        self.code() == event as u32
+    }
+
+    /// Object the event was originally sent to
+    pub fn target(&self) -> Obj {
+        unsafe { Obj::from_raw(sys::lv_event_get_target_obj(self.raw)) }
+    }
+
+    /// Object whose callback is running (differs from `target` when bubbling)
+    pub fn current_target(&self) -> Obj {
+        unsafe { Obj::from_raw(sys::lv_event_get_current_target_obj(self.raw)) }
+    }
+
+    /// Event-specific parameter (`lv_event_get_param`)
+    pub fn param(&self) -> *mut c_void {
+        unsafe { sys::lv_event_get_param(self.raw) }
+    }
+
+    /// Don't bubble the event further up to parents
+    pub fn stop_bubbling(&self) {
+        unsafe { sys::lv_event_stop_bubbling(self.raw) }
+    }
+}
+
+// =============================================================================
+// Inline slab
+// =============================================================================
+
+/// Largest closure capture, in machine words, stored without a heap allocation
+pub const INLINE_WORDS: usize = 3;
+
+/// Number of slab slots (one bit each in `Slab::used`)
+const SLAB_SLOTS: usize = 64;
+
+#[derive(Clone, Copy)]
+#[repr(C, align(8))]
+struct InlineSlot(MaybeUninit<[usize; INLINE_WORDS]>);
+
+struct Slab {
+    slots: [InlineSlot; SLAB_SLOTS],
+    used: u64,
+}
+
+static mut SLAB: Slab = Slab {
+    slots: [InlineSlot(MaybeUninit::uninit()); SLAB_SLOTS],
+    used: 0,
+};
+
+/// Take a free slot for an `F`, if it fits
+unsafe fn slab_alloc<F>() -> Option<*mut F> {
+    if mem::size_of::<F>() > mem::size_of::<InlineSlot>()
+        || mem::align_of::<F>() > mem::align_of::<InlineSlot>()
+    {
+        return None;
+    }
+    let slab = &mut *ptr::addr_of_mut!(SLAB);
+    let free = !slab.used;
+    if free == 0 {
+        return None;
+    }
+    let idx = free.trailing_zeros() as usize;
+    slab.used |= 1 << idx;
+    Some(slab.slots[idx].0.as_mut_ptr() as *mut F)
+}
+
+/// Slot index of `ptr`, if it points into the slab
+unsafe fn slab_index(ptr: *mut c_void) -> Option<usize> {
+    let base = ptr::addr_of_mut!(SLAB.slots) as usize;
+    let offset = (ptr as usize).wrapping_sub(base);
+    if offset < SLAB_SLOTS * mem::size_of::<InlineSlot>() {
+        Some(offset / mem::size_of::<InlineSlot>())
+    } else {
+        None
+    }
+}
+
+// =============================================================================
+// Registration
+// =============================================================================
+
+/// Callback trampolines currently on the stack
+static mut DISPATCH_DEPTH: u32 = 0;
+
+/// Callbacks whose object was deleted from inside a callback
+static mut DEFERRED_FREES: Vec<(*mut c_void, unsafe fn(*mut c_void))> = Vec::new();
+
+/// Register `callback` for `filter` on `obj`, freeing it on `LV_EVENT_DELETE`
+pub(crate) fn add_closure<F>(obj: *mut sys::lv_obj_t, filter: u32, callback: F)
+where
+    F: FnMut(&EventInfo) + 'static,
+{
+    unsafe {
+        if mem::size_of::<F>() == 0 && !mem::needs_drop::<F>() {
+            // Nothing to store or free; any aligned pointer is a valid `F`
+            mem::forget(callback);
+            let data = NonNull::<F>::dangling().as_ptr() as *mut c_void;
+            sys::lv_obj_add_event_cb(obj, Some(call_closure::<F>), filter, data);
+            return;
+        }
+
+        let data = match slab_alloc::<F>() {
+            Some(slot) => {
+                slot.write(callback);
+                slot
+            }
+            None => Box::into_raw(Box::new(callback)),
+        } as *mut c_void;
+
+        sys::lv_obj_add_event_cb(obj, Some(call_closure::<F>), filter, data);
+        // Registered after the callback, so it runs last on delete
+        sys::lv_obj_add_event_cb(obj, Some(drop_closure::<F>), sys::LV_EVENT_DELETE, data);
+    }
+}
+
+/// Register a plain function for `filter` on `obj` (no storage at all)
+pub(crate) fn add_fn(obj: *mut sys::lv_obj_t, filter: u32, callback: fn(&EventInfo)) {
+    unsafe {
+        sys::lv_obj_add_event_cb(obj, Some(call_fn), filter, callback as *mut c_void);
+    }
+}
+
+unsafe extern "C" fn call_closure<F: FnMut(&EventInfo)>(e: *mut sys::lv_event_t) {
+    let callback = sys::lv_event_get_user_data(e) as *mut F;
+    DISPATCH_DEPTH += 1;
+    (*callback)(&EventInfo::from_raw(e));
+    DISPATCH_DEPTH -= 1;
+
+    if DISPATCH_DEPTH == 0 {
+        let deferred = &mut *ptr::addr_of_mut!(DEFERRED_FREES);
+        for (data, release) in deferred.drain(..) {
+            release(data);
+        }
+    }
+}
+
+unsafe extern "C" fn call_fn(e: *mut sys::lv_event_t) {
+    // Only ever set from a `fn(&EventInfo)` in add_fn()
+    let callback: fn(&EventInfo) = mem::transmute(sys::lv_event_get_user_data(e));
+    callback(&EventInfo::from_raw(e));
+}
+
+unsafe extern "C" fn drop_closure<F>(e: *mut sys::lv_event_t) {
+    let data = sys::lv_event_get_user_data(e);
+    if DISPATCH_DEPTH > 0 {
+        // The object was deleted from a callback, which may be this one:
+        // free once the outermost callback has returned
+        (*ptr::addr_of_mut!(DEFERRED_FREES)).push((data, release::<F>));
+    } else {
+        release::<F>(data);
+    }
+}
+
+unsafe fn release<F>(data: *mut c_void) {
+    match slab_index(data) {
+        Some(idx) => {
+            ptr::drop_in_place(data as *mut F);
+            (*ptr::addr_of_mut!(SLAB)).used &= !(1 << idx);
+        }
+        None => drop(Box::from_raw(data as *mut F)),
+    }
+}
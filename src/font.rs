@@ -0,0 +1,307 @@
+//! Fonts
+//!
+//! [`Font`] is a borrowed `lv_font_t`. Styles keep a pointer to their font,
+//! so the setters take `&'static Font`: the built-in default font, one
+//! mapped from an [`AssetPack`](crate::assets::AssetPack) or a leaked
+//! [`LoadedFont`], all living for the rest of the program.
+//!
+//! Optional features add fonts loaded at run time:
+//!
+//! - `font-loader`: [`LoadedFont::from_binfont`] reads an `lv_binfont` file
+//!   (`lv_font_conv --format bin`) into the LVGL heap. Mapped fonts that
+//!   should stay in flash go into an asset pack instead.
+//! - `font-compressed`: bitmap fonts with compressed glyphs
+//!   (`lv_font_conv` without `--no-compress`), which take less flash than
+//!   plain ones. Glyphs are decompressed while drawing.
+//! - `tiny-ttf`: [`LoadedFont::from_ttf`] renders a TrueType font at any
+//!   size. Rendered glyphs are kept in an LRU cache bounded by
+//!   [`GlyphCache`], so each glyph is rasterized once while it stays in use.
+//!
+//! ```ignore
+//! static DASHBOARD_TTF: &[u8] = include_bytes!("../fonts/dashboard.ttf");
+//!
+//! // 96 px digits for the speed readout, about 256 KiB of cached glyphs
+//! let digits = LoadedFont::from_ttf(DASHBOARD_TTF, 96, GlyphCache::budget(256 * 1024, 96))?;
+//! speed.set_style_text_font(digits.leak(), 0);
+//! ```
+
+#[cfg(any(feature = "font-loader", feature = "tiny-ttf"))]
+use crate::{LvglError, Result};
+#[cfg(any(feature = "font-loader", feature = "tiny-ttf"))]
+use core::ptr::NonNull;
+use lvgl_sys as sys;
+
+/// An LVGL font (`lv_font_t`)
+#[repr(transparent)]
+pub struct Font(sys::lv_font_t);
+
+impl Font {
+    /// Font used when a style sets none (`LV_FONT_DEFAULT`)
+    pub fn default_font() -> &'static Font {
+        unsafe { Self::from_raw(sys::lv_font_get_default()) }
+    }
+
+    /// Wrap a font pointer
+    ///
+    /// # Safety
+    /// `raw` must point to a valid font that outlives `'a`.
+    pub unsafe fn from_raw<'a>(raw: *const sys::lv_font_t) -> &'a Font {
+        &*(raw as *const Font)
+    }
+
+    /// Raw font pointer
+    pub fn raw(&self) -> *const sys::lv_font_t {
+        &self.0
+    }
+
+    /// Line height in pixels
+    pub fn line_height(&self) -> i32 {
+        self.0.line_height
+    }
+
+    /// Distance of the baseline from the bottom of a line, in pixels
+    pub fn base_line(&self) -> i32 {
+        self.0.base_line
+    }
+}
+
+// =============================================================================
+// Loaded fonts
+// =============================================================================
+
+/// Bound of a TrueType font's cache of rendered glyphs
+///
+/// The least recently drawn glyph is dropped when the cache is full.
+#[cfg(feature = "tiny-ttf")]
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub struct GlyphCache {
+    glyphs: usize,
+}
+
+#[cfg(feature = "tiny-ttf")]
+impl GlyphCache {
+    /// Keep up to `glyphs` rendered glyphs
+    pub const fn glyphs(glyphs: usize) -> Self {
+        Self {
+            glyphs: if glyphs == 0 { 1 } else { glyphs },
+        }
+    }
+
+    /// Keep roughly `bytes` of glyphs rendered at `font_size` pixels
+    ///
+    /// An estimate, not a bound. Each glyph is counted as an 8-bit alpha
+    /// draw buffer of `2 * font_size` by `font_size` pixels, with its
+    /// stride alignment and header, plus its entries in tiny_ttf's glyph
+    /// and draw-data caches. Few glyphs are wider than that.
+    pub const fn budget(bytes: usize, font_size: i32) -> Self {
+        let size = if font_size > 0 { font_size as usize } else { 1 };
+        let align = sys::LV_DRAW_BUF_STRIDE_ALIGN as usize;
+        let stride = (2 * size + align - 1) / align * align;
+        let per_glyph = stride * size
+            + sys::LV_DRAW_BUF_ALIGN as usize
+            + core::mem::size_of::<sys::lv_draw_buf_t>()
+            + 2 * core::mem::size_of::<sys::lv_font_glyph_dsc_t>();
+        Self::glyphs(bytes / per_glyph)
+    }
+
+    /// Number of glyphs kept
+    pub const fn glyph_count(&self) -> usize {
+        self.glyphs
+    }
+}
+
+#[cfg(feature = "tiny-ttf")]
+impl Default for GlyphCache {
+    /// `LV_TINY_TTF_CACHE_GLYPH_CNT` glyphs
+    fn default() -> Self {
+        Self::glyphs(sys::LV_TINY_TTF_CACHE_GLYPH_CNT as usize)
+    }
+}
+
+#[cfg(any(feature = "font-loader", feature = "tiny-ttf"))]
+enum FontKind {
+    #[cfg(feature = "font-loader")]
+    Binfont,
+    #[cfg(feature = "tiny-ttf")]
+    TinyTtf,
+}
+
+/// Font created at run time, freed on drop
+///
+/// Derefs to [`Font`]. Style setters need `&'static Font`, so a font used
+/// in styles is [`leak`](Self::leak)ed once loaded.
+#[cfg(any(feature = "font-loader", feature = "tiny-ttf"))]
+pub struct LoadedFont {
+    raw: NonNull<sys::lv_font_t>,
+    kind: FontKind,
+}
+
+#[cfg(any(feature = "font-loader", feature = "tiny-ttf"))]
+impl LoadedFont {
+    fn new(raw: *mut sys::lv_font_t, kind: FontKind) -> Result<Self> {
+        NonNull::new(raw)
+            .map(|raw| Self { raw, kind })
+            .ok_or(LvglError::InvalidParameter)
+    }
+
+    /// Load an `lv_binfont` font from memory
+    ///
+    /// LVGL copies the whole font, glyph bitmaps included, into its heap,
+    /// so `data` only has to stay valid during the call. For large fonts in
+    /// mapped flash that costs as much RAM as the font file; an
+    /// [`AssetPack`](crate::assets::AssetPack) font is used in place
+    /// instead. Fonts with compressed glyphs need the
+    /// `font-compressed` feature and are rejected without it.
+    #[cfg(feature = "font-loader")]
+    pub fn from_binfont(data: &[u8]) -> Result<Self> {
+        let raw = unsafe {
+            sys::lv_binfont_create_from_buffer(data.as_ptr() as *mut _, data.len() as u32)
+        };
+        let font = Self::new(raw, FontKind::Binfont)?;
+        let dsc = unsafe { &*((*raw).dsc as *const sys::lv_font_fmt_txt_dsc_t) };
+        if !cfg!(feature = "font-compressed")
+            && dsc.bitmap_format() != sys::LV_FONT_FMT_TXT_PLAIN as _
+        {
+            return Err(LvglError::InvalidParameter);
+        }
+        Ok(font)
+    }
+
+    /// Render a TrueType font at `size` pixels, caching up to `cache`
+    /// rendered glyphs
+    ///
+    /// The font file is used in place and must stay mapped.
+    #[cfg(feature = "tiny-ttf")]
+    pub fn from_ttf(data: &'static [u8], size: i32, cache: GlyphCache) -> Result<Self> {
+        let raw = unsafe {
+            sys::lv_tiny_ttf_create_data_ex(
+                data.as_ptr() as *const _,
+                data.len(),
+                size,
+                sys::LV_FONT_KERNING_NORMAL,
+                cache.glyphs,
+            )
+        };
+        let font = Self::new(raw, FontKind::TinyTtf)?;
+        #[cfg(feature = "mem-rust")]
+        unsafe {
+            ttf_heap::route(raw)
+        };
+        Ok(font)
+    }
+
+    /// Change the pixel size of a TrueType font, dropping its cached glyphs
+    ///
+    /// Fails for bitmap fonts, which have one size.
+    pub fn set_size(&mut self, size: i32) -> Result<()> {
+        match self.kind {
+            #[cfg(feature = "tiny-ttf")]
+            FontKind::TinyTtf => {
+                unsafe {
+                    sys::lv_tiny_ttf_set_size(self.raw.as_ptr(), size);
+                    #[cfg(feature = "mem-rust")]
+                    ttf_heap::route(self.raw.as_ptr());
+                }
+                Ok(())
+            }
+            #[allow(unreachable_patterns)]
+            _ => {
+                let _ = size;
+                Err(LvglError::InvalidParameter)
+            }
+        }
+    }
+
+    /// Keep the font for the rest of the program
+    pub fn leak(self) -> &'static Font {
+        let raw = self.raw.as_ptr();
+        core::mem::forget(self);
+        unsafe { Font::from_raw(raw) }
+    }
+}
+
+#[cfg(any(feature = "font-loader", feature = "tiny-ttf"))]
+impl core::ops::Deref for LoadedFont {
+    type Target = Font;
+
+    fn deref(&self) -> &Font {
+        unsafe { Font::from_raw(self.raw.as_ptr()) }
+    }
+}
+
+#[cfg(any(feature = "font-loader", feature = "tiny-ttf"))]
+impl Drop for LoadedFont {
+    fn drop(&mut self) {
+        unsafe {
+            match self.kind {
+                #[cfg(feature = "font-loader")]
+                FontKind::Binfont => sys::lv_binfont_destroy(self.raw.as_ptr()),
+                #[cfg(feature = "tiny-ttf")]
+                FontKind::TinyTtf => sys::lv_tiny_ttf_destroy(self.raw.as_ptr()),
+            }
+        }
+    }
+}
+
+/// Keeps tiny_ttf's glyph caches out of screen arenas
+///
+/// Laying out text inside [`ScreenArena::build`](crate::mem::ScreenArena)
+/// adds glyphs to the font's caches, which outlive the screen. The font's
+/// glyph callbacks are wrapped so they allocate from the heap.
+#[cfg(all(feature = "tiny-ttf", feature = "mem-rust"))]
+mod ttf_heap {
+    use core::ffi::c_void;
+    use core::mem;
+    use core::sync::atomic::{AtomicUsize, Ordering};
+    use lvgl_sys as sys;
+
+    type GlyphDscFn = unsafe extern "C" fn(
+        *const sys::lv_font_t,
+        *mut sys::lv_font_glyph_dsc_t,
+        u32,
+        u32,
+    ) -> bool;
+    type GlyphBitmapFn = unsafe extern "C" fn(
+        *mut sys::lv_font_glyph_dsc_t,
+        *mut sys::lv_draw_buf_t,
+    ) -> *const c_void;
+
+    /// tiny_ttf's own callbacks, the same for all its fonts
+    static GLYPH_DSC: AtomicUsize = AtomicUsize::new(0);
+    static GLYPH_BITMAP: AtomicUsize = AtomicUsize::new(0);
+
+    /// Swap the font's glyph callbacks for the wrappers below
+    pub(super) unsafe fn route(font: *mut sys::lv_font_t) {
+        let font = &mut *font;
+        if let Some(cb) = font.get_glyph_dsc {
+            if cb as usize != glyph_dsc as usize {
+                GLYPH_DSC.store(cb as usize, Ordering::Relaxed);
+                font.get_glyph_dsc = Some(glyph_dsc);
+            }
+        }
+        if let Some(cb) = font.get_glyph_bitmap {
+            if cb as usize != glyph_bitmap as usize {
+                GLYPH_BITMAP.store(cb as usize, Ordering::Relaxed);
+                font.get_glyph_bitmap = Some(glyph_bitmap);
+            }
+        }
+    }
+
+    unsafe extern "C" fn glyph_dsc(
+        font: *const sys::lv_font_t,
+        dsc: *mut sys::lv_font_glyph_dsc_t,
+        letter: u32,
+        letter_next: u32,
+    ) -> bool {
+        let cb: GlyphDscFn = mem::transmute(GLYPH_DSC.load(Ordering::Relaxed));
+        crate::mem::outside_arena(|| cb(font, dsc, letter, letter_next))
+    }
+
+    unsafe extern "C" fn glyph_bitmap(
+        dsc: *mut sys::lv_font_glyph_dsc_t,
+        draw_buf: *mut sys::lv_draw_buf_t,
+    ) -> *const c_void {
+        let cb: GlyphBitmapFn = mem::transmute(GLYPH_BITMAP.load(Ordering::Relaxed));
+        crate::mem::outside_arena(|| cb(dsc, draw_buf))
+    }
+}
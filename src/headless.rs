@@ -0,0 +1,378 @@
+//! Headless display with a virtual clock
+//!
+//! [`Headless`] renders into a frame buffer in memory, with no window and
+//! no real time: LVGL's clock only moves when [`Headless::advance`] or one
+//! of the stepping helpers moves it. A run is as fast as the CPU allows and
+//! gives the same frames on every machine, which suits benchmarks and
+//! golden-image tests.
+//!
+//! ```ignore
+//! lvgl::init()?;
+//! let hl = Headless::new(320, 240)?;
+//! build_ui(&lvgl::screen_active().unwrap())?;
+//!
+//! hl.step(16);                    // one 16 ms frame
+//! hl.run_until_idle(5_000);       // finish running animations
+//! assert_eq!(hl.frame_hash(), GOLDEN);
+//! hl.write_ppm(&mut File::create("frame.ppm")?)?;
+//! ```
+//!
+//! The clock is LVGL's tick source, so it is shared by every display. A
+//! `Headless` makes itself the default display, and dropping it deletes the
+//! display along with its screens and frees its buffers.
+//!
+//! [`Headless::with_mode`] renders through small `Partial` buffers or a
+//! `Full` frame instead, copying every flushed area into the frame like a
+//! panel would. With [`Headless::set_flush_clock`] the time spent in those
+//! copies is added up in [`FlushStats::flush_us`].
+
+use crate::display::{
+    Area, ColorFormat, Display, DisplayBuffers, FlushSink, HeapAllocator, RenderMode,
+};
+use crate::Result;
+use alloc::boxed::Box;
+use alloc::rc::Rc;
+use core::cell::Cell;
+use core::sync::atomic::{AtomicU32, Ordering};
+use lvgl_sys as sys;
+
+/// Virtual milliseconds since start
+static VIRTUAL_MS: AtomicU32 = AtomicU32::new(0);
+
+unsafe extern "C" fn virtual_tick() -> u32 {
+    VIRTUAL_MS.load(Ordering::Relaxed)
+}
+
+/// Flush counters since the last [`Headless::take_stats`]
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub struct FlushStats {
+    /// Refresh cycles that flushed anything
+    pub frames: u32,
+    /// Flushed areas
+    pub areas: u32,
+    /// Flushed pixels
+    pub pixels: u64,
+    /// Microseconds spent flushing, if a clock is set
+    pub flush_us: u64,
+}
+
+/// State shared with the flush sink
+#[derive(Default)]
+struct Shared {
+    stats: Cell<FlushStats>,
+    clock: Cell<Option<fn() -> u64>>,
+}
+
+/// Counts flushed areas and copies them into the frame
+///
+/// In `Direct` mode `frame` is null: LVGL already drew into the frame.
+struct Recorder {
+    shared: Rc<Shared>,
+    frame: *mut u8,
+    frame_stride: usize,
+    bpp: usize,
+}
+
+impl FlushSink for Recorder {
+    fn flush_area(&mut self, area: &Area, data: &[u8], stride: usize) {
+        let clock = self.shared.clock.get();
+        let start = clock.map_or(0, |now| now());
+
+        if !self.frame.is_null() {
+            let row_bytes = (area.width() as usize * self.bpp + 7) / 8;
+            let x_offset = area.x1 as usize * self.bpp / 8;
+            for (i, src) in data.chunks(stride).take(area.height() as usize).enumerate() {
+                let offset = (area.y1 as usize + i) * self.frame_stride + x_offset;
+                unsafe {
+                    core::ptr::copy_nonoverlapping(
+                        src.as_ptr(),
+                        self.frame.add(offset),
+                        row_bytes.min(src.len()),
+                    );
+                }
+            }
+        }
+
+        let mut stats = self.shared.stats.get();
+        stats.areas += 1;
+        stats.pixels += area.size() as u64;
+        if let Some(now) = clock {
+            stats.flush_us += now().saturating_sub(start);
+        }
+        self.shared.stats.set(stats);
+    }
+}
+
+/// An off-screen LVGL display driven by a virtual clock
+pub struct Headless {
+    display: Display,
+    buffers: DisplayBuffers,
+    /// Frame the flushed areas are copied into, if not drawn in place
+    frame: Option<Box<[u8]>>,
+    mode: RenderMode,
+    width: u32,
+    height: u32,
+    shared: Rc<Shared>,
+}
+
+impl Headless {
+    /// Create a display with a native-format frame buffer
+    ///
+    /// Call after [`init`](crate::init). Installs the virtual clock as
+    /// LVGL's tick source.
+    pub fn new(width: u32, height: u32) -> Result<Self> {
+        Self::with_format(width, height, ColorFormat::native())
+    }
+
+    /// Create a display with a frame buffer in `format`
+    pub fn with_format(width: u32, height: u32, format: ColorFormat) -> Result<Self> {
+        Self::with_mode(width, height, format, RenderMode::Direct, 0)
+    }
+
+    /// Create a display that renders in `mode`
+    ///
+    /// In `Direct` mode LVGL draws straight into the frame and nothing is
+    /// copied on flush. `Partial` renders `lines` rows at a time and `Full`
+    /// a whole frame into a draw buffer; each flushed area is then copied
+    /// into a separate frame buffer.
+    pub fn with_mode(
+        width: u32,
+        height: u32,
+        format: ColorFormat,
+        mode: RenderMode,
+        lines: u32,
+    ) -> Result<Self> {
+        let display = Display::create(width, height)?;
+        let buffers =
+            DisplayBuffers::allocate(&HeapAllocator, format, width, height, mode, lines, 1)?;
+        display.attach_buffers(&buffers);
+
+        let frame_stride = format.stride(width);
+        let mut frame = match mode {
+            RenderMode::Direct => None,
+            _ => Some(
+                alloc::vec![0u8; format.palette_size() + frame_stride * height as usize]
+                    .into_boxed_slice(),
+            ),
+        };
+
+        let shared = Rc::new(Shared::default());
+        // No merging: every area LVGL redrew is counted as it is
+        let recorder = Recorder {
+            shared: shared.clone(),
+            frame: frame.as_mut().map_or(core::ptr::null_mut(), |f| unsafe {
+                f.as_mut_ptr().add(format.palette_size())
+            }),
+            frame_stride,
+            bpp: format.bpp() as usize,
+        };
+        display.set_flush_batcher(recorder, mode, 0);
+        crate::set_tick_source(virtual_tick);
+        unsafe { sys::lv_display_set_default(display.raw()) }
+
+        Ok(Self {
+            display,
+            buffers,
+            frame,
+            mode,
+            width,
+            height,
+            shared,
+        })
+    }
+
+    /// The LVGL display
+    pub fn display(&self) -> &Display {
+        &self.display
+    }
+
+    /// Virtual time in milliseconds
+    pub fn now(&self) -> u32 {
+        VIRTUAL_MS.load(Ordering::Relaxed)
+    }
+
+    /// Move the clock forward without running LVGL
+    pub fn advance(&self, ms: u32) {
+        VIRTUAL_MS.fetch_add(ms, Ordering::Relaxed);
+    }
+
+    /// Advance the clock by `ms` and run LVGL's timers once
+    ///
+    /// Returns the time until the next timer, as [`task_handler`](crate::task_handler).
+    pub fn step(&self, ms: u32) -> u32 {
+        self.advance(ms);
+        self.handle()
+    }
+
+    /// Run fixed `frame_ms` steps until `duration_ms` of virtual time passed
+    pub fn run_for(&self, duration_ms: u32, frame_ms: u32) {
+        let frame_ms = frame_ms.max(1);
+        let mut elapsed = 0;
+        while elapsed < duration_ms {
+            let ms = frame_ms.min(duration_ms - elapsed);
+            self.step(ms);
+            elapsed += ms;
+        }
+    }
+
+    /// Jump from timer to timer until LVGL has nothing left to do
+    ///
+    /// Stops when every timer is paused, or after `max_ms` of virtual time
+    /// (e.g. with a periodic timer that never pauses). Returns the virtual
+    /// time spent.
+    pub fn run_until_idle(&self, max_ms: u32) -> u32 {
+        let start = self.now();
+        let mut next = self.handle();
+        loop {
+            let elapsed = self.now().wrapping_sub(start);
+            if next == sys::LV_NO_TIMER_READY || elapsed >= max_ms {
+                return elapsed;
+            }
+            next = self.step(next.clamp(1, max_ms - elapsed));
+        }
+    }
+
+    /// Redraw every invalidated area now, without running timers
+    pub fn refresh(&self) {
+        let areas = self.shared.stats.get().areas;
+        unsafe { sys::lv_refr_now(self.display.raw()) }
+        self.count_frame(areas);
+    }
+
+    /// Flush counters since the last call
+    pub fn take_stats(&self) -> FlushStats {
+        self.shared.stats.take()
+    }
+
+    /// Time every flush with `now_us`, a microsecond clock
+    ///
+    /// The virtual clock can't be used for this: it stands still while
+    /// LVGL renders.
+    pub fn set_flush_clock(&self, now_us: fn() -> u64) {
+        self.shared.clock.set(Some(now_us));
+    }
+
+    /// Render mode the display was created with
+    pub fn render_mode(&self) -> RenderMode {
+        self.mode
+    }
+
+    /// Width in pixels
+    pub fn width(&self) -> u32 {
+        self.width
+    }
+
+    /// Height in pixels
+    pub fn height(&self) -> u32 {
+        self.height
+    }
+
+    /// Pixel format of the frame
+    pub fn format(&self) -> ColorFormat {
+        self.buffers.format()
+    }
+
+    /// Bytes from one row of the frame to the next
+    pub fn stride(&self) -> usize {
+        self.format().stride(self.width)
+    }
+
+    /// The rendered frame, `stride()` bytes per row
+    pub fn frame(&self) -> &[u8] {
+        let frame = match &self.frame {
+            Some(frame) => frame,
+            None => self.buffers.get(0).unwrap_or(&[]),
+        };
+        let palette = self.format().palette_size();
+        &frame[palette..palette + self.stride() * self.height as usize]
+    }
+
+    /// One row of the frame without stride padding
+    pub fn row(&self, y: u32) -> &[u8] {
+        let row_bytes = (self.width as usize * self.format().bpp() as usize + 7) / 8;
+        let start = y as usize * self.stride();
+        &self.frame()[start..start + row_bytes]
+    }
+
+    /// 64-bit FNV-1a hash of the visible pixels, for golden-image checks
+    pub fn frame_hash(&self) -> u64 {
+        let mut hash = 0xcbf2_9ce4_8422_2325u64;
+        for y in 0..self.height {
+            for &b in self.row(y) {
+                hash = (hash ^ b as u64).wrapping_mul(0x0100_0000_01b3);
+            }
+        }
+        hash
+    }
+
+    /// Pixel at (`x`, `y`) as 8-bit RGB
+    ///
+    /// Indexed and alpha-only formats are returned as gray levels.
+    pub fn pixel(&self, x: u32, y: u32) -> [u8; 3] {
+        let row = self.row(y);
+        let x = x as usize;
+        match self.format() {
+            ColorFormat::Rgb565 => {
+                let v = u16::from_ne_bytes([row[x * 2], row[x * 2 + 1]]);
+                let r = ((v >> 11) & 0x1f) as u8;
+                let g = ((v >> 5) & 0x3f) as u8;
+                let b = (v & 0x1f) as u8;
+                [r << 3 | r >> 2, g << 2 | g >> 4, b << 3 | b >> 2]
+            }
+            ColorFormat::Rgb888 => [row[x * 3 + 2], row[x * 3 + 1], row[x * 3]],
+            ColorFormat::Argb8888 | ColorFormat::Xrgb8888 => {
+                [row[x * 4 + 2], row[x * 4 + 1], row[x * 4]]
+            }
+            ColorFormat::L8 | ColorFormat::A8 | ColorFormat::I8 => [row[x]; 3],
+            format => {
+                let bpp = format.bpp() as usize;
+                let bit = x * bpp;
+                let max = (1u16 << bpp) - 1;
+                let v = (row[bit / 8] >> (8 - bpp - bit % 8)) as u16 & max;
+                [(v * 255 / max) as u8; 3]
+            }
+        }
+    }
+
+    /// Write the frame as a binary PPM (P6) image
+    #[cfg(feature = "std")]
+    pub fn write_ppm(&self, out: &mut impl std::io::Write) -> std::io::Result<()> {
+        write!(out, "P6\n{} {}\n255\n", self.width, self.height)?;
+        let mut line = alloc::vec::Vec::with_capacity(self.width as usize * 3);
+        for y in 0..self.height {
+            line.clear();
+            for x in 0..self.width {
+                line.extend_from_slice(&self.pixel(x, y));
+            }
+            out.write_all(&line)?;
+        }
+        Ok(())
+    }
+
+    fn handle(&self) -> u32 {
+        let areas = self.shared.stats.get().areas;
+        let next = crate::task_handler();
+        self.count_frame(areas);
+        next
+    }
+
+    /// Count a refresh cycle if it flushed areas beyond `areas_before`
+    fn count_frame(&self, areas_before: u32) {
+        let mut stats = self.shared.stats.get();
+        if stats.areas != areas_before {
+            stats.frames += 1;
+            self.shared.stats.set(stats);
+        }
+    }
+}
+
+impl Drop for Headless {
+    fn drop(&mut self) {
+        unsafe {
+            // Also frees the recorder, before the frame it copies into
+            sys::lv_display_delete(self.display.raw());
+            // LVGL is done with the draw buffer
+            self.buffers.release(&HeapAllocator);
+        }
+    }
+}
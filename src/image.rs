@@ -0,0 +1,158 @@
+//! Image sources and the decoded image cache
+//!
+//! [`ImageDsc`] wraps `lv_image_dsc_t` for image data linked into the
+//! binary (flash on the ESP32). It can be built in a `static`, so the
+//! descriptor costs no RAM:
+//!
+//! ```ignore
+//! static LOGO: ImageDsc = ImageDsc::encoded(include_bytes!("logo.png"));
+//! static ICONS: ImageDsc =
+//!     ImageDsc::compressed(96, 32, ColorFormat::Argb8888, include_bytes!("icons.lz4"));
+//!
+//! image.set_image(&LOGO);
+//! lvgl::image::set_cache_size(256 * 1024);
+//! ```
+//!
+//! Encoded (PNG/JPEG) and compressed (RLE/LZ4) images are decoded when first
+//! drawn and kept in LVGL's image cache, which evicts the least recently used
+//! entries once its byte budget is exceeded. Decoding needs the matching
+//! cargo feature: `png`, `jpeg` or `image-compress`.
+
+use crate::display::ColorFormat;
+use core::ffi::c_void;
+use core::mem;
+use lvgl_sys as sys;
+
+/// Compressed data header size: method, compressed and decompressed size
+pub(crate) const COMPRESSED_HEADER: usize = 12;
+
+/// Image data in memory (`lv_image_dsc_t`)
+#[repr(transparent)]
+pub struct ImageDsc(sys::lv_image_dsc_t);
+
+// Only points to immutable 'static data
+unsafe impl Sync for ImageDsc {}
+
+impl ImageDsc {
+    /// Uncompressed pixels, rows packed without padding
+    ///
+    /// Indexed formats start with their palette. Panics (at compile time in a
+    /// `static`) if `data` is too short.
+    pub const fn raw(width: u16, height: u16, format: ColorFormat, data: &'static [u8]) -> Self {
+        let stride = packed_stride(width, format);
+        assert!(
+            data.len() >= format.palette_size() + stride * height as usize,
+            "image data shorter than width * height"
+        );
+        Self::new(format as u32, 0, width, height, stride as u16, data)
+    }
+
+    /// RLE or LZ4 compressed pixels, as written by LVGL's `LVGLImage.py`
+    ///
+    /// `data` starts with the compression header (method, compressed and
+    /// decompressed size). Needs the `image-compress` feature to draw.
+    pub const fn compressed(
+        width: u16,
+        height: u16,
+        format: ColorFormat,
+        data: &'static [u8],
+    ) -> Self {
+        assert!(
+            data.len() >= COMPRESSED_HEADER,
+            "missing compression header"
+        );
+        // LV_IMAGE_COMPRESS_RLE = 1, LV_IMAGE_COMPRESS_LZ4 = 2
+        let method = data[0] & 0x0f;
+        assert!(method == 1 || method == 2, "unknown compression method");
+        let stride = packed_stride(width, format);
+        Self::new(
+            format as u32,
+            sys::LV_IMAGE_FLAGS_COMPRESSED as u16,
+            width,
+            height,
+            stride as u16,
+            data,
+        )
+    }
+
+    /// A PNG or JPEG file embedded in the binary
+    ///
+    /// Size and format come from the file when it is decoded. Needs the
+    /// `png` or `jpeg` feature to draw.
+    pub const fn encoded(data: &'static [u8]) -> Self {
+        Self::new(sys::LV_COLOR_FORMAT_RAW, 0, 0, 0, 0, data)
+    }
+
+    const fn new(cf: u32, flags: u16, w: u16, h: u16, stride: u16, data: &'static [u8]) -> Self {
+        Self::from_header(header_words(cf, flags, w, h, stride), data)
+    }
+
+    /// Build from a header in [`header_words`] layout
+    pub(crate) const fn from_header(words: [u32; 3], data: &'static [u8]) -> Self {
+        unsafe {
+            let mut dsc: sys::lv_image_dsc_t = mem::zeroed();
+            dsc.header = mem::transmute::<[u32; 3], sys::lv_image_header_t>(words);
+            dsc.data_size = data.len() as u32;
+            dsc.data = data.as_ptr();
+            Self(dsc)
+        }
+    }
+
+    /// Pointer to pass to `lv_image_set_src` and friends
+    pub const fn raw_src(&'static self) -> *const c_void {
+        &self.0 as *const sys::lv_image_dsc_t as *const c_void
+    }
+}
+
+/// `lv_image_header_t` as three words
+///
+/// Bitfields: magic:8 cf:8 flags:16 | w:16 h:16 | stride:16 reserved:16
+pub(crate) const fn header_words(cf: u32, flags: u16, w: u16, h: u16, stride: u16) -> [u32; 3] {
+    [
+        sys::LV_IMAGE_HEADER_MAGIC | (cf & 0xff) << 8 | (flags as u32) << 16,
+        w as u32 | (h as u32) << 16,
+        stride as u32,
+    ]
+}
+
+/// Bytes per row of packed pixels
+pub(crate) const fn packed_stride(width: u16, format: ColorFormat) -> usize {
+    (width as usize * format.bpp() as usize + 7) / 8
+}
+
+// =============================================================================
+// Image cache
+// =============================================================================
+
+/// Set the decoded image cache budget in bytes (0 disables caching)
+///
+/// Entries over the new budget are evicted straight away. The default is
+/// `LV_CACHE_DEF_SIZE`, which the `LVGL_IMAGE_CACHE_SIZE` environment
+/// variable overrides at build time.
+pub fn set_cache_size(bytes: u32) {
+    unsafe {
+        sys::lv_image_cache_resize(bytes, true);
+    }
+}
+
+/// True if decoded images are cached
+pub fn cache_enabled() -> bool {
+    unsafe { sys::lv_image_cache_is_enabled() }
+}
+
+/// Drop the decoded copy of one image, e.g. before leaving the screen that used it
+pub fn cache_drop(image: &'static ImageDsc) {
+    unsafe { sys::lv_image_cache_drop(image.raw_src()) }
+}
+
+/// Drop every decoded image
+pub fn cache_clear() {
+    unsafe { sys::lv_image_cache_drop(core::ptr::null()) }
+}
+
+/// Set how many image headers (size and format) are kept for layout
+pub fn set_header_cache_count(entries: u32) {
+    unsafe {
+        sys::lv_image_header_cache_resize(entries, true);
+    }
+}
@@ -3,7 +3,10 @@
 //! Handles touch screens, buttons, encoders, and other input devices.
 
 use crate::{LvglError, Result};
+use core::cell::UnsafeCell;
+use core::ffi::c_void;
 use core::marker::PhantomData;
+use core::sync::atomic::{AtomicU8, AtomicUsize, Ordering};
 use lvgl_sys as sys;
 
 /// Input device type
@@ -28,6 +31,16 @@ pub enum InputState {
     Pressed = sys::LV_INDEV_STATE_PRESSED as u8,
 }
 
+/// When LVGL reads an input device
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+#[repr(u8)]
+pub enum InputMode {
+    /// Poll the read callback every `LV_DEF_REFR_PERIOD` ms (default)
+    Timer = sys::LV_INDEV_MODE_TIMER as u8,
+    /// Only read when [`InputDevice::read`] is called, e.g. after a touch IRQ
+    Event = sys::LV_INDEV_MODE_EVENT as u8,
+}
+
 /// Type alias for the input read callback
 pub type ReadCb =
     unsafe extern "C" fn(indev: *mut sys::lv_indev_t, data: *mut sys::lv_indev_data_t);
@@ -64,6 +77,34 @@ impl InputDevice {
         unsafe { sys::lv_indev_set_read_cb(self.raw, Some(read_cb)) }
     }
 
+    /// Choose between polling and event-driven reads
+    ///
+    /// In [`InputMode::Event`] the read timer is paused, so an idle
+    /// [`RunLoop`](crate::RunLoop) is not woken just to poll the device.
+    pub fn set_mode(&self, mode: InputMode) {
+        unsafe { sys::lv_indev_set_mode(self.raw, mode as u32) }
+    }
+
+    /// Read the device now (`lv_indev_read`)
+    ///
+    /// Call on the UI thread when the device signalled new data.
+    pub fn read(&self) {
+        unsafe { sys::lv_indev_read(self.raw) }
+    }
+
+    /// Feed this device from a [`TouchQueue`]
+    ///
+    /// Installs a read callback that hands LVGL one buffered point per read,
+    /// with `continue_reading` set while more are queued, so a single
+    /// [`read`](Self::read) consumes the whole backlog. Pair with
+    /// [`InputMode::Event`].
+    pub fn set_touch_queue<const N: usize>(&self, queue: &'static TouchQueue<N>) {
+        unsafe {
+            sys::lv_indev_set_user_data(self.raw, queue as *const TouchQueue<N> as *mut c_void);
+            sys::lv_indev_set_read_cb(self.raw, Some(touch_queue_read_cb::<N>));
+        }
+    }
+
     /// Get raw pointer
     pub fn raw(&self) -> *mut sys::lv_indev_t {
         self.raw
@@ -98,6 +139,159 @@ impl TouchPoint {
     }
 }
 
+// =============================================================================
+// Buffered touch input
+// =============================================================================
+
+/// Gesture decoded by a touch controller
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+#[repr(u8)]
+pub enum Gesture {
+    SwipeUp = 1,
+    SwipeDown = 2,
+    SwipeLeft = 3,
+    SwipeRight = 4,
+    Tap = 5,
+    DoubleTap = 6,
+    LongPress = 7,
+}
+
+impl Gesture {
+    fn from_u8(value: u8) -> Option<Self> {
+        match value {
+            1 => Some(Self::SwipeUp),
+            2 => Some(Self::SwipeDown),
+            3 => Some(Self::SwipeLeft),
+            4 => Some(Self::SwipeRight),
+            5 => Some(Self::Tap),
+            6 => Some(Self::DoubleTap),
+            7 => Some(Self::LongPress),
+            _ => None,
+        }
+    }
+}
+
+const NO_GESTURE: u8 = 0;
+
+#[allow(clippy::declare_interior_mutable_const)]
+const EMPTY_POINT: UnsafeCell<TouchPoint> = UnsafeCell::new(TouchPoint {
+    x: 0,
+    y: 0,
+    pressed: false,
+});
+
+/// Lock-free single-producer ring of touch samples
+///
+/// The touch driver pushes one point per controller interrupt (from a task
+/// or ISR); LVGL pops them in the read callback installed by
+/// [`InputDevice::set_touch_queue`]. `N` must be a power of two.
+///
+/// ```ignore
+/// static TOUCH: TouchQueue<16> = TouchQueue::new();
+///
+/// indev.set_touch_queue(&TOUCH);
+/// indev.set_mode(InputMode::Event);
+///
+/// // Touch task, after each INT pulse
+/// unsafe { TOUCH.push(point) }.ok();
+/// lvgl::wake();
+///
+/// // UI loop
+/// if !TOUCH.is_empty() {
+///     indev.read();
+/// }
+/// ```
+pub struct TouchQueue<const N: usize> {
+    slots: [UnsafeCell<TouchPoint>; N],
+    head: AtomicUsize,
+    tail: AtomicUsize,
+    /// Last point handed to LVGL, repeated while the queue is empty
+    last: UnsafeCell<TouchPoint>,
+    gesture: AtomicU8,
+}
+
+// Slots are handed over through head/tail; `last` is only touched by the
+// LVGL read callback.
+unsafe impl<const N: usize> Sync for TouchQueue<N> {}
+unsafe impl<const N: usize> Send for TouchQueue<N> {}
+
+impl<const N: usize> TouchQueue<N> {
+    const VALID_CAPACITY: () = assert!(N.is_power_of_two(), "capacity must be a power of two");
+
+    /// Create an empty queue (usable in a `static`)
+    pub const fn new() -> Self {
+        let () = Self::VALID_CAPACITY;
+        Self {
+            slots: [EMPTY_POINT; N],
+            head: AtomicUsize::new(0),
+            tail: AtomicUsize::new(0),
+            last: EMPTY_POINT,
+            gesture: AtomicU8::new(NO_GESTURE),
+        }
+    }
+
+    /// Queue a touch sample
+    ///
+    /// Returns the point back if the queue is full.
+    ///
+    /// # Safety
+    /// Only one thread or ISR may push at a time.
+    pub unsafe fn push(&self, point: TouchPoint) -> core::result::Result<(), TouchPoint> {
+        let head = self.head.load(Ordering::Relaxed);
+        if head.wrapping_sub(self.tail.load(Ordering::Acquire)) == N {
+            return Err(point);
+        }
+        *self.slots[head & (N - 1)].get() = point;
+        self.head.store(head.wrapping_add(1), Ordering::Release);
+        Ok(())
+    }
+
+    /// True if no samples are waiting for LVGL
+    pub fn is_empty(&self) -> bool {
+        self.head.load(Ordering::Acquire) == self.tail.load(Ordering::Acquire)
+    }
+
+    /// Record a gesture decoded by the controller (replaces an unread one)
+    pub fn set_gesture(&self, gesture: Gesture) {
+        self.gesture.store(gesture as u8, Ordering::Release);
+    }
+
+    /// Take the latest gesture, if any
+    pub fn take_gesture(&self) -> Option<Gesture> {
+        Gesture::from_u8(self.gesture.swap(NO_GESTURE, Ordering::AcqRel))
+    }
+
+    /// Oldest sample (LVGL read callback only)
+    fn pop(&self) -> Option<TouchPoint> {
+        let tail = self.tail.load(Ordering::Relaxed);
+        if tail == self.head.load(Ordering::Acquire) {
+            return None;
+        }
+        let point = unsafe { *self.slots[tail & (N - 1)].get() };
+        self.tail.store(tail.wrapping_add(1), Ordering::Release);
+        Some(point)
+    }
+}
+
+impl<const N: usize> Default for TouchQueue<N> {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+unsafe extern "C" fn touch_queue_read_cb<const N: usize>(
+    indev: *mut sys::lv_indev_t,
+    data: *mut sys::lv_indev_data_t,
+) {
+    let queue = &*(sys::lv_indev_get_user_data(indev) as *const TouchQueue<N>);
+    let last = &mut *queue.last.get();
+    if let Some(point) = queue.pop() {
+        *last = point;
+    }
+    last.write_to(data);
+    (*data).continue_reading = !queue.is_empty();
+}
+
 /// Macro to create a touch input device with a closure
 ///
 /// # Example
@@ -5,20 +5,50 @@
 //!
 //! The design philosophy is "minimal but safe" - we don't wrap everything,
 //! just the commonly used parts.
+//!
+//! LVGL is single-threaded by default. With the `os` feature it renders on
+//! several threads (`LV_DRAW_SW_DRAW_UNIT_CNT`), and calls from threads other
+//! than the UI loop must hold [`lock()`].
 
 #![cfg_attr(not(feature = "std"), no_std)]
 
 extern crate alloc;
 
+use core::sync::atomic::{AtomicBool, AtomicPtr, Ordering};
+
+pub mod assets;
+#[cfg(all(
+    feature = "widget-arc",
+    feature = "widget-chart",
+    feature = "widget-label",
+    feature = "widget-list"
+))]
+pub mod bench;
+#[cfg(feature = "blend-accel")]
+pub mod blend;
+pub mod command;
 pub mod display;
+pub mod event;
+pub mod font;
+pub mod headless;
+pub mod image;
 pub mod input;
+pub mod mem;
 mod obj;
+pub mod observer;
+pub mod perf;
+#[cfg(feature = "widget-image")]
+pub mod screen;
 pub mod style;
+#[cfg(feature = "widget-label")]
+pub mod virtual_table;
 pub mod widgets;
 
 pub use display::Display;
+pub use event::EventInfo;
+pub use font::Font;
 pub use obj::{LvglObj, Obj};
-pub use style::Style;
+pub use style::{ConstStyle, Style, StyleProp};
 pub use widgets::*;
 
 /// Re-export raw FFI bindings so users don't need a separate `lvgl-sys` dependency.
@@ -67,6 +97,10 @@ pub fn init() -> Result<()> {
         if LVGL_INITIALIZED {
             return Err(LvglError::AlreadyInitialized);
         }
+        #[cfg(feature = "mem-rust")]
+        mem::keep_hooks();
+        #[cfg(feature = "blend-accel")]
+        blend::keep_hooks();
         sys::lv_init();
         LVGL_INITIALIZED = true;
     }
@@ -80,20 +114,174 @@ pub fn is_initialized() -> bool {
 
 /// Run LVGL task handler. Call this periodically (e.g., every 5-10ms).
 ///
-/// Returns the time in milliseconds until it wants to be called again.
+/// Returns the time in milliseconds until it wants to be called again, or
+/// `LV_NO_TIMER_READY` if every timer is paused. See [`RunLoop`] to sleep
+/// for exactly that long.
+/// With the `os` feature LVGL takes its global lock inside the handler.
 pub fn task_handler() -> u32 {
     unsafe { sys::lv_timer_handler() }
 }
 
+/// Guard for LVGL's global mutex, released when dropped
+///
+/// LVGL's mutex is recursive, so the UI thread may take it around
+/// [`task_handler`] as well.
+#[cfg(feature = "os")]
+pub struct LvglLock {
+    _marker: core::marker::PhantomData<*mut ()>,
+}
+
+#[cfg(feature = "os")]
+impl Drop for LvglLock {
+    fn drop(&mut self) {
+        unsafe { sys::lv_unlock() }
+    }
+}
+
+/// Take LVGL's global lock (`lv_lock`)
+///
+/// Hold it while calling into LVGL from a thread other than the one running
+/// [`task_handler`].
+#[cfg(feature = "os")]
+pub fn lock() -> LvglLock {
+    unsafe { sys::lv_lock() };
+    LvglLock {
+        _marker: core::marker::PhantomData,
+    }
+}
+
+/// Run `f` while holding LVGL's global lock
+#[cfg(feature = "os")]
+pub fn with_lock<R>(f: impl FnOnce() -> R) -> R {
+    let _guard = lock();
+    f()
+}
+
 /// Tick LVGL's internal clock. Call this from a timer interrupt or task.
 ///
-/// With ESP-IDF, this is handled automatically via `lv_conf.h` using
-/// `esp_timer_get_time()`, so you typically don't need to call this.
-/// For the simulator, call this manually with elapsed milliseconds.
+/// Not needed after [`set_tick_source`], which is preferred: a periodic tick
+/// keeps waking the CPU, and an [`IdleWait`] sleep would otherwise stall the
+/// clock.
 pub fn tick_inc(period_ms: u32) {
     unsafe { sys::lv_tick_inc(period_ms) }
 }
 
+/// Millisecond clock callback for [`set_tick_source`]
+pub type TickCb = unsafe extern "C" fn() -> u32;
+
+/// Let LVGL read the time from a monotonic millisecond clock (`lv_tick_set_cb`)
+///
+/// E.g. `esp_timer_get_time() / 1000` on ESP-IDF. Replaces [`tick_inc`].
+pub fn set_tick_source(cb: TickCb) {
+    unsafe { sys::lv_tick_set_cb(Some(cb)) }
+}
+
+// =============================================================================
+// Idle-aware run loop
+// =============================================================================
+
+/// Sleeps the UI thread between frames
+///
+/// Implementations block on a platform primitive (a FreeRTOS task
+/// notification, the SDL event queue, a condvar...) that the hook registered
+/// with [`set_wake_hook`] signals.
+pub trait IdleWait {
+    /// Block until woken or `timeout_ms` has passed (`None`: no deadline)
+    fn wait(&mut self, timeout_ms: Option<u32>);
+}
+
+static WAKE_PENDING: AtomicBool = AtomicBool::new(false);
+static WAKE_HOOK: AtomicPtr<()> = AtomicPtr::new(core::ptr::null_mut());
+
+/// Register the function [`wake`] calls to interrupt an [`IdleWait`]
+///
+/// It may run in an interrupt handler if [`wake`] is called from one.
+pub fn set_wake_hook(hook: fn()) {
+    WAKE_HOOK.store(hook as *mut (), Ordering::Release);
+}
+
+/// Ask the UI loop to run again as soon as possible
+///
+/// Callable from any thread. [`CommandQueue::push`](command::CommandQueue::push)
+/// calls it, and input interrupts should too.
+pub fn wake() {
+    WAKE_PENDING.store(true, Ordering::Release);
+    let hook = WAKE_HOOK.load(Ordering::Acquire);
+    if !hook.is_null() {
+        // Only ever stored from a `fn()` in set_wake_hook()
+        let hook: fn() = unsafe { core::mem::transmute(hook) };
+        hook();
+    }
+}
+
+/// Time to sleep after `lv_timer_handler` returned `next_ms`
+///
+/// `LV_NO_TIMER_READY` means every timer is paused: nothing will happen until
+/// an input or another thread calls [`wake`].
+fn idle_timeout(next_ms: u32, max_sleep_ms: Option<u32>) -> Option<u32> {
+    if next_ms == sys::LV_NO_TIMER_READY {
+        max_sleep_ms
+    } else {
+        Some(max_sleep_ms.map_or(next_ms, |max| next_ms.min(max)))
+    }
+}
+
+/// Event-driven replacement for a fixed-period `task_handler` loop
+///
+/// Runs LVGL's timers, then sleeps until the next one is due or [`wake`] is
+/// called. LVGL pauses its refresh timer when nothing is invalidated and its
+/// animation timer when no animation runs, so an idle UI sleeps indefinitely
+/// once input devices are in [`InputMode::Event`](input::InputMode::Event).
+///
+/// ```ignore
+/// let mut run_loop = RunLoop::new(MyIdle::new());
+/// loop {
+///     UPDATES.drain();
+///     run_loop.run_once();
+/// }
+/// ```
+pub struct RunLoop<W: IdleWait> {
+    idle: W,
+    max_sleep_ms: Option<u32>,
+    _marker: core::marker::PhantomData<*mut ()>,
+}
+
+impl<W: IdleWait> RunLoop<W> {
+    /// Create a run loop sleeping through `idle`, with no sleep limit
+    pub fn new(idle: W) -> Self {
+        Self {
+            idle,
+            max_sleep_ms: None,
+            _marker: core::marker::PhantomData,
+        }
+    }
+
+    /// Cap each sleep, e.g. to feed a watchdog (`None`: no cap)
+    pub fn set_max_sleep(&mut self, max_sleep_ms: Option<u32>) {
+        self.max_sleep_ms = max_sleep_ms;
+    }
+
+    /// Run LVGL's timers once, then sleep until there is work
+    ///
+    /// Published [`observer::Subject`] values are applied first. Returns the
+    /// sleep deadline used (`None`: until woken).
+    pub fn run_once(&mut self) -> Option<u32> {
+        // The run loop lives on the LVGL thread, like task_handler()
+        unsafe { observer::flush() };
+        let timeout = idle_timeout(task_handler(), self.max_sleep_ms);
+        // Skip the sleep if something woke us while the handler ran
+        if timeout != Some(0) && !WAKE_PENDING.swap(false, Ordering::AcqRel) {
+            self.idle.wait(timeout);
+        }
+        timeout
+    }
+
+    /// Access the idle implementation
+    pub fn idle(&mut self) -> &mut W {
+        &mut self.idle
+    }
+}
+
 /// Get the currently active screen
 pub fn screen_active() -> Option<Obj> {
     unsafe {
@@ -132,32 +320,40 @@ pub struct Color(sys::lv_color_t);
 
 impl Color {
     /// Create color from RGB values (0-255 each)
-    pub fn rgb(r: u8, g: u8, b: u8) -> Self {
-        unsafe { Self(sys::lv_color_make(r, g, b)) }
+    pub const fn rgb(r: u8, g: u8, b: u8) -> Self {
+        Self(sys::lv_color_t {
+            blue: b,
+            green: g,
+            red: r,
+        })
     }
 
     /// Create color from hex value (0xRRGGBB)
-    pub fn hex(hex: u32) -> Self {
-        unsafe { Self(sys::lv_color_hex(hex)) }
+    pub const fn hex(hex: u32) -> Self {
+        Self::rgb((hex >> 16) as u8, (hex >> 8) as u8, hex as u8)
     }
 
     /// Create color from hex3 value (0xRGB)
-    pub fn hex3(hex: u16) -> Self {
-        unsafe { Self(sys::lv_color_hex3(hex as u32)) }
+    pub const fn hex3(hex: u16) -> Self {
+        // Each nibble is repeated, like `lv_color_hex3`
+        let r = ((hex >> 8) & 0xF) as u8;
+        let g = ((hex >> 4) & 0xF) as u8;
+        let b = (hex & 0xF) as u8;
+        Self::rgb(r * 0x11, g * 0x11, b * 0x11)
     }
 
     /// White
-    pub fn white() -> Self {
+    pub const fn white() -> Self {
         Self::hex(0xFFFFFF)
     }
 
     /// Black
-    pub fn black() -> Self {
+    pub const fn black() -> Self {
         Self::hex(0x000000)
     }
 
     /// Get raw LVGL color
-    pub fn raw(&self) -> sys::lv_color_t {
+    pub const fn raw(&self) -> sys::lv_color_t {
         self.0
     }
 }
@@ -0,0 +1,612 @@
+//! LVGL heap backends and statistics
+//!
+//! By default LVGL allocates with the C library's `malloc`, sharing the heap
+//! with everything else (WiFi buffers on the ESP32). Two cargo features give
+//! it a heap of its own:
+//!
+//! - `mem-tlsf`: LVGL's builtin TLSF allocator on a static pool of
+//!   `LV_MEM_SIZE` bytes (`LVGL_MEM_SIZE` at build time). More regions,
+//!   e.g. in PSRAM, are added with [`add_region`].
+//! - `mem-rust`: LVGL's `lv_malloc_core` hooks are implemented here and
+//!   forward to the [`LvglAllocator`] set with [`set_allocator`], the global
+//!   allocator by default. [`ScreenArena`] builds on it.
+//!
+//! [`stats`] reports usage and fragmentation for either backend.
+//!
+//! ```ignore
+//! static LVGL_HEAP: PsramHeap = PsramHeap;
+//! lvgl::mem::set_allocator(&LVGL_HEAP)?;
+//! lvgl::init()?;
+//!
+//! if let Some(stats) = lvgl::mem::stats() {
+//!     log::info!("LVGL heap: {} used, {}% fragmented", stats.used, stats.frag_pct);
+//! }
+//! ```
+
+#[cfg(all(feature = "mem-tlsf", feature = "mem-rust"))]
+compile_error!("features `mem-tlsf` and `mem-rust` select different allocators; enable one");
+
+#[cfg(feature = "mem-rust")]
+pub use self::hooks::*;
+#[cfg(feature = "mem-tlsf")]
+use lvgl_sys as sys;
+
+/// LVGL heap usage
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub struct MemStats {
+    /// Heap size in bytes (0 if the allocator does not know it)
+    pub total: usize,
+    /// Free bytes
+    pub free: usize,
+    /// Largest free block, the biggest allocation that can succeed
+    pub largest_free: usize,
+    /// Allocated bytes
+    pub used: usize,
+    /// Highest `used` so far
+    pub max_used: usize,
+    /// Live allocations
+    pub allocations: usize,
+    /// Share of free memory outside the largest free block
+    pub frag_pct: u8,
+}
+
+/// Fragmentation from free space and the largest free block
+fn frag_pct(free: usize, largest_free: usize) -> u8 {
+    if free == 0 {
+        return 0;
+    }
+    (100 - (largest_free.min(free) * 100 / free)) as u8
+}
+
+/// Usage of LVGL's heap
+///
+/// `None` with the C library allocator, which keeps no statistics.
+pub fn stats() -> Option<MemStats> {
+    backend_stats()
+}
+
+#[cfg(not(any(feature = "mem-tlsf", feature = "mem-rust")))]
+fn backend_stats() -> Option<MemStats> {
+    None
+}
+
+// =============================================================================
+// Builtin TLSF heap
+// =============================================================================
+
+#[cfg(feature = "mem-tlsf")]
+fn backend_stats() -> Option<MemStats> {
+    let mut mon = sys::lv_mem_monitor_t::default();
+    unsafe { sys::lv_mem_monitor(&mut mon) };
+    Some(MemStats {
+        total: mon.total_size,
+        free: mon.free_size,
+        largest_free: mon.free_biggest_size,
+        used: mon.total_size - mon.free_size,
+        max_used: mon.max_used,
+        allocations: mon.used_cnt as usize,
+        frag_pct: frag_pct(mon.free_size, mon.free_biggest_size),
+    })
+}
+
+/// Add `region` to LVGL's TLSF heap
+///
+/// Call after [`init`](crate::init), which creates the heap on its static
+/// pool. Regions can't be removed again.
+#[cfg(feature = "mem-tlsf")]
+pub fn add_region(region: &'static mut [u8]) -> crate::Result<()> {
+    if !crate::is_initialized() {
+        return Err(crate::LvglError::NotInitialized);
+    }
+    let pool = unsafe { sys::lv_mem_add_pool(region.as_mut_ptr() as *mut _, region.len()) };
+    if pool.is_null() {
+        Err(crate::LvglError::InvalidParameter)
+    } else {
+        Ok(())
+    }
+}
+
+/// Run `f` with LVGL's allocations going to the heap, even inside
+/// [`ScreenArena::build`]
+///
+/// For allocations that outlive the screen being built, such as entries
+/// of LVGL's global caches. Without `mem-rust` there are no arenas and
+/// this just calls `f`.
+pub fn outside_arena<R>(f: impl FnOnce() -> R) -> R {
+    #[cfg(feature = "mem-rust")]
+    let _paused = hooks::pause_arena();
+    f()
+}
+
+// =============================================================================
+// Rust heap hooks
+// =============================================================================
+
+#[cfg(feature = "mem-rust")]
+fn backend_stats() -> Option<MemStats> {
+    Some(hooks::heap_stats())
+}
+
+#[cfg(feature = "mem-rust")]
+mod hooks {
+    use super::{frag_pct, MemStats};
+    use crate::{LvglError, LvglObj, Obj, Result};
+    use core::ffi::c_void;
+    use core::mem::size_of;
+    use core::ptr;
+    use core::sync::atomic::{AtomicU8, AtomicUsize, Ordering};
+    use lvgl_sys as sys;
+
+    /// Alignment of every block handed to LVGL, as `malloc` guarantees
+    pub const ALIGN: usize = 2 * size_of::<usize>();
+
+    /// Block header holding the payload size
+    const HEADER: usize = ALIGN;
+
+    /// Free and total bytes of an [`LvglAllocator`]
+    #[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+    pub struct Capacity {
+        pub total: usize,
+        pub free: usize,
+        pub largest_free: usize,
+    }
+
+    /// Memory behind LVGL's heap with the `mem-rust` feature
+    ///
+    /// LVGL allocates from its draw threads too when built with `os`, so
+    /// implementations must be thread safe.
+    pub trait LvglAllocator: Sync {
+        /// Allocate `size` bytes aligned to [`ALIGN`]; null on failure
+        ///
+        /// # Safety
+        /// `size` is not zero.
+        unsafe fn alloc(&self, size: usize) -> *mut u8;
+
+        /// Free a block of `size` bytes from [`alloc`](Self::alloc)
+        ///
+        /// # Safety
+        /// `ptr` and `size` describe a live block of this allocator.
+        unsafe fn free(&self, ptr: *mut u8, size: usize);
+
+        /// Resize a block, keeping its contents; null on failure
+        ///
+        /// # Safety
+        /// As for [`free`](Self::free); `new_size` is not zero.
+        unsafe fn realloc(&self, ptr: *mut u8, size: usize, new_size: usize) -> *mut u8 {
+            let new = self.alloc(new_size);
+            if !new.is_null() {
+                ptr::copy_nonoverlapping(ptr, new, size.min(new_size));
+                self.free(ptr, size);
+            }
+            new
+        }
+
+        /// Size and free space, if known
+        fn capacity(&self) -> Option<Capacity> {
+            None
+        }
+    }
+
+    /// The global Rust allocator
+    #[derive(Clone, Copy, Debug, Default)]
+    pub struct GlobalHeap;
+
+    impl GlobalHeap {
+        fn layout(size: usize) -> core::alloc::Layout {
+            // ALIGN is a power of two and sizes come from LVGL's size_t
+            unsafe { core::alloc::Layout::from_size_align_unchecked(size, ALIGN) }
+        }
+    }
+
+    impl LvglAllocator for GlobalHeap {
+        unsafe fn alloc(&self, size: usize) -> *mut u8 {
+            alloc::alloc::alloc(Self::layout(size))
+        }
+
+        unsafe fn free(&self, ptr: *mut u8, size: usize) {
+            alloc::alloc::dealloc(ptr, Self::layout(size))
+        }
+
+        unsafe fn realloc(&self, ptr: *mut u8, size: usize, new_size: usize) -> *mut u8 {
+            alloc::alloc::realloc(ptr, Self::layout(size), new_size)
+        }
+    }
+
+    static mut ALLOCATOR: &dyn LvglAllocator = &GlobalHeap;
+
+    /// Payload bytes of live heap blocks
+    static USED: AtomicUsize = AtomicUsize::new(0);
+    static MAX_USED: AtomicUsize = AtomicUsize::new(0);
+    static BLOCKS: AtomicUsize = AtomicUsize::new(0);
+
+    /// Route LVGL's heap to `allocator`
+    ///
+    /// Must be called before [`init`](crate::init): blocks can't move
+    /// between allocators.
+    pub fn set_allocator(allocator: &'static dyn LvglAllocator) -> Result<()> {
+        if crate::is_initialized() {
+            return Err(LvglError::AlreadyInitialized);
+        }
+        unsafe { ALLOCATOR = allocator };
+        Ok(())
+    }
+
+    fn allocator() -> &'static dyn LvglAllocator {
+        unsafe { ALLOCATOR }
+    }
+
+    pub(super) fn heap_stats() -> MemStats {
+        let capacity = allocator().capacity().unwrap_or_default();
+        MemStats {
+            total: capacity.total,
+            free: capacity.free,
+            largest_free: capacity.largest_free,
+            used: USED.load(Ordering::Relaxed),
+            max_used: MAX_USED.load(Ordering::Relaxed),
+            allocations: BLOCKS.load(Ordering::Relaxed),
+            frag_pct: frag_pct(capacity.free, capacity.largest_free),
+        }
+    }
+
+    unsafe fn heap_alloc(size: usize) -> *mut u8 {
+        let block = allocator().alloc(HEADER + size);
+        if block.is_null() {
+            return block;
+        }
+        *(block as *mut usize) = size;
+        let used = USED.fetch_add(size, Ordering::Relaxed) + size;
+        MAX_USED.fetch_max(used, Ordering::Relaxed);
+        BLOCKS.fetch_add(1, Ordering::Relaxed);
+        block.add(HEADER)
+    }
+
+    /// Payload size of a heap or arena block
+    unsafe fn block_size(p: *mut u8) -> usize {
+        *(p.sub(HEADER) as *const usize)
+    }
+
+    #[doc(hidden)]
+    #[no_mangle]
+    pub extern "C" fn lv_mem_init() {}
+
+    #[doc(hidden)]
+    #[no_mangle]
+    pub extern "C" fn lv_mem_deinit() {}
+
+    /// Pools are not supported; set an allocator instead
+    #[doc(hidden)]
+    #[no_mangle]
+    pub extern "C" fn lv_mem_add_pool(_mem: *mut c_void, _bytes: usize) -> sys::lv_mem_pool_t {
+        ptr::null_mut()
+    }
+
+    #[doc(hidden)]
+    #[no_mangle]
+    pub extern "C" fn lv_mem_remove_pool(_pool: sys::lv_mem_pool_t) {}
+
+    #[doc(hidden)]
+    #[no_mangle]
+    pub unsafe extern "C" fn lv_malloc_core(size: usize) -> *mut c_void {
+        let active = ACTIVE_ARENA.load(Ordering::Acquire);
+        if active != NO_ARENA {
+            let p = ARENAS[active].alloc(size);
+            if !p.is_null() {
+                return p as *mut c_void;
+            }
+        }
+        heap_alloc(size) as *mut c_void
+    }
+
+    #[doc(hidden)]
+    #[no_mangle]
+    pub unsafe extern "C" fn lv_realloc_core(p: *mut c_void, new_size: usize) -> *mut c_void {
+        let p = p as *mut u8;
+        if p.is_null() {
+            return lv_malloc_core(new_size);
+        }
+        let size = block_size(p);
+        if arena_of(p).is_some() {
+            // Arena blocks never move or shrink in place; copy out
+            let new = lv_malloc_core(new_size) as *mut u8;
+            if !new.is_null() {
+                ptr::copy_nonoverlapping(p, new, size.min(new_size));
+            }
+            return new as *mut c_void;
+        }
+
+        let block = allocator().realloc(p.sub(HEADER), HEADER + size, HEADER + new_size);
+        if block.is_null() {
+            return ptr::null_mut();
+        }
+        *(block as *mut usize) = new_size;
+        if new_size > size {
+            let used = USED.fetch_add(new_size - size, Ordering::Relaxed) + new_size - size;
+            MAX_USED.fetch_max(used, Ordering::Relaxed);
+        } else {
+            USED.fetch_sub(size - new_size, Ordering::Relaxed);
+        }
+        block.add(HEADER) as *mut c_void
+    }
+
+    #[doc(hidden)]
+    #[no_mangle]
+    pub unsafe extern "C" fn lv_free_core(p: *mut c_void) {
+        let p = p as *mut u8;
+        // Arena blocks go away with their arena
+        if p.is_null() || arena_of(p).is_some() {
+            return;
+        }
+        let size = block_size(p);
+        USED.fetch_sub(size, Ordering::Relaxed);
+        BLOCKS.fetch_sub(1, Ordering::Relaxed);
+        allocator().free(p.sub(HEADER), HEADER + size);
+    }
+
+    #[doc(hidden)]
+    #[no_mangle]
+    pub unsafe extern "C" fn lv_mem_monitor_core(mon: *mut sys::lv_mem_monitor_t) {
+        let stats = heap_stats();
+        let mon = &mut *mon;
+        mon.total_size = stats.total;
+        mon.free_size = stats.free;
+        mon.free_biggest_size = stats.largest_free;
+        mon.used_cnt = stats.allocations as u32;
+        mon.max_used = stats.max_used;
+        mon.used_pct = match stats.total {
+            0 => 0,
+            total => (stats.used.min(total) * 100 / total) as u8,
+        };
+        mon.frag_pct = stats.frag_pct;
+    }
+
+    #[doc(hidden)]
+    #[no_mangle]
+    pub extern "C" fn lv_mem_test_core() -> sys::lv_result_t {
+        sys::LV_RESULT_OK
+    }
+
+    /// Reference the hooks from [`init`](crate::init), so the linker keeps
+    /// them for LVGL's static library
+    pub(crate) fn keep_hooks() {
+        let hooks = [
+            lv_mem_init as *const (),
+            lv_mem_deinit as *const (),
+            lv_mem_add_pool as *const (),
+            lv_mem_remove_pool as *const (),
+            lv_malloc_core as *const (),
+            lv_realloc_core as *const (),
+            lv_free_core as *const (),
+            lv_mem_monitor_core as *const (),
+            lv_mem_test_core as *const (),
+        ];
+        core::hint::black_box(hooks);
+    }
+
+    // =========================================================================
+    // Screen arenas
+    // =========================================================================
+
+    /// Most arenas that can be registered
+    pub const MAX_ARENAS: usize = 8;
+
+    const NO_ARENA: usize = usize::MAX;
+
+    /// Arena receiving LVGL's allocations, or `NO_ARENA`
+    static ACTIVE_ARENA: AtomicUsize = AtomicUsize::new(NO_ARENA);
+
+    const FREE: u8 = 0;
+    const BUILDING: u8 = 1;
+    const LIVE: u8 = 2;
+    const RELEASED: u8 = 3;
+
+    /// One registered region; `end == 0` while unused
+    struct Slot {
+        start: AtomicUsize,
+        end: AtomicUsize,
+        top: AtomicUsize,
+        state: AtomicU8,
+    }
+
+    impl Slot {
+        const fn new() -> Self {
+            Self {
+                start: AtomicUsize::new(0),
+                end: AtomicUsize::new(0),
+                top: AtomicUsize::new(0),
+                state: AtomicU8::new(FREE),
+            }
+        }
+
+        /// Bump-allocate a block with a header; null when full
+        fn alloc(&self, size: usize) -> *mut u8 {
+            let start = self.start.load(Ordering::Relaxed);
+            let capacity = self.end.load(Ordering::Relaxed) - start;
+            let need = match (HEADER + size).checked_add(ALIGN - 1) {
+                Some(n) => n & !(ALIGN - 1),
+                None => return ptr::null_mut(),
+            };
+            let mut top = self.top.load(Ordering::Relaxed);
+            loop {
+                if capacity - top < need {
+                    return ptr::null_mut();
+                }
+                match self.top.compare_exchange_weak(
+                    top,
+                    top + need,
+                    Ordering::Relaxed,
+                    Ordering::Relaxed,
+                ) {
+                    Ok(_) => break,
+                    Err(current) => top = current,
+                }
+            }
+            let block = (start + top) as *mut u8;
+            unsafe {
+                *(block as *mut usize) = size;
+                block.add(HEADER)
+            }
+        }
+
+        fn contains(&self, p: usize) -> bool {
+            let end = self.end.load(Ordering::Acquire);
+            end != 0 && p >= self.start.load(Ordering::Relaxed) && p < end
+        }
+    }
+
+    #[allow(clippy::declare_interior_mutable_const)]
+    const EMPTY_SLOT: Slot = Slot::new();
+
+    static ARENAS: [Slot; MAX_ARENAS] = [EMPTY_SLOT; MAX_ARENAS];
+
+    fn arena_of(p: *mut u8) -> Option<usize> {
+        ARENAS.iter().position(|slot| slot.contains(p as usize))
+    }
+
+    /// A region that holds one screen's allocations, reclaimed in one step
+    ///
+    /// While [`build`](Self::build) runs, LVGL's allocations are bump
+    /// allocated from the region instead of the heap, so building is cheap
+    /// and freeing the widgets later is a range check per block. When the
+    /// screen is deleted the region is reused as a whole by the next
+    /// `build`. Allocations that don't fit fall back to the heap.
+    ///
+    /// ```ignore
+    /// static mut TAB_ARENA: [u8; 32 * 1024] = [0; 32 * 1024];
+    /// let arena = ScreenArena::new(unsafe { &mut *addr_of_mut!(TAB_ARENA) })?;
+    ///
+    /// // On every tab switch
+    /// old_screen.delete();
+    /// let (screen, ()) = unsafe { arena.build(|screen| build_tab(screen)) }?;
+    /// lvgl::screen_load(&screen);
+    /// ```
+    pub struct ScreenArena {
+        slot: usize,
+    }
+
+    impl ScreenArena {
+        /// Register `region` as an arena (at most [`MAX_ARENAS`])
+        pub fn new(region: &'static mut [u8]) -> Result<Self> {
+            // Align the start so blocks keep ALIGN
+            let addr = region.as_mut_ptr() as usize;
+            let start = (addr + ALIGN - 1) & !(ALIGN - 1);
+            let end = addr + region.len();
+            if end <= start + HEADER {
+                return Err(LvglError::InvalidParameter);
+            }
+            for (i, slot) in ARENAS.iter().enumerate() {
+                if slot
+                    .start
+                    .compare_exchange(0, start, Ordering::Relaxed, Ordering::Relaxed)
+                    .is_ok()
+                {
+                    slot.end.store(end, Ordering::Release);
+                    return Ok(Self { slot: i });
+                }
+            }
+            Err(LvglError::OutOfMemory)
+        }
+
+        /// Create a screen and build its content with allocations in the arena
+        ///
+        /// Fails if the arena still holds a screen that was not deleted yet.
+        ///
+        /// Global caches that fill lazily would otherwise keep entries in
+        /// the arena past the screen, to be overwritten by the next build.
+        /// The crate keeps the ones it knows of on the heap through
+        /// [`outside_arena`](super::outside_arena): image headers cached by
+        /// [`Image`](crate::widgets::Image) setters
+        /// ([`set_header_cache_count`](crate::image::set_header_cache_count))
+        /// and the glyph caches of
+        /// [`LoadedFont::from_ttf`](crate::font::LoadedFont) fonts.
+        ///
+        /// # Safety
+        /// Everything LVGL allocates inside `build` must be freed no later
+        /// than the screen: create only the screen's descendants, with their
+        /// local styles, events and text. A `Style`, timer, animation or
+        /// font that outlives the screen must be created outside. Raw calls
+        /// that fill a global cache, such as `lv_image_set_src` or drawing
+        /// with `lv_refr_now`, must be wrapped in
+        /// [`outside_arena`](super::outside_arena).
+        pub unsafe fn build<R>(&self, build: impl FnOnce(&Obj) -> R) -> Result<(Obj, R)> {
+            let slot = &ARENAS[self.slot];
+            let state = slot.state.load(Ordering::Acquire);
+            if (state != FREE && state != RELEASED)
+                || ACTIVE_ARENA
+                    .compare_exchange(NO_ARENA, self.slot, Ordering::AcqRel, Ordering::Acquire)
+                    .is_err()
+            {
+                return Err(LvglError::InvalidParameter);
+            }
+            // Everything of the previous screen is gone: reuse the region
+            slot.top.store(0, Ordering::Relaxed);
+            slot.state.store(BUILDING, Ordering::Release);
+
+            /// Stops routing even if `build` panics
+            struct Routing;
+            impl Drop for Routing {
+                fn drop(&mut self) {
+                    ACTIVE_ARENA.store(NO_ARENA, Ordering::Release);
+                }
+            }
+            let routing = Routing;
+
+            let screen = match crate::screen_create() {
+                Ok(screen) => screen,
+                Err(e) => {
+                    drop(routing);
+                    slot.state.store(FREE, Ordering::Release);
+                    return Err(e);
+                }
+            };
+            sys::lv_obj_add_event_cb(
+                screen.raw(),
+                Some(arena_screen_deleted),
+                sys::LV_EVENT_DELETE,
+                self.slot as *mut c_void,
+            );
+            let result = build(&screen);
+            drop(routing);
+            slot.state.store(LIVE, Ordering::Release);
+            Ok((screen, result))
+        }
+
+        /// Bytes taken by the current screen, headers included
+        pub fn used(&self) -> usize {
+            ARENAS[self.slot].top.load(Ordering::Relaxed)
+        }
+
+        /// Usable bytes
+        pub fn capacity(&self) -> usize {
+            let slot = &ARENAS[self.slot];
+            slot.end.load(Ordering::Relaxed) - slot.start.load(Ordering::Relaxed)
+        }
+
+        /// True while the arena holds a screen that was not deleted
+        pub fn in_use(&self) -> bool {
+            matches!(
+                ARENAS[self.slot].state.load(Ordering::Acquire),
+                BUILDING | LIVE
+            )
+        }
+    }
+
+    /// Routes allocations to the heap until dropped
+    pub(super) struct PausedArena(usize);
+
+    impl Drop for PausedArena {
+        fn drop(&mut self) {
+            ACTIVE_ARENA.store(self.0, Ordering::Release);
+        }
+    }
+
+    pub(super) fn pause_arena() -> PausedArena {
+        PausedArena(ACTIVE_ARENA.swap(NO_ARENA, Ordering::AcqRel))
+    }
+
+    unsafe extern "C" fn arena_screen_deleted(e: *mut sys::lv_event_t) {
+        let slot = sys::lv_event_get_user_data(e) as usize;
+        // The children are freed right after this event and their blocks
+        // are skipped; the region is reset by the next build
+        ARENAS[slot].state.store(RELEASED, Ordering::Release);
+    }
+}
@@ -2,9 +2,10 @@
 //!
 //! All LVGL widgets inherit from lv_obj, so this provides common functionality.
 
-use crate::{Align, Color, LvglError, Part, Result, State, Style};
-use alloc::boxed::Box;
-use core::ffi::c_void;
+use crate::command::ObjHandle;
+use crate::font::Font;
+use crate::event::{self, EventInfo};
+use crate::{Align, Color, ConstStyle, LvglError, Part, Result, State, Style};
 use core::marker::PhantomData;
 use lvgl_sys as sys;
 
@@ -13,6 +14,16 @@ pub trait LvglObj {
     /// Get the raw LVGL object pointer
     fn raw(&self) -> *mut sys::lv_obj_t;
 
+    /// Get a `Send` handle for updates from other threads
+    ///
+    /// See [`crate::command::CommandQueue`].
+    fn handle(&self) -> ObjHandle<Self>
+    where
+        Self: Sized,
+    {
+        ObjHandle::new(self.raw())
+    }
+
     /// Set position
     fn set_pos(&self, x: i32, y: i32) {
         unsafe { sys::lv_obj_set_pos(self.raw(), x, y) }
@@ -53,6 +64,13 @@ pub trait LvglObj {
         unsafe { sys::lv_obj_add_style(self.raw(), style.raw() as *mut _, selector) }
     }
 
+    /// Add a constant style (see [`const_style!`](crate::const_style))
+    ///
+    /// LVGL only reads it, so it can stay in flash.
+    fn add_const_style(&self, style: &'static ConstStyle, selector: u32) {
+        unsafe { sys::lv_obj_add_style(self.raw(), style.raw() as *mut _, selector) }
+    }
+
     /// Set background color
     fn set_style_bg_color(&self, color: Color, selector: u32) {
         unsafe { sys::lv_obj_set_style_bg_color(self.raw(), color.raw(), selector) }
@@ -68,6 +86,11 @@ pub trait LvglObj {
         unsafe { sys::lv_obj_set_style_text_color(self.raw(), color.raw(), selector) }
     }
 
+    /// Set text font
+    fn set_style_text_font(&self, font: &'static Font, selector: u32) {
+        unsafe { sys::lv_obj_set_style_text_font(self.raw(), font.raw(), selector) }
+    }
+
     /// Set border width
     fn set_style_border_width(&self, width: i32, selector: u32) {
         unsafe { sys::lv_obj_set_style_border_width(self.raw(), width, selector) }
@@ -85,6 +108,9 @@ pub trait LvglObj {
 
     /// Set padding
     fn set_style_pad_all(&self, pad: i32, selector: u32) {
+        // The sides share their refresh flags, so refreshing one covers all
+        let scope = BatchScope::Prop(selector, sys::LV_STYLE_PAD_TOP as u8);
+        let _batch = StyleBatch::begin(self.raw(), scope);
         unsafe {
             sys::lv_obj_set_style_pad_top(self.raw(), pad, selector);
             sys::lv_obj_set_style_pad_bottom(self.raw(), pad, selector);
@@ -93,6 +119,29 @@ pub trait LvglObj {
         }
     }
 
+    /// Make many style, size and position changes with a single refresh
+    ///
+    /// Every style change normally refreshes the object's styles and marks
+    /// its layout dirty on the spot. Inside `f` these refreshes are skipped;
+    /// when `f` returns, this object and all its descendants (including ones
+    /// created inside `f`) are refreshed once. Batches can be nested.
+    ///
+    /// Only style this object and its descendants inside `f`; other objects
+    /// changed meanwhile are not refreshed.
+    ///
+    /// ```ignore
+    /// card.batch(|card| {
+    ///     card.set_size(200, 120);
+    ///     card.set_style_bg_color(Color::hex(0x16213e), 0);
+    ///     card.set_style_radius(8, 0);
+    ///     card.set_style_pad_all(10, 0);
+    /// });
+    /// ```
+    fn batch<R>(&self, f: impl FnOnce(&Self) -> R) -> R {
+        let _batch = StyleBatch::begin(self.raw(), BatchScope::Tree);
+        f(self)
+    }
+
     /// Add a state flag
     fn add_state(&self, state: State) {
         unsafe { sys::lv_obj_add_state(self.raw(), state.0) }
@@ -110,25 +159,27 @@ pub trait LvglObj {
 
     /// Add an event callback
     ///
-    /// # Safety
-    /// The callback must remain valid for the lifetime of the object.
-    /// User data must remain valid for the lifetime of the object.
-    fn add_event_cb<F>(&self, event: crate::Event, callback: F)
+    /// The closure is dropped when the object is deleted. Captures of up to
+    /// [`INLINE_WORDS`](crate::event::INLINE_WORDS) words are stored without
+    /// allocating; see [`crate::event`].
+    fn add_event_cb<F>(&self, event: crate::Event, mut callback: F)
     where
         F: FnMut() + 'static,
     {
-        // Box the closure and leak it (we can't easily clean this up)
-        let boxed: Box<Box<dyn FnMut()>> = Box::new(Box::new(callback));
-        let user_data = Box::into_raw(boxed) as *mut c_void;
+        event::add_closure(self.raw(), event as u32, move |_: &EventInfo| callback());
+    }
 
-        unsafe {
-            sys::lv_obj_add_event_cb(
-                self.raw(),
-                Some(event_callback_trampoline),
-                event as u32,
-                user_data,
-            );
-        }
+    /// Add an event callback that receives the event (code, target, param)
+    fn add_event_cb_with<F>(&self, event: crate::Event, callback: F)
+    where
+        F: FnMut(&EventInfo) + 'static,
+    {
+        event::add_closure(self.raw(), event as u32, callback);
+    }
+
+    /// Add a plain function as event callback, with no allocation
+    fn add_event_fn(&self, event: crate::Event, callback: fn(&EventInfo)) {
+        event::add_fn(self.raw(), event as u32, callback);
     }
 
     /// Delete the object
@@ -160,13 +211,91 @@ pub trait LvglObj {
     }
 }
 
-/// Trampoline function for event callbacks
-unsafe extern "C" fn event_callback_trampoline(e: *mut sys::lv_event_t) {
-    let user_data = sys::lv_event_get_user_data(e);
-    if !user_data.is_null() {
-        let callback = &mut *(user_data as *mut Box<dyn FnMut()>);
-        callback();
+// =============================================================================
+// Style batching
+// =============================================================================
+
+/// Number of open [`StyleBatch`]es
+static mut BATCH_DEPTH: u32 = 0;
+
+/// Object of the outermost open batch
+static mut BATCH_ROOT: *mut sys::lv_obj_t = core::ptr::null_mut();
+
+/// What a [`StyleBatch`] refreshes when it ends
+#[derive(Clone, Copy)]
+enum BatchScope {
+    /// The object and its descendants; the object may be deleted meanwhile
+    Tree,
+    /// One property (selector, prop) of the object alone
+    Prop(u32, u8),
+}
+
+/// Suspends LVGL style refreshes until dropped, then refreshes `obj`
+struct StyleBatch {
+    obj: *mut sys::lv_obj_t,
+    scope: BatchScope,
+}
+
+impl StyleBatch {
+    fn begin(obj: *mut sys::lv_obj_t, scope: BatchScope) -> Self {
+        unsafe {
+            if BATCH_DEPTH == 0 {
+                BATCH_ROOT = obj;
+                sys::lv_obj_enable_style_refresh(false);
+            }
+            BATCH_DEPTH += 1;
+        }
+        Self { obj, scope }
+    }
+
+    unsafe fn refresh(&self) {
+        match self.scope {
+            BatchScope::Tree => refresh_tree(self.obj),
+            BatchScope::Prop(selector, prop) => sys::lv_obj_refresh_style(self.obj, selector, prop),
+        }
+    }
+}
+
+impl Drop for StyleBatch {
+    fn drop(&mut self) {
+        unsafe {
+            BATCH_DEPTH -= 1;
+            let alive = match self.scope {
+                BatchScope::Tree => sys::lv_obj_is_valid(self.obj),
+                BatchScope::Prop(..) => true,
+            };
+            if BATCH_DEPTH == 0 {
+                sys::lv_obj_enable_style_refresh(true);
+                if alive {
+                    self.refresh();
+                }
+            } else if alive && !is_within(self.obj, BATCH_ROOT) {
+                // The outer batch won't reach this object
+                sys::lv_obj_enable_style_refresh(true);
+                self.refresh();
+                sys::lv_obj_enable_style_refresh(false);
+            }
+        }
+    }
+}
+
+/// True if `obj` is `root` or one of its descendants
+unsafe fn is_within(mut obj: *mut sys::lv_obj_t, root: *mut sys::lv_obj_t) -> bool {
+    while !obj.is_null() {
+        if obj == root {
+            return true;
+        }
+        obj = sys::lv_obj_get_parent(obj);
     }
+    false
+}
+
+/// Fully refresh the styles of `obj` and every descendant
+///
+/// With `LV_STYLE_PROP_ANY` LVGL walks the subtree itself, sending each
+/// descendant `LV_EVENT_STYLE_CHANGED` once.
+unsafe fn refresh_tree(obj: *mut sys::lv_obj_t) {
+    sys::lv_obj_refresh_style(obj, sys::LV_PART_ANY, sys::LV_STYLE_PROP_ANY as u8);
 }
 
 /// Generic LVGL object wrapper
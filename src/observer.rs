@@ -0,0 +1,386 @@
+//! Reactive values on LVGL's observer (`lv_subject_t`)
+//!
+//! A [`Subject`] holds one value that widgets are bound to, so a sensor
+//! reading is published once instead of being written into every widget
+//! that shows it:
+//!
+//! ```ignore
+//! static TEMPERATURE: Subject<i32> = Subject::new(0);
+//!
+//! // UI thread
+//! label.bind_text(&TEMPERATURE, c"%d °C")?;
+//! bar.bind_value(&TEMPERATURE)?;
+//! unsafe { TEMPERATURE.subscribe(|t| log::info!("temperature {}", t)) }?;
+//!
+//! // Sensor task
+//! TEMPERATURE.publish(read_sensor());
+//!
+//! // UI loop; RunLoop::run_once does this itself
+//! unsafe { lvgl::observer::flush() };
+//! lvgl::task_handler();
+//! ```
+//!
+//! [`publish`](Subject::publish) works from any thread and only records the
+//! value. [`flush`] then notifies each published subject once with its
+//! latest value, so several updates within a frame reach the widgets as
+//! one, and an unchanged value not at all. Bindings live as long as their
+//! widget and need no callback storage on the Rust side.
+//!
+//! Everything else touches the LVGL subject and its observer list. A
+//! `static` subject is reachable from every thread, so those calls are
+//! `unsafe` and must be made on the thread that runs LVGL; the widget
+//! bindings are safe because holding a widget already means being there.
+
+// LvglObj is only used by the widget bindings
+#![cfg_attr(not(feature = "all-widgets"), allow(unused_imports))]
+
+use crate::{LvglError, LvglObj, Result};
+use core::cell::UnsafeCell;
+use core::ffi::c_void;
+use core::mem::{self, MaybeUninit};
+use core::ptr;
+use core::sync::atomic::{AtomicBool, AtomicI32, AtomicPtr, Ordering};
+use lvgl_sys as sys;
+
+#[cfg(feature = "widget-arc")]
+use crate::widgets::Arc;
+#[cfg(feature = "widget-bar")]
+use crate::widgets::Bar;
+#[cfg(feature = "widget-label")]
+use crate::widgets::Label;
+#[cfg(feature = "widget-slider")]
+use crate::widgets::Slider;
+#[cfg(feature = "widget-label")]
+use core::ffi::CStr;
+
+/// Value types a [`Subject`] can hold, kept in an LVGL integer subject
+pub trait SubjectValue: Copy + Send + 'static {
+    fn to_raw(self) -> i32;
+    fn from_raw(raw: i32) -> Self;
+}
+
+macro_rules! int_subject_value {
+    ($($ty:ty),*) => {
+        $(
+            impl SubjectValue for $ty {
+                fn to_raw(self) -> i32 {
+                    self as i32
+                }
+
+                fn from_raw(raw: i32) -> Self {
+                    raw as $ty
+                }
+            }
+        )*
+    };
+}
+
+int_subject_value!(i32, i16, u16, i8, u8);
+
+impl SubjectValue for bool {
+    fn to_raw(self) -> i32 {
+        self as i32
+    }
+
+    fn from_raw(raw: i32) -> Self {
+        raw != 0
+    }
+}
+
+// =============================================================================
+// Subjects
+// =============================================================================
+
+/// Untyped part of a subject, linked into the published list
+struct Core {
+    /// Set up on the UI thread by the first use
+    raw: UnsafeCell<MaybeUninit<sys::lv_subject_t>>,
+    initialized: AtomicBool,
+    /// Latest published value, applied by [`flush`]
+    published: AtomicI32,
+    queued: AtomicBool,
+    next: AtomicPtr<Core>,
+}
+
+/// Subjects published since the last [`flush`]
+static PUBLISHED: AtomicPtr<Core> = AtomicPtr::new(ptr::null_mut());
+
+impl Core {
+    /// The LVGL subject, initialized to `initial` on first use
+    ///
+    /// # Safety
+    /// Must only be called from the thread that runs LVGL.
+    unsafe fn subject(&self, initial: i32) -> *mut sys::lv_subject_t {
+        let raw = (*self.raw.get()).as_mut_ptr();
+        if !self.initialized.load(Ordering::Relaxed) {
+            sys::lv_subject_init_int(raw, initial);
+            self.initialized.store(true, Ordering::Relaxed);
+        }
+        raw
+    }
+
+    /// Take the latest published value and notify observers if it changed
+    unsafe fn apply(&self) {
+        // Swapped, not stored, so a concurrent publish either is seen here
+        // or queues the subject again
+        self.queued.swap(false, Ordering::AcqRel);
+        let value = self.published.load(Ordering::Acquire);
+        // A subject set up here has no observers yet
+        let observed = self.initialized.load(Ordering::Relaxed);
+        let raw = self.subject(value);
+        if observed && sys::lv_subject_get_int(raw) != value {
+            sys::lv_subject_set_int(raw, value);
+        }
+    }
+}
+
+/// Observable value shared by widgets and tasks
+///
+/// Meant for `static`s: LVGL links observers to the subject's address, so
+/// everything that binds or publishes takes `&'static self`. The LVGL side
+/// is set up by the first use on the UI thread.
+pub struct Subject<T: SubjectValue> {
+    core: Core,
+    initial: T,
+}
+
+// The LVGL subject is only touched on the UI thread; other threads go
+// through the atomics in publish()
+unsafe impl<T: SubjectValue> Sync for Subject<T> {}
+unsafe impl<T: SubjectValue> Send for Subject<T> {}
+
+impl<T: SubjectValue> Subject<T> {
+    /// Create a subject holding `initial` (usable in a `static`)
+    pub const fn new(initial: T) -> Self {
+        Self {
+            core: Core {
+                raw: UnsafeCell::new(MaybeUninit::uninit()),
+                initialized: AtomicBool::new(false),
+                published: AtomicI32::new(0),
+                queued: AtomicBool::new(false),
+                next: AtomicPtr::new(ptr::null_mut()),
+            },
+            initial,
+        }
+    }
+
+    /// Publish a new value from any thread
+    ///
+    /// Observers see it at the next [`flush`]; only the last value
+    /// published before it counts. Wakes a sleeping
+    /// [`RunLoop`](crate::RunLoop).
+    pub fn publish(&'static self, value: T) {
+        self.core.published.store(value.to_raw(), Ordering::Release);
+        if !self.core.queued.swap(true, Ordering::AcqRel) {
+            let core = &self.core as *const Core as *mut Core;
+            let mut head = PUBLISHED.load(Ordering::Relaxed);
+            loop {
+                self.core.next.store(head, Ordering::Relaxed);
+                match PUBLISHED.compare_exchange_weak(
+                    head,
+                    core,
+                    Ordering::Release,
+                    Ordering::Relaxed,
+                ) {
+                    Ok(_) => break,
+                    Err(current) => head = current,
+                }
+            }
+        }
+        crate::wake();
+    }
+
+    /// Set the value and notify observers right away
+    ///
+    /// # Safety
+    /// Must only be called from the thread that runs LVGL.
+    pub unsafe fn set(&'static self, value: T) {
+        sys::lv_subject_set_int(self.raw(), value.to_raw())
+    }
+
+    /// Current value as observers last saw it, including changes made by
+    /// bound sliders and arcs
+    ///
+    /// # Safety
+    /// Must only be called from the thread that runs LVGL.
+    pub unsafe fn get(&'static self) -> T {
+        T::from_raw(sys::lv_subject_get_int(self.raw()))
+    }
+
+    /// Call `callback` with the current value and after every change
+    ///
+    /// A plain function, stored in the observer itself.
+    ///
+    /// # Safety
+    /// Must only be called from the thread that runs LVGL, which is also
+    /// where `callback` runs.
+    pub unsafe fn subscribe(&'static self, callback: fn(T)) -> Result<Observer> {
+        let observer =
+            sys::lv_subject_add_observer(self.raw(), Some(call_fn::<T>), callback as *mut c_void);
+        Observer::from_raw(observer)
+    }
+
+    /// Raw LVGL subject, set up on first use
+    ///
+    /// # Safety
+    /// Must only be called from the thread that runs LVGL.
+    pub unsafe fn raw(&'static self) -> *mut sys::lv_subject_t {
+        self.core.subject(self.initial.to_raw())
+    }
+}
+
+unsafe extern "C" fn call_fn<T: SubjectValue>(
+    observer: *mut sys::lv_observer_t,
+    subject: *mut sys::lv_subject_t,
+) {
+    let callback: fn(T) = mem::transmute(sys::lv_observer_get_user_data(observer));
+    callback(T::from_raw(sys::lv_subject_get_int(subject)));
+}
+
+/// Notify the observers of every subject published since the last call
+///
+/// One pass per frame: call right before [`crate::task_handler`] if you
+/// don't use [`RunLoop`](crate::RunLoop). Returns the number of subjects
+/// applied.
+///
+/// # Safety
+/// Must only be called from the thread that runs LVGL.
+pub unsafe fn flush() -> usize {
+    let mut next = PUBLISHED.swap(ptr::null_mut(), Ordering::Acquire);
+    let mut applied = 0;
+    while let Some(core) = next.as_ref() {
+        // Read before apply() lets a publish reuse the link
+        next = core.next.load(Ordering::Relaxed);
+        core.apply();
+        applied += 1;
+    }
+    applied
+}
+
+/// Registration of a [`Subject::subscribe`] callback
+pub struct Observer {
+    raw: *mut sys::lv_observer_t,
+}
+
+impl Observer {
+    unsafe fn from_raw(raw: *mut sys::lv_observer_t) -> Result<Self> {
+        if raw.is_null() {
+            Err(LvglError::OutOfMemory)
+        } else {
+            Ok(Self { raw })
+        }
+    }
+
+    /// Stop calling the callback
+    pub fn remove(self) {
+        unsafe { sys::lv_observer_remove(self.raw) }
+    }
+}
+
+// =============================================================================
+// Widget bindings
+// =============================================================================
+
+/// Check a binding's observer (removed with its widget)
+fn bound(observer: *mut sys::lv_observer_t) -> Result<()> {
+    if observer.is_null() {
+        Err(LvglError::OutOfMemory)
+    } else {
+        Ok(())
+    }
+}
+
+#[cfg(feature = "widget-label")]
+impl Label {
+    /// Show `subject` formatted with `fmt`, a printf format taking one
+    /// `int` such as `c"%d %%"`
+    ///
+    /// Returns [`LvglError::InvalidParameter`] unless `fmt` has exactly one
+    /// conversion and it is `d`, `i`, `u`, `x`, `X`, `o` or `c` without a
+    /// length modifier or `*`.
+    pub fn bind_text<T: SubjectValue>(
+        &self,
+        subject: &'static Subject<T>,
+        fmt: &'static CStr,
+    ) -> Result<()> {
+        if !is_int_format(fmt) {
+            return Err(LvglError::InvalidParameter);
+        }
+        bound(unsafe { sys::lv_label_bind_text(self.raw(), subject.raw(), fmt.as_ptr()) })
+    }
+}
+
+/// True if `fmt` consumes exactly one `int` argument
+#[cfg(feature = "widget-label")]
+fn is_int_format(fmt: &CStr) -> bool {
+    let fmt = fmt.to_bytes();
+    let mut conversions = 0;
+    let mut i = 0;
+    while i < fmt.len() {
+        if fmt[i] != b'%' {
+            i += 1;
+            continue;
+        }
+        i += 1;
+        if fmt.get(i) == Some(&b'%') {
+            i += 1;
+            continue;
+        }
+        // Flags, width and precision; `*` would read another argument
+        while matches!(
+            fmt.get(i),
+            Some(b'-' | b'+' | b' ' | b'#' | b'.' | b'0'..=b'9')
+        ) {
+            i += 1;
+        }
+        match fmt.get(i) {
+            Some(b'd' | b'i' | b'u' | b'x' | b'X' | b'o' | b'c') => conversions += 1,
+            _ => return false,
+        }
+        i += 1;
+    }
+    conversions == 1
+}
+
+#[cfg(feature = "widget-bar")]
+impl Bar {
+    /// Show `subject` as the bar value
+    pub fn bind_value<T: SubjectValue>(&self, subject: &'static Subject<T>) -> Result<()> {
+        bound(unsafe {
+            sys::lv_subject_add_observer_obj(
+                subject.raw(),
+                Some(bar_value_cb),
+                self.raw(),
+                ptr::null_mut(),
+            )
+        })
+    }
+}
+
+#[cfg(feature = "widget-bar")]
+unsafe extern "C" fn bar_value_cb(
+    observer: *mut sys::lv_observer_t,
+    subject: *mut sys::lv_subject_t,
+) {
+    sys::lv_bar_set_value(
+        sys::lv_observer_get_target_obj(observer),
+        sys::lv_subject_get_int(subject),
+        sys::LV_ANIM_OFF,
+    );
+}
+
+#[cfg(feature = "widget-slider")]
+impl Slider {
+    /// Keep the slider and `subject` in sync in both directions
+    pub fn bind_value<T: SubjectValue>(&self, subject: &'static Subject<T>) -> Result<()> {
+        bound(unsafe { sys::lv_slider_bind_value(self.raw(), subject.raw()) })
+    }
+}
+
+#[cfg(feature = "widget-arc")]
+impl Arc {
+    /// Keep the arc and `subject` in sync in both directions
+    pub fn bind_value<T: SubjectValue>(&self, subject: &'static Subject<T>) -> Result<()> {
+        bound(unsafe { sys::lv_arc_bind_value(self.raw(), subject.raw()) })
+    }
+}
@@ -0,0 +1,290 @@
+//! Frame timing and flush instrumentation
+//!
+//! [`Display::set_frame_observer`](crate::Display::set_frame_observer)
+//! listens to the display's refresh, render and flush events and produces
+//! one [`FrameStats`] record per refresh that drew anything. Records go to a
+//! [`FrameObserver`], usually a [`FrameStatsRing`] that another thread
+//! drains for logging or telemetry:
+//!
+//! ```ignore
+//! static FRAMES: FrameStatsRing<64> = FrameStatsRing::new();
+//!
+//! display.set_frame_observer(&FRAMES, now_us);
+//!
+//! // Telemetry task
+//! while let Some(frame) = unsafe { FRAMES.pop() } {
+//!     if frame.total_us > 33_000 {
+//!         report_slow_frame(&frame);
+//!     }
+//! }
+//! ```
+//!
+//! This replaces LVGL's on-screen performance monitor
+//! (`LV_USE_PERF_MONITOR`), which stays disabled. No work is done on displays
+//! without an observer.
+
+use crate::display::ColorFormat;
+use core::cell::UnsafeCell;
+use core::sync::atomic::{AtomicU32, AtomicUsize, Ordering};
+use lvgl_sys as sys;
+
+/// Timings and counters of one display refresh
+///
+/// Durations are in microseconds of the observer's clock. `render_us`
+/// excludes the time spent in the flush callback and waiting for
+/// `flush_ready`, which LVGL interleaves with rendering.
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub struct FrameStats {
+    /// Clock value when the refresh started
+    pub start_us: u64,
+    /// From the first invalidation since the last refresh to its start
+    pub invalidate_us: u32,
+    /// Layout update and joining of dirty areas
+    pub layout_us: u32,
+    /// Drawing
+    pub render_us: u32,
+    /// Inside the flush callback
+    pub flush_us: u32,
+    /// Blocked until the previous flush reported `flush_ready`
+    pub flush_wait_us: u32,
+    /// Whole refresh
+    pub total_us: u32,
+    /// Invalidated areas, before LVGL joins overlapping ones
+    pub dirty_areas: u32,
+    /// Pixels of the invalidated areas
+    pub dirty_pixels: u32,
+    /// Areas passed to the flush callback
+    pub flushed_areas: u32,
+    /// Bytes of pixel data passed to the flush callback
+    pub flushed_bytes: u32,
+}
+
+/// Receiver of per-refresh records
+///
+/// Called on the LVGL thread at the end of every refresh that drew
+/// something, so keep it short.
+pub trait FrameObserver: Sync {
+    fn frame(&self, stats: &FrameStats);
+}
+
+#[allow(clippy::declare_interior_mutable_const)]
+const EMPTY_FRAME: UnsafeCell<FrameStats> = UnsafeCell::new(FrameStats {
+    start_us: 0,
+    invalidate_us: 0,
+    layout_us: 0,
+    render_us: 0,
+    flush_us: 0,
+    flush_wait_us: 0,
+    total_us: 0,
+    dirty_areas: 0,
+    dirty_pixels: 0,
+    flushed_areas: 0,
+    flushed_bytes: 0,
+});
+
+/// Lock-free single-producer ring of [`FrameStats`]
+///
+/// LVGL pushes from its own thread; one reader pops, from any thread. When
+/// the ring is full new records are dropped and counted, so a stalled reader
+/// never slows rendering down. `N` must be a power of two.
+pub struct FrameStatsRing<const N: usize> {
+    slots: [UnsafeCell<FrameStats>; N],
+    head: AtomicUsize,
+    tail: AtomicUsize,
+    recorded: AtomicU32,
+    dropped: AtomicU32,
+}
+
+// Slots are handed over through head/tail
+unsafe impl<const N: usize> Sync for FrameStatsRing<N> {}
+unsafe impl<const N: usize> Send for FrameStatsRing<N> {}
+
+impl<const N: usize> FrameStatsRing<N> {
+    const VALID_CAPACITY: () = assert!(N.is_power_of_two(), "capacity must be a power of two");
+
+    /// Create an empty ring (usable in a `static`)
+    pub const fn new() -> Self {
+        let () = Self::VALID_CAPACITY;
+        Self {
+            slots: [EMPTY_FRAME; N],
+            head: AtomicUsize::new(0),
+            tail: AtomicUsize::new(0),
+            recorded: AtomicU32::new(0),
+            dropped: AtomicU32::new(0),
+        }
+    }
+
+    /// Oldest record
+    ///
+    /// # Safety
+    /// Only one thread may pop at a time.
+    pub unsafe fn pop(&self) -> Option<FrameStats> {
+        let tail = self.tail.load(Ordering::Relaxed);
+        if tail == self.head.load(Ordering::Acquire) {
+            return None;
+        }
+        let stats = *self.slots[tail & (N - 1)].get();
+        self.tail.store(tail.wrapping_add(1), Ordering::Release);
+        Some(stats)
+    }
+
+    /// Number of records waiting
+    pub fn len(&self) -> usize {
+        self.head
+            .load(Ordering::Acquire)
+            .wrapping_sub(self.tail.load(Ordering::Acquire))
+    }
+
+    /// True if no records are waiting
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Refreshes recorded since start, including dropped ones
+    pub fn recorded(&self) -> u32 {
+        self.recorded.load(Ordering::Relaxed)
+    }
+
+    /// Records dropped because the ring was full
+    pub fn dropped(&self) -> u32 {
+        self.dropped.load(Ordering::Relaxed)
+    }
+}
+
+impl<const N: usize> FrameObserver for FrameStatsRing<N> {
+    fn frame(&self, stats: &FrameStats) {
+        self.recorded.fetch_add(1, Ordering::Relaxed);
+        // The LVGL thread is the only producer
+        let head = self.head.load(Ordering::Relaxed);
+        if head.wrapping_sub(self.tail.load(Ordering::Acquire)) == N {
+            self.dropped.fetch_add(1, Ordering::Relaxed);
+            return;
+        }
+        unsafe { *self.slots[head & (N - 1)].get() = *stats };
+        self.head.store(head.wrapping_add(1), Ordering::Release);
+    }
+}
+
+impl<const N: usize> Default for FrameStatsRing<N> {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+// =============================================================================
+// Display event probe
+// =============================================================================
+
+/// Per-display measuring state, kept with the display's driver data
+pub(crate) struct Probe {
+    observer: &'static dyn FrameObserver,
+    now_us: fn() -> u64,
+    /// Refresh being measured
+    frame: FrameStats,
+    rendering: bool,
+    /// Since the last refresh started rendering
+    first_invalidate: Option<u64>,
+    dirty_areas: u32,
+    dirty_pixels: u32,
+    render_start: u64,
+    flush_start: u64,
+    wait_start: u64,
+}
+
+impl Probe {
+    pub(crate) fn new(observer: &'static dyn FrameObserver, now_us: fn() -> u64) -> Self {
+        Self {
+            observer,
+            now_us,
+            frame: FrameStats::default(),
+            rendering: false,
+            first_invalidate: None,
+            dirty_areas: 0,
+            dirty_pixels: 0,
+            render_start: 0,
+            flush_start: 0,
+            wait_start: 0,
+        }
+    }
+}
+
+fn elapsed(from: u64, to: u64) -> u32 {
+    to.saturating_sub(from).min(u32::MAX as u64) as u32
+}
+
+fn area_pixels(area: &sys::lv_area_t) -> u32 {
+    ((area.x2 - area.x1 + 1).max(0) * (area.y2 - area.y1 + 1).max(0)) as u32
+}
+
+/// Display event callback (`LV_EVENT_ALL`), registered once per display
+pub(crate) unsafe extern "C" fn probe_cb(e: *mut sys::lv_event_t) {
+    let code = sys::lv_event_get_code(e);
+    // The probe may already be freed along with the display state
+    if code == sys::LV_EVENT_DELETE {
+        return;
+    }
+    let disp = sys::lv_event_get_target(e) as *mut sys::lv_display_t;
+    let p = match crate::display::frame_probe(disp) {
+        Some(p) => p,
+        None => return,
+    };
+
+    let param = sys::lv_event_get_param(e) as *const sys::lv_area_t;
+    match code {
+        sys::LV_EVENT_INVALIDATE_AREA if !param.is_null() => {
+            if p.first_invalidate.is_none() {
+                p.first_invalidate = Some((p.now_us)());
+            }
+            p.dirty_areas += 1;
+            p.dirty_pixels = p.dirty_pixels.saturating_add(area_pixels(&*param));
+        }
+        sys::LV_EVENT_REFR_START => {
+            p.frame = FrameStats {
+                start_us: (p.now_us)(),
+                ..FrameStats::default()
+            };
+            p.rendering = false;
+        }
+        sys::LV_EVENT_RENDER_START => {
+            let now = (p.now_us)();
+            p.render_start = now;
+            p.rendering = true;
+            p.frame.layout_us = elapsed(p.frame.start_us, now);
+            p.frame.invalidate_us = p
+                .first_invalidate
+                .take()
+                .map_or(0, |t| elapsed(t, p.frame.start_us));
+            p.frame.dirty_areas = core::mem::take(&mut p.dirty_areas);
+            p.frame.dirty_pixels = core::mem::take(&mut p.dirty_pixels);
+        }
+        sys::LV_EVENT_FLUSH_START => {
+            p.flush_start = (p.now_us)();
+            p.frame.flushed_areas += 1;
+            if !param.is_null() {
+                let format = ColorFormat::from_raw(sys::lv_display_get_color_format(disp))
+                    .unwrap_or(ColorFormat::native());
+                let bytes = format.area_size(&*param) as u32;
+                p.frame.flushed_bytes = p.frame.flushed_bytes.saturating_add(bytes);
+            }
+        }
+        sys::LV_EVENT_FLUSH_FINISH => {
+            p.frame.flush_us += elapsed(p.flush_start, (p.now_us)());
+        }
+        sys::LV_EVENT_FLUSH_WAIT_START => {
+            p.wait_start = (p.now_us)();
+        }
+        sys::LV_EVENT_FLUSH_WAIT_FINISH => {
+            p.frame.flush_wait_us += elapsed(p.wait_start, (p.now_us)());
+        }
+        sys::LV_EVENT_RENDER_READY if p.rendering => {
+            let busy = elapsed(p.render_start, (p.now_us)());
+            p.frame.render_us = busy.saturating_sub(p.frame.flush_us + p.frame.flush_wait_us);
+        }
+        sys::LV_EVENT_REFR_READY if p.rendering => {
+            p.rendering = false;
+            p.frame.total_us = elapsed(p.frame.start_us, (p.now_us)());
+            p.observer.frame(&p.frame);
+        }
+        _ => {}
+    }
+}
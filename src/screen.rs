@@ -0,0 +1,518 @@
+//! Screen preloading and caching
+//!
+//! Loading a screen that still has to be built costs the construction plus a
+//! full render in a single frame. [`ScreenCache`] instead builds screens in
+//! short slices from an LVGL timer, between frames ([`ScreenCache::preload`]),
+//! and keeps up to `capacity` of them resident, deleting the least recently
+//! used one when a new screen needs room.
+//!
+//! With [`ScreenCache::enable_snapshots`] every cached screen also gets a
+//! pre-allocated snapshot buffer (e.g. in PSRAM). Screens are rendered into
+//! it once built and again after they are left. An animated
+//! [`load`](ScreenCache::load) then moves the snapshot image instead of the
+//! live widget tree and swaps the real screen in when the animation ends.
+//!
+//! ```ignore
+//! #[derive(Clone, Copy, PartialEq)]
+//! enum Page { Home, Settings }
+//!
+//! let mut screens = ScreenCache::new(2);
+//! screens.enable_snapshots(&PsramAllocator, ColorFormat::native())?;
+//! screens.preload(Page::Settings, SettingsBuilder::default())?;
+//!
+//! // Later, usually many frames after the build has finished
+//! screens.load(Page::Settings, ScreenAnim::MoveLeft, 200, 0)?;
+//! ```
+
+use crate::display::{BufferAllocator, ColorFormat, DRAW_BUF_ALIGN};
+use crate::{LvglError, Obj, Result};
+use alloc::boxed::Box;
+use alloc::vec::Vec;
+use core::ffi::c_void;
+use core::marker::PhantomData;
+use core::ptr;
+use lvgl_sys as sys;
+
+/// Default build time per slice, in milliseconds
+const DEFAULT_BUILD_BUDGET_MS: u32 = 4;
+
+/// Period of the build timer, leaving time to render in between slices
+const BUILD_PERIOD_MS: u32 = 10;
+
+/// Wait after a transition before re-snapshotting the screen that was left
+const SNAPSHOT_SETTLE_MS: u32 = 50;
+
+/// Builds a screen a piece at a time
+///
+/// Implemented for `FnMut(&Obj) -> Result<bool>` closures.
+pub trait ScreenBuilder {
+    /// Add the next part of the UI to `screen`
+    ///
+    /// Returns `Ok(true)` once the screen is complete. Keep each step short,
+    /// e.g. one row of widgets; steps run until the slice budget is used up.
+    fn step(&mut self, screen: &Obj) -> Result<bool>;
+}
+
+impl<F: FnMut(&Obj) -> Result<bool>> ScreenBuilder for F {
+    fn step(&mut self, screen: &Obj) -> Result<bool> {
+        self(screen)
+    }
+}
+
+/// Screen load animation
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+#[repr(u32)]
+pub enum ScreenAnim {
+    None = sys::LV_SCR_LOAD_ANIM_NONE,
+    OverLeft = sys::LV_SCR_LOAD_ANIM_OVER_LEFT,
+    OverRight = sys::LV_SCR_LOAD_ANIM_OVER_RIGHT,
+    OverTop = sys::LV_SCR_LOAD_ANIM_OVER_TOP,
+    OverBottom = sys::LV_SCR_LOAD_ANIM_OVER_BOTTOM,
+    MoveLeft = sys::LV_SCR_LOAD_ANIM_MOVE_LEFT,
+    MoveRight = sys::LV_SCR_LOAD_ANIM_MOVE_RIGHT,
+    MoveTop = sys::LV_SCR_LOAD_ANIM_MOVE_TOP,
+    MoveBottom = sys::LV_SCR_LOAD_ANIM_MOVE_BOTTOM,
+    FadeIn = sys::LV_SCR_LOAD_ANIM_FADE_IN,
+    FadeOut = sys::LV_SCR_LOAD_ANIM_FADE_OUT,
+    OutLeft = sys::LV_SCR_LOAD_ANIM_OUT_LEFT,
+    OutRight = sys::LV_SCR_LOAD_ANIM_OUT_RIGHT,
+    OutTop = sys::LV_SCR_LOAD_ANIM_OUT_TOP,
+    OutBottom = sys::LV_SCR_LOAD_ANIM_OUT_BOTTOM,
+}
+
+// =============================================================================
+// Cache entries
+// =============================================================================
+
+/// Pre-allocated snapshot buffer
+struct Snapshot {
+    buf: Box<sys::lv_draw_buf_t>,
+    format: ColorFormat,
+    /// Matches what the screen currently looks like
+    valid: bool,
+}
+
+struct Entry<K> {
+    key: K,
+    screen: *mut sys::lv_obj_t,
+    /// Set while the screen is still being built
+    builder: Option<Box<dyn ScreenBuilder>>,
+    result: Result<()>,
+    budget_ms: u32,
+    /// Runs build slices, then takes the snapshot; null when idle
+    timer: *mut sys::lv_timer_t,
+    snapshot: Option<Snapshot>,
+    last_used: u32,
+}
+
+impl<K> Entry<K> {
+    /// Run [`entry_timer`] every `period` ms until the pending work is done
+    unsafe fn start_timer(&mut self, period: u32) {
+        if self.timer.is_null() {
+            let data = self as *mut Self as *mut c_void;
+            self.timer = sys::lv_timer_create(Some(entry_timer::<K>), period, data);
+        } else {
+            sys::lv_timer_set_period(self.timer, period);
+            sys::lv_timer_reset(self.timer);
+        }
+    }
+
+    unsafe fn stop_timer(&mut self) {
+        if !self.timer.is_null() {
+            sys::lv_timer_delete(self.timer);
+            self.timer = ptr::null_mut();
+        }
+    }
+
+    /// Build for up to `budget_ms`; returns true once the screen is complete
+    unsafe fn build_slice(&mut self, budget_ms: u32) -> bool {
+        let Some(builder) = self.builder.as_mut() else {
+            return true;
+        };
+        let screen = Obj::from_raw(self.screen);
+        let start = sys::lv_tick_get();
+        loop {
+            match builder.step(&screen) {
+                Ok(false) => {}
+                Ok(true) => break,
+                Err(err) => {
+                    self.result = Err(err);
+                    break;
+                }
+            }
+            if sys::lv_tick_elaps(start) >= budget_ms {
+                return false;
+            }
+        }
+        self.builder = None;
+        true
+    }
+
+    /// Render the screen into its snapshot buffer
+    unsafe fn take_snapshot(&mut self) {
+        if let Some(snap) = self.snapshot.as_mut() {
+            let buf: *mut sys::lv_draw_buf_t = &mut *snap.buf;
+            let res = sys::lv_snapshot_take_to_draw_buf(self.screen, snap.format as u32, buf);
+            // The buffer is reused, so drop any decoded copy of the old content
+            sys::lv_image_cache_drop(buf as *const c_void);
+            snap.valid = res == sys::LV_RESULT_OK;
+        }
+    }
+}
+
+unsafe extern "C" fn entry_timer<K>(timer: *mut sys::lv_timer_t) {
+    let entry = &mut *(sys::lv_timer_get_user_data(timer) as *mut Entry<K>);
+    if !entry.build_slice(entry.budget_ms) {
+        return;
+    }
+    // A visible screen keeps changing; it is snapshotted after it is left
+    if sys::lv_screen_active() != entry.screen {
+        entry.take_snapshot();
+    }
+    entry.stop_timer();
+}
+
+/// Swap the real screen in once the snapshot's transition has finished
+unsafe extern "C" fn proxy_loaded(e: *mut sys::lv_event_t) {
+    // Deferred, as LVGL is still finishing the load that sent this event
+    let proxy = sys::lv_event_get_current_target_obj(e);
+    sys::lv_async_call(Some(show_proxy_target), proxy as *mut c_void);
+}
+
+unsafe extern "C" fn show_proxy_target(proxy: *mut c_void) {
+    let proxy = proxy as *mut sys::lv_obj_t;
+    // Another screen may have been loaded meanwhile
+    if sys::lv_screen_active() == proxy {
+        sys::lv_screen_load(sys::lv_obj_get_user_data(proxy) as *mut sys::lv_obj_t);
+    }
+}
+
+// =============================================================================
+// Screen cache
+// =============================================================================
+
+/// Bounded set of preloaded screens, evicted least recently used first
+pub struct ScreenCache<K> {
+    entries: Vec<Box<Entry<K>>>,
+    capacity: usize,
+    /// Snapshot buffers not assigned to a screen
+    spare_snapshots: Vec<Snapshot>,
+    budget_ms: u32,
+    /// Screen with a full-size image, shown while a snapshot is animated in
+    proxy: *mut sys::lv_obj_t,
+    proxy_image: *mut sys::lv_obj_t,
+    clock: u32,
+    _marker: PhantomData<*mut ()>,
+}
+
+impl<K: Copy + PartialEq + 'static> ScreenCache<K> {
+    /// Create a cache keeping at most `capacity` screens (at least 1)
+    ///
+    /// Screens that are on the display or animating are never deleted, so
+    /// the cache can briefly hold more while they are in use.
+    pub fn new(capacity: usize) -> Self {
+        Self {
+            entries: Vec::new(),
+            capacity: capacity.max(1),
+            spare_snapshots: Vec::new(),
+            budget_ms: DEFAULT_BUILD_BUDGET_MS,
+            proxy: ptr::null_mut(),
+            proxy_image: ptr::null_mut(),
+            clock: 0,
+            _marker: PhantomData,
+        }
+    }
+
+    /// Allocate one screen-sized snapshot buffer per cache slot
+    ///
+    /// Buffers come from `allocator` (e.g. PSRAM) and are reused as screens
+    /// are evicted and preloaded, never freed. `format` must be RGB565,
+    /// RGB888, XRGB8888 or ARGB8888, normally [`ColorFormat::native`].
+    /// Sized for the default display's resolution.
+    pub fn enable_snapshots(
+        &mut self,
+        allocator: &impl BufferAllocator,
+        format: ColorFormat,
+    ) -> Result<()> {
+        if !matches!(
+            format,
+            ColorFormat::Rgb565 | ColorFormat::Rgb888 | ColorFormat::Xrgb8888 | ColorFormat::Argb8888
+        ) {
+            return Err(LvglError::InvalidParameter);
+        }
+        let (width, height) = unsafe {
+            let disp = sys::lv_display_get_default();
+            if disp.is_null() {
+                return Err(LvglError::DisplayError);
+            }
+            (
+                sys::lv_display_get_horizontal_resolution(disp) as u32,
+                sys::lv_display_get_vertical_resolution(disp) as u32,
+            )
+        };
+        let size = format.buf_size(width, height);
+
+        let assigned = self.entries.iter().filter(|e| e.snapshot.is_some()).count();
+        let missing = self.capacity.saturating_sub(assigned + self.spare_snapshots.len());
+        for _ in 0..missing {
+            let data = unsafe { allocator.allocate(size, DRAW_BUF_ALIGN) };
+            if data.is_null() {
+                return Err(LvglError::OutOfMemory);
+            }
+            let mut buf = Box::<sys::lv_draw_buf_t>::default();
+            let res = unsafe {
+                sys::lv_draw_buf_init(
+                    &mut *buf,
+                    width,
+                    height,
+                    format as u32,
+                    format.stride(width) as u32,
+                    data as *mut c_void,
+                    size as u32,
+                )
+            };
+            if res != sys::LV_RESULT_OK {
+                unsafe { allocator.deallocate(data, size, DRAW_BUF_ALIGN) };
+                return Err(LvglError::InvalidParameter);
+            }
+            self.spare_snapshots.push(Snapshot {
+                buf,
+                format,
+                valid: false,
+            });
+        }
+
+        // Screens cached before this call get theirs once they are left
+        for entry in self.entries.iter_mut() {
+            if entry.snapshot.is_none() {
+                entry.snapshot = self.spare_snapshots.pop();
+            }
+        }
+        Ok(())
+    }
+
+    /// Time spent building per slice, in milliseconds (default 4)
+    pub fn set_build_budget(&mut self, ms: u32) {
+        self.budget_ms = ms.max(1);
+    }
+
+    /// Start building a screen in the background
+    ///
+    /// `builder` runs in short slices from an LVGL timer, so the UI stays
+    /// responsive. Does nothing if `key` is already cached. May evict the
+    /// least recently used screen.
+    pub fn preload(&mut self, key: K, builder: impl ScreenBuilder + 'static) -> Result<()> {
+        if self.position(key).is_some() {
+            return Ok(());
+        }
+        self.make_room();
+
+        let screen = unsafe { sys::lv_obj_create(ptr::null_mut()) };
+        if screen.is_null() {
+            return Err(LvglError::OutOfMemory);
+        }
+        let mut entry = Box::new(Entry {
+            key,
+            screen,
+            builder: Some(Box::new(builder)),
+            result: Ok(()),
+            budget_ms: self.budget_ms,
+            timer: ptr::null_mut(),
+            snapshot: self.spare_snapshots.pop(),
+            last_used: self.clock,
+        });
+        // The entry is boxed, so the timer's pointer to it stays valid
+        unsafe { entry.start_timer(BUILD_PERIOD_MS) };
+        self.entries.push(entry);
+        Ok(())
+    }
+
+    /// Make a cached screen active, finishing its build first if needed
+    ///
+    /// With an animation and an up-to-date snapshot, the snapshot is
+    /// animated in and the real screen replaces it at the end. Returns the
+    /// builder's error if building failed, or `InvalidParameter` if `key` is
+    /// not cached.
+    pub fn load(&mut self, key: K, anim: ScreenAnim, time_ms: u32, delay_ms: u32) -> Result<()> {
+        let idx = self.position(key).ok_or(LvglError::InvalidParameter)?;
+        self.clock = self.clock.wrapping_add(1);
+
+        unsafe {
+            // Re-snapshot the screen being left once the transition is over
+            let leaving = self.shown_screen();
+            let clock = self.clock;
+            if let Some(prev) = self.entries.iter_mut().find(|e| e.screen == leaving) {
+                prev.last_used = clock;
+                if prev.snapshot.is_some() && prev.builder.is_none() {
+                    prev.start_timer(time_ms + delay_ms + SNAPSHOT_SETTLE_MS);
+                }
+            }
+
+            let entry = &mut self.entries[idx];
+            entry.build_slice(u32::MAX);
+            entry.stop_timer();
+            entry.last_used = clock;
+            entry.result?;
+
+            let screen = entry.screen;
+            let snapshot = match entry.snapshot.as_mut() {
+                Some(snap) if snap.valid => {
+                    // Stale from now on, as the screen goes live
+                    snap.valid = false;
+                    Some(&*snap.buf as *const sys::lv_draw_buf_t)
+                }
+                _ => None,
+            };
+
+            match snapshot {
+                Some(buf) if anim != ScreenAnim::None && time_ms > 0 => {
+                    let proxy = self.proxy()?;
+                    sys::lv_image_set_src(self.proxy_image, buf as *const c_void);
+                    sys::lv_obj_set_user_data(proxy, screen as *mut c_void);
+                    sys::lv_screen_load_anim(proxy, anim as u32, time_ms, delay_ms, false);
+                }
+                _ => sys::lv_screen_load_anim(screen, anim as u32, time_ms, delay_ms, false),
+            }
+        }
+        Ok(())
+    }
+
+    /// True if `key` is cached (built or still building)
+    pub fn contains(&self, key: K) -> bool {
+        self.position(key).is_some()
+    }
+
+    /// True if `key` is cached and completely built
+    pub fn is_ready(&self, key: K) -> bool {
+        self.position(key)
+            .is_some_and(|idx| self.entries[idx].builder.is_none())
+    }
+
+    /// The cached screen for `key`, which may still be under construction
+    pub fn screen(&self, key: K) -> Option<Obj> {
+        self.position(key)
+            .map(|idx| unsafe { Obj::from_raw(self.entries[idx].screen) })
+    }
+
+    /// Re-render the snapshot of `key`, e.g. after changing a hidden screen
+    pub fn refresh_snapshot(&mut self, key: K) {
+        if let Some(idx) = self.position(key) {
+            let entry = &mut self.entries[idx];
+            if entry.builder.is_none() && unsafe { sys::lv_screen_active() } != entry.screen {
+                unsafe { entry.take_snapshot() };
+            }
+        }
+    }
+
+    /// Delete a cached screen; returns false if it is missing or in use
+    pub fn remove(&mut self, key: K) -> bool {
+        match self.position(key) {
+            Some(idx) if !self.in_use(&self.entries[idx]) => {
+                self.evict(idx);
+                true
+            }
+            _ => false,
+        }
+    }
+
+    fn position(&self, key: K) -> Option<usize> {
+        self.entries.iter().position(|e| e.key == key)
+    }
+
+    /// Screen the user sees, looking through the snapshot proxy
+    fn shown_screen(&self) -> *mut sys::lv_obj_t {
+        unsafe {
+            let active = sys::lv_screen_active();
+            if !active.is_null() && active == self.proxy {
+                sys::lv_obj_get_user_data(active) as *mut sys::lv_obj_t
+            } else {
+                active
+            }
+        }
+    }
+
+    /// True if deleting the entry's screen would break the display
+    fn in_use(&self, entry: &Entry<K>) -> bool {
+        unsafe {
+            entry.screen == self.shown_screen()
+                || entry.screen == sys::lv_screen_active()
+                || !sys::lv_anim_get(entry.screen as *mut c_void, None).is_null()
+        }
+    }
+
+    /// Evict least recently used screens until there is a free slot
+    fn make_room(&mut self) {
+        while self.entries.len() >= self.capacity {
+            let victim = self
+                .entries
+                .iter()
+                .enumerate()
+                .filter(|(_, e)| !self.in_use(e))
+                .max_by_key(|(_, e)| self.clock.wrapping_sub(e.last_used))
+                .map(|(idx, _)| idx);
+            match victim {
+                Some(idx) => self.evict(idx),
+                None => break,
+            }
+        }
+    }
+
+    fn evict(&mut self, idx: usize) {
+        let mut entry = self.entries.swap_remove(idx);
+        unsafe {
+            entry.stop_timer();
+            sys::lv_obj_delete(entry.screen);
+        }
+        if let Some(mut snap) = entry.snapshot.take() {
+            snap.valid = false;
+            self.spare_snapshots.push(snap);
+        }
+    }
+
+    /// Create the snapshot proxy screen on first use
+    unsafe fn proxy(&mut self) -> Result<*mut sys::lv_obj_t> {
+        if self.proxy.is_null() {
+            let proxy = sys::lv_obj_create(ptr::null_mut());
+            if proxy.is_null() {
+                return Err(LvglError::OutOfMemory);
+            }
+            let image = sys::lv_image_create(proxy);
+            if image.is_null() {
+                sys::lv_obj_delete(proxy);
+                return Err(LvglError::OutOfMemory);
+            }
+            sys::lv_obj_remove_style_all(proxy);
+            sys::lv_obj_set_pos(image, 0, 0);
+            sys::lv_obj_add_event_cb(
+                proxy,
+                Some(proxy_loaded),
+                sys::LV_EVENT_SCREEN_LOADED,
+                ptr::null_mut(),
+            );
+            self.proxy = proxy;
+            self.proxy_image = image;
+        }
+        Ok(self.proxy)
+    }
+}
+
+impl<K> Drop for ScreenCache<K> {
+    /// Deletes the cached screens, except one that is still on the display
+    fn drop(&mut self) {
+        unsafe {
+            let active = sys::lv_screen_active();
+            if !self.proxy.is_null() {
+                sys::lv_async_call_cancel(Some(show_proxy_target), self.proxy as *mut c_void);
+                if self.proxy != active {
+                    sys::lv_obj_delete(self.proxy);
+                }
+            }
+            for entry in self.entries.iter_mut() {
+                entry.stop_timer();
+                if entry.screen != active {
+                    sys::lv_obj_delete(entry.screen);
+                }
+            }
+        }
+    }
+}
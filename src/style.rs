@@ -1,8 +1,25 @@
 //! LVGL Style Management
 //!
 //! Styles define the appearance of objects (colors, borders, padding, etc.)
+//!
+//! [`Style`] is built at runtime. For fixed theme styles, [`ConstStyle`] is
+//! built at compile time from a property table (LVGL's `LV_STYLE_CONST`), so
+//! it needs no init call, no heap and no RAM copy:
+//!
+//! ```ignore
+//! static CARD: ConstStyle = const_style![
+//!     bg_color(Color::hex(0x1a1a2e)),
+//!     radius(8),
+//!     pad_top(10),
+//!     pad_bottom(10),
+//! ];
+//!
+//! panel.add_const_style(&CARD, 0);
+//! ```
 
+use crate::font::Font;
 use crate::Color;
+use core::ffi::c_void;
 use core::mem::MaybeUninit;
 use lvgl_sys as sys;
 
@@ -213,6 +230,11 @@ impl Style {
         unsafe { sys::lv_style_set_text_color(&mut self.raw, color.raw()) }
     }
 
+    /// Set text font
+    pub fn set_text_font(&mut self, font: &'static Font) {
+        unsafe { sys::lv_style_set_text_font(&mut self.raw, font.raw()) }
+    }
+
     /// Set text opacity
     pub fn set_text_opa(&mut self, opa: u8) {
         unsafe { sys::lv_style_set_text_opa(&mut self.raw, opa) }
@@ -280,6 +302,313 @@ impl Drop for Style {
     }
 }
 
+// =============================================================================
+// Constant styles
+// =============================================================================
+
+/// One entry of a [`ConstStyle`] property table
+#[derive(Clone, Copy)]
+#[repr(transparent)]
+pub struct StyleProp(sys::lv_style_const_prop_t);
+
+// Only plain values, and pointers the caller promised stay valid
+unsafe impl Sync for StyleProp {}
+
+impl StyleProp {
+    /// Table terminator (`LV_STYLE_CONST_PROPS_END`), appended by [`const_style!`]
+    pub const END: Self = Self(sys::lv_style_const_prop_t {
+        prop: sys::LV_STYLE_PROP_INV as u8,
+        value: sys::lv_style_value_t { num: 0 },
+    });
+
+    /// Numeric property by id (`LV_STYLE_*`)
+    pub const fn num(prop: u8, value: i32) -> Self {
+        Self(sys::lv_style_const_prop_t {
+            prop,
+            value: sys::lv_style_value_t { num: value },
+        })
+    }
+
+    /// Color property by id (`LV_STYLE_*`)
+    pub const fn color(prop: u8, color: Color) -> Self {
+        Self(sys::lv_style_const_prop_t {
+            prop,
+            value: sys::lv_style_value_t { color: color.raw() },
+        })
+    }
+
+    /// Pointer property by id (`LV_STYLE_*`), e.g. a font
+    ///
+    /// # Safety
+    /// `ptr` must stay valid for as long as the style is used.
+    pub const unsafe fn ptr(prop: u8, ptr: *const c_void) -> Self {
+        Self(sys::lv_style_const_prop_t {
+            prop,
+            value: sys::lv_style_value_t { ptr },
+        })
+    }
+
+    // ========================================================================
+    // Background
+    // ========================================================================
+
+    /// Background color
+    pub const fn bg_color(color: Color) -> Self {
+        Self::color(sys::LV_STYLE_BG_COLOR as u8, color)
+    }
+
+    /// Background opacity (0-255)
+    pub const fn bg_opa(opa: u8) -> Self {
+        Self::num(sys::LV_STYLE_BG_OPA as u8, opa as i32)
+    }
+
+    /// Background gradient color
+    pub const fn bg_grad_color(color: Color) -> Self {
+        Self::color(sys::LV_STYLE_BG_GRAD_COLOR as u8, color)
+    }
+
+    /// Background gradient direction
+    pub const fn bg_grad_dir(dir: GradDir) -> Self {
+        Self::num(sys::LV_STYLE_BG_GRAD_DIR as u8, dir as i32)
+    }
+
+    // ========================================================================
+    // Border
+    // ========================================================================
+
+    /// Border color
+    pub const fn border_color(color: Color) -> Self {
+        Self::color(sys::LV_STYLE_BORDER_COLOR as u8, color)
+    }
+
+    /// Border width
+    pub const fn border_width(value: i32) -> Self {
+        Self::num(sys::LV_STYLE_BORDER_WIDTH as u8, value)
+    }
+
+    /// Border opacity
+    pub const fn border_opa(opa: u8) -> Self {
+        Self::num(sys::LV_STYLE_BORDER_OPA as u8, opa as i32)
+    }
+
+    /// Border side
+    pub const fn border_side(side: BorderSide) -> Self {
+        Self::num(sys::LV_STYLE_BORDER_SIDE as u8, side.0 as i32)
+    }
+
+    // ========================================================================
+    // Outline
+    // ========================================================================
+
+    /// Outline color
+    pub const fn outline_color(color: Color) -> Self {
+        Self::color(sys::LV_STYLE_OUTLINE_COLOR as u8, color)
+    }
+
+    /// Outline width
+    pub const fn outline_width(value: i32) -> Self {
+        Self::num(sys::LV_STYLE_OUTLINE_WIDTH as u8, value)
+    }
+
+    /// Outline opacity
+    pub const fn outline_opa(opa: u8) -> Self {
+        Self::num(sys::LV_STYLE_OUTLINE_OPA as u8, opa as i32)
+    }
+
+    // ========================================================================
+    // Padding
+    // ========================================================================
+
+    /// Top padding
+    pub const fn pad_top(value: i32) -> Self {
+        Self::num(sys::LV_STYLE_PAD_TOP as u8, value)
+    }
+
+    /// Bottom padding
+    pub const fn pad_bottom(value: i32) -> Self {
+        Self::num(sys::LV_STYLE_PAD_BOTTOM as u8, value)
+    }
+
+    /// Left padding
+    pub const fn pad_left(value: i32) -> Self {
+        Self::num(sys::LV_STYLE_PAD_LEFT as u8, value)
+    }
+
+    /// Right padding
+    pub const fn pad_right(value: i32) -> Self {
+        Self::num(sys::LV_STYLE_PAD_RIGHT as u8, value)
+    }
+
+    /// Gap between rows
+    pub const fn pad_row(value: i32) -> Self {
+        Self::num(sys::LV_STYLE_PAD_ROW as u8, value)
+    }
+
+    /// Gap between columns
+    pub const fn pad_column(value: i32) -> Self {
+        Self::num(sys::LV_STYLE_PAD_COLUMN as u8, value)
+    }
+
+    // ========================================================================
+    // Size
+    // ========================================================================
+
+    /// Width
+    pub const fn width(value: i32) -> Self {
+        Self::num(sys::LV_STYLE_WIDTH as u8, value)
+    }
+
+    /// Height
+    pub const fn height(value: i32) -> Self {
+        Self::num(sys::LV_STYLE_HEIGHT as u8, value)
+    }
+
+    /// Minimum width
+    pub const fn min_width(value: i32) -> Self {
+        Self::num(sys::LV_STYLE_MIN_WIDTH as u8, value)
+    }
+
+    /// Minimum height
+    pub const fn min_height(value: i32) -> Self {
+        Self::num(sys::LV_STYLE_MIN_HEIGHT as u8, value)
+    }
+
+    /// Maximum width
+    pub const fn max_width(value: i32) -> Self {
+        Self::num(sys::LV_STYLE_MAX_WIDTH as u8, value)
+    }
+
+    /// Maximum height
+    pub const fn max_height(value: i32) -> Self {
+        Self::num(sys::LV_STYLE_MAX_HEIGHT as u8, value)
+    }
+
+    // ========================================================================
+    // Appearance
+    // ========================================================================
+
+    /// Radius (corner rounding)
+    pub const fn radius(value: i32) -> Self {
+        Self::num(sys::LV_STYLE_RADIUS as u8, value)
+    }
+
+    /// Opacity
+    pub const fn opa(opa: u8) -> Self {
+        Self::num(sys::LV_STYLE_OPA as u8, opa as i32)
+    }
+
+    // ========================================================================
+    // Text
+    // ========================================================================
+
+    /// Text color
+    pub const fn text_color(color: Color) -> Self {
+        Self::color(sys::LV_STYLE_TEXT_COLOR as u8, color)
+    }
+
+    /// Text opacity
+    pub const fn text_opa(opa: u8) -> Self {
+        Self::num(sys::LV_STYLE_TEXT_OPA as u8, opa as i32)
+    }
+
+    /// Text letter spacing
+    pub const fn text_letter_space(value: i32) -> Self {
+        Self::num(sys::LV_STYLE_TEXT_LETTER_SPACE as u8, value)
+    }
+
+    /// Text line spacing
+    pub const fn text_line_space(value: i32) -> Self {
+        Self::num(sys::LV_STYLE_TEXT_LINE_SPACE as u8, value)
+    }
+
+    /// Text alignment
+    pub const fn text_align(align: TextAlign) -> Self {
+        Self::num(sys::LV_STYLE_TEXT_ALIGN as u8, align as i32)
+    }
+
+    // ========================================================================
+    // Shadow
+    // ========================================================================
+
+    /// Shadow color
+    pub const fn shadow_color(color: Color) -> Self {
+        Self::color(sys::LV_STYLE_SHADOW_COLOR as u8, color)
+    }
+
+    /// Shadow width
+    pub const fn shadow_width(value: i32) -> Self {
+        Self::num(sys::LV_STYLE_SHADOW_WIDTH as u8, value)
+    }
+
+    /// Shadow offset X
+    pub const fn shadow_offset_x(value: i32) -> Self {
+        Self::num(sys::LV_STYLE_SHADOW_OFFSET_X as u8, value)
+    }
+
+    /// Shadow offset Y
+    pub const fn shadow_offset_y(value: i32) -> Self {
+        Self::num(sys::LV_STYLE_SHADOW_OFFSET_Y as u8, value)
+    }
+
+    /// Shadow spread
+    pub const fn shadow_spread(value: i32) -> Self {
+        Self::num(sys::LV_STYLE_SHADOW_SPREAD as u8, value)
+    }
+
+    /// Shadow opacity
+    pub const fn shadow_opa(opa: u8) -> Self {
+        Self::num(sys::LV_STYLE_SHADOW_OPA as u8, opa as i32)
+    }
+}
+
+/// Style built at compile time from a property table
+///
+/// Usually made with [`const_style!`]. The table must end with
+/// [`StyleProp::END`]. LVGL never writes to a constant style, so it can live
+/// in a `static` in flash and be shared by any number of objects.
+#[repr(transparent)]
+pub struct ConstStyle(sys::lv_style_t);
+
+// Never written after construction
+unsafe impl Sync for ConstStyle {}
+
+impl ConstStyle {
+    /// Wrap a [`StyleProp::END`]-terminated property table
+    pub const fn new(props: &'static [StyleProp]) -> Self {
+        assert!(
+            !props.is_empty() && props[props.len() - 1].0.prop == sys::LV_STYLE_PROP_INV as u8,
+            "style property table must end with StyleProp::END"
+        );
+        // Same as LV_STYLE_CONST_INIT
+        Self(sys::lv_style_t {
+            values_and_props: props.as_ptr() as *mut c_void,
+            has_group: 0xFFFF_FFFF,
+            prop_cnt: 255,
+        })
+    }
+
+    /// Get raw style pointer
+    pub const fn raw(&self) -> *const sys::lv_style_t {
+        &self.0
+    }
+}
+
+/// Build a [`ConstStyle`] from [`StyleProp`] constructors
+///
+/// ```ignore
+/// static BUTTON: ConstStyle = const_style![bg_color(Color::hex(0x0f3460)), radius(6)];
+/// ```
+#[macro_export]
+macro_rules! const_style {
+    ($($prop:ident($($arg:expr),* $(,)?)),* $(,)?) => {{
+        const PROPS: &[$crate::style::StyleProp] = &[
+            $($crate::style::StyleProp::$prop($($arg),*),)*
+            $crate::style::StyleProp::END,
+        ];
+        $crate::style::ConstStyle::new(PROPS)
+    }};
+}
+
 /// Gradient direction
 #[derive(Clone, Copy, Debug)]
 #[repr(u8)]
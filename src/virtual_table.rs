@@ -0,0 +1,377 @@
+//! Virtualized table for large datasets
+//!
+//! [`VirtualTable`] only creates LVGL objects for the rows in view plus a
+//! few rows of overscan, and pulls their text from a [`TableSource`] when a
+//! row scrolls into view. Row objects are recycled while scrolling, so
+//! creation time and memory depend on the viewport height, not on the
+//! number of rows. A list is a table with one column.
+//!
+//! Rows are plain objects with one label per column rather than an
+//! `lv_table` or `lv_list`: a table stores the text of every cell and
+//! measures every row on each change, and list buttons can't be moved to an
+//! arbitrary offset, so neither can recycle rows as they scroll.
+//!
+//! ```ignore
+//! struct Log(Vec<LogEntry>);
+//!
+//! impl TableSource for Log {
+//!     fn row_count(&self) -> usize {
+//!         self.0.len()
+//!     }
+//!     fn column_count(&self) -> usize {
+//!         2
+//!     }
+//!     fn write_cell(&self, row: usize, col: usize, out: &mut dyn Write) -> fmt::Result {
+//!         match col {
+//!             0 => write!(out, "{}", self.0[row].time),
+//!             _ => out.write_str(&self.0[row].message),
+//!         }
+//!     }
+//! }
+//!
+//! let table = VirtualTable::create(&screen, Log(entries), 24, &[60, 240])?;
+//! ```
+
+use crate::event::{self, EventInfo};
+use crate::obj::LvglObj;
+use crate::widgets::TruncatingWriter;
+use crate::{LvglError, Result};
+use alloc::rc::Rc;
+use alloc::vec::Vec;
+use core::cell::{Cell, UnsafeCell};
+use core::fmt;
+use core::marker::PhantomData;
+use core::ops::Range;
+use lvgl_sys as sys;
+
+/// Longest cell text, in bytes; longer text is truncated
+pub const CELL_TEXT_LEN: usize = 63;
+
+/// Rows materialized above and below the viewport by default
+const DEFAULT_OVERSCAN: usize = 2;
+
+/// Row marker for a pooled row that shows no data
+const UNBOUND: usize = usize::MAX;
+
+/// Largest LVGL coordinate (`LV_COORD_MAX`, not exported by bindgen)
+const MAX_COORD: i64 = (1 << 29) - 1;
+
+/// Supplies rows to a [`VirtualTable`] on demand
+pub trait TableSource {
+    /// Number of rows
+    fn row_count(&self) -> usize;
+
+    /// Number of columns (1 for a list)
+    fn column_count(&self) -> usize {
+        1
+    }
+
+    /// Write the text of one cell
+    fn write_cell(&self, row: usize, column: usize, out: &mut dyn fmt::Write) -> fmt::Result;
+}
+
+/// Recycled row object with one label per column
+struct RowSlot {
+    obj: *mut sys::lv_obj_t,
+    cells: Vec<*mut sys::lv_obj_t>,
+    /// Data row currently shown, or [`UNBOUND`]
+    row: usize,
+}
+
+struct State<S> {
+    viewport: *mut sys::lv_obj_t,
+    spacer: *mut sys::lv_obj_t,
+    slots: Vec<RowSlot>,
+    source: S,
+    row_height: i32,
+    column_widths: Vec<i32>,
+    overscan: usize,
+    visible: Range<usize>,
+}
+
+/// Table state shared by the handle and the viewport's event callbacks
+struct Shared<S> {
+    state: UnsafeCell<State<S>>,
+    /// Cleared when the viewport is deleted; the row objects are gone then
+    alive: Cell<bool>,
+    /// Set while a `&mut State` exists
+    busy: Cell<bool>,
+    /// An event wanted a sync while the state was busy
+    missed: Cell<bool>,
+}
+
+impl<S: TableSource> Shared<S> {
+    /// Run `f` on the state if the viewport still exists
+    ///
+    /// LVGL calls made by `f` can fire the viewport's events right away;
+    /// those find the state busy and the sync they asked for runs once `f`
+    /// returns, so there is never a second `&mut State`.
+    fn with_state<R>(&self, f: impl FnOnce(&mut State<S>) -> R) -> Option<R> {
+        if self.busy.get() {
+            self.missed.set(true);
+            return None;
+        }
+        if !self.alive.get() {
+            return None;
+        }
+        self.busy.set(true);
+        // Only the LVGL thread touches the state, and busy rules out a
+        // second borrow
+        let state = unsafe { &mut *self.state.get() };
+        let result = f(state);
+        while self.missed.replace(false) && self.alive.get() {
+            unsafe { state.sync() };
+        }
+        self.busy.set(false);
+        Some(result)
+    }
+}
+
+/// Marks the table dead when the viewport's callbacks are freed
+struct Liveness<S>(Rc<Shared<S>>);
+
+impl<S> Drop for Liveness<S> {
+    fn drop(&mut self) {
+        self.0.alive.set(false);
+    }
+}
+
+/// Scrollable table that materializes only its visible rows
+///
+/// The handle keeps the data source. Once the table (or its screen) is
+/// deleted, methods that touch LVGL objects do nothing.
+pub struct VirtualTable<S: TableSource> {
+    viewport: *mut sys::lv_obj_t,
+    shared: Rc<Shared<S>>,
+    _marker: PhantomData<*mut ()>,
+}
+
+impl<S: TableSource + 'static> VirtualTable<S> {
+    /// Create a table on `parent` with fixed-height rows
+    ///
+    /// `column_widths` gives each column's width in pixels. Size the table
+    /// with [`LvglObj::set_size`] as usual; rows are added as it grows.
+    pub fn create(
+        parent: &impl LvglObj,
+        source: S,
+        row_height: i32,
+        column_widths: &[i32],
+    ) -> Result<Self> {
+        if row_height <= 0 || column_widths.is_empty() {
+            return Err(LvglError::InvalidParameter);
+        }
+        unsafe {
+            let viewport = sys::lv_obj_create(parent.raw());
+            if viewport.is_null() {
+                return Err(LvglError::OutOfMemory);
+            }
+            sys::lv_obj_set_scroll_dir(viewport, sys::LV_DIR_VER as _);
+
+            // Gives the viewport the full data height to scroll over
+            let spacer = sys::lv_obj_create(viewport);
+            if spacer.is_null() {
+                sys::lv_obj_delete(viewport);
+                return Err(LvglError::OutOfMemory);
+            }
+            sys::lv_obj_remove_style_all(spacer);
+            sys::lv_obj_remove_flag(spacer, sys::LV_OBJ_FLAG_CLICKABLE);
+
+            let shared = Rc::new(Shared {
+                state: UnsafeCell::new(State {
+                    viewport,
+                    spacer,
+                    slots: Vec::new(),
+                    source,
+                    row_height,
+                    column_widths: column_widths.to_vec(),
+                    overscan: DEFAULT_OVERSCAN,
+                    visible: 0..0,
+                }),
+                alive: Cell::new(true),
+                busy: Cell::new(false),
+                missed: Cell::new(false),
+            });
+
+            let liveness = Liveness(shared.clone());
+            event::add_closure(viewport, sys::LV_EVENT_SCROLL, move |_: &EventInfo| {
+                liveness.0.with_state(|state| state.sync());
+            });
+            let resized = shared.clone();
+            event::add_closure(viewport, sys::LV_EVENT_SIZE_CHANGED, move |_: &EventInfo| {
+                resized.with_state(|state| state.sync());
+            });
+
+            shared.with_state(|state| {
+                state.resize_spacer();
+                state.sync();
+            });
+
+            Ok(Self {
+                viewport,
+                shared,
+                _marker: PhantomData,
+            })
+        }
+    }
+
+    /// True until the table is deleted
+    pub fn is_alive(&self) -> bool {
+        self.shared.alive.get()
+    }
+
+    /// Re-read the row count and the text of every materialized row
+    ///
+    /// Call after the data source changed.
+    pub fn refresh(&self) {
+        self.shared.with_state(|state| unsafe {
+            state.resize_spacer();
+            for slot in &mut state.slots {
+                slot.row = UNBOUND;
+            }
+            state.sync();
+        });
+    }
+
+    /// Access the data source; call [`refresh`](Self::refresh) after changing it
+    ///
+    /// Panics if called from inside [`TableSource`] while the table reads it.
+    pub fn with_source<R>(&self, f: impl FnOnce(&mut S) -> R) -> R {
+        assert!(!self.shared.busy.get(), "VirtualTable source is in use");
+        // The source outlives the viewport; rows are only rebound by sync()
+        unsafe { f(&mut (*self.shared.state.get()).source) }
+    }
+
+    /// Scroll so `row` is at the top
+    pub fn scroll_to_row(&self, row: usize, anim: bool) {
+        let Some(row_height) = self.shared.with_state(|state| state.row_height) else {
+            return;
+        };
+        let y = (row as i64 * row_height as i64).min(i32::MAX as i64);
+        let anim = if anim { sys::LV_ANIM_ON } else { sys::LV_ANIM_OFF };
+        // Outside the borrow: the scroll event syncs the rows itself
+        unsafe { sys::lv_obj_scroll_to_y(self.viewport, y as i32, anim) }
+    }
+
+    /// Rows kept materialized above and below the viewport
+    pub fn set_overscan(&self, rows: usize) {
+        self.shared.with_state(|state| {
+            state.overscan = rows;
+            unsafe { state.sync() }
+        });
+    }
+
+    /// Data rows currently materialized (empty once deleted)
+    pub fn visible_range(&self) -> Range<usize> {
+        self.shared
+            .with_state(|state| state.visible.clone())
+            .unwrap_or(0..0)
+    }
+}
+
+impl<S: TableSource> LvglObj for VirtualTable<S> {
+    fn raw(&self) -> *mut sys::lv_obj_t {
+        self.viewport
+    }
+}
+
+impl<S: TableSource> State<S> {
+    unsafe fn resize_spacer(&mut self) {
+        let height = self.source.row_count() as i64 * self.row_height as i64;
+        sys::lv_obj_set_size(self.spacer, 1, height.min(MAX_COORD) as i32);
+    }
+
+    /// Bind pooled rows to the rows in view
+    unsafe fn sync(&mut self) {
+        let rows = self.source.row_count();
+        let scroll_y = sys::lv_obj_get_scroll_y(self.viewport).max(0);
+        let view_height = sys::lv_obj_get_content_height(self.viewport).max(self.row_height);
+
+        let first = (scroll_y / self.row_height) as usize;
+        let in_view = (view_height / self.row_height) as usize + 2;
+        let start = first.saturating_sub(self.overscan).min(rows);
+        let end = (first + in_view + self.overscan).min(rows);
+
+        let needed = in_view + 2 * self.overscan;
+        while self.slots.len() < needed {
+            match self.create_slot() {
+                Some(slot) => self.slots.push(slot),
+                None => break,
+            }
+        }
+        let pool = self.slots.len();
+        if pool == 0 {
+            return;
+        }
+        // A slot serves every row with the same index modulo the pool size
+        let end = end.min(start + pool);
+
+        for row in start..end {
+            let slot = row % pool;
+            if self.slots[slot].row != row {
+                self.bind(slot, row);
+            }
+        }
+        for slot in &mut self.slots {
+            if slot.row != UNBOUND && !(start..end).contains(&slot.row) {
+                slot.row = UNBOUND;
+                sys::lv_obj_add_flag(slot.obj, sys::LV_OBJ_FLAG_HIDDEN);
+            }
+        }
+        self.visible = start..end;
+    }
+
+    unsafe fn create_slot(&self) -> Option<RowSlot> {
+        let obj = sys::lv_obj_create(self.viewport);
+        if obj.is_null() {
+            return None;
+        }
+        sys::lv_obj_remove_style_all(obj);
+        sys::lv_obj_remove_flag(obj, sys::LV_OBJ_FLAG_SCROLLABLE);
+        sys::lv_obj_remove_flag(obj, sys::LV_OBJ_FLAG_CLICKABLE);
+        sys::lv_obj_add_flag(obj, sys::LV_OBJ_FLAG_HIDDEN);
+
+        let columns = self.source.column_count().min(self.column_widths.len()).max(1);
+        let width = self.column_widths[..columns].iter().sum();
+        sys::lv_obj_set_size(obj, width, self.row_height);
+        let mut cells = Vec::with_capacity(columns);
+        let mut x = 0;
+        for &width in &self.column_widths[..columns] {
+            let label = sys::lv_label_create(obj);
+            if label.is_null() {
+                sys::lv_obj_delete(obj);
+                return None;
+            }
+            sys::lv_label_set_long_mode(label, sys::LV_LABEL_LONG_DOT as _);
+            sys::lv_obj_set_width(label, width);
+            sys::lv_obj_align(label, sys::LV_ALIGN_LEFT_MID as _, x, 0);
+            x += width;
+            cells.push(label);
+        }
+
+        Some(RowSlot {
+            obj,
+            cells,
+            row: UNBOUND,
+        })
+    }
+
+    /// Show data row `row` in pooled slot `slot`
+    unsafe fn bind(&mut self, slot: usize, row: usize) {
+        let mut text = [0u8; CELL_TEXT_LEN + 1];
+        let slot = &mut self.slots[slot];
+        for (column, &label) in slot.cells.iter().enumerate() {
+            let mut writer = TruncatingWriter {
+                buf: &mut text[..CELL_TEXT_LEN],
+                len: 0,
+            };
+            let _ = self.source.write_cell(row, column, &mut writer);
+            let len = writer.len;
+            text[len] = 0;
+            sys::lv_label_set_text(label, text.as_ptr() as *const _);
+        }
+        let y = (row as i64 * self.row_height as i64).min(MAX_COORD) as i32;
+        sys::lv_obj_set_pos(slot.obj, 0, y);
+        sys::lv_obj_remove_flag(slot.obj, sys::LV_OBJ_FLAG_HIDDEN);
+        slot.row = row;
+    }
+}
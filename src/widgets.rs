@@ -1,6 +1,10 @@
 //! LVGL Widget Wrappers
 //!
-//! Safe wrappers for commonly used LVGL widgets.
+//! Safe wrappers for commonly used LVGL widgets. Each one is compiled with
+//! its `widget-*` cargo feature, along with the LVGL widget it wraps.
+
+// With only some widgets enabled not every import is used
+#![cfg_attr(not(feature = "all-widgets"), allow(unused_imports))]
 
 use crate::obj::{LvglObj, Obj};
 use crate::{Color, LvglError, Result};
@@ -13,11 +17,13 @@ use lvgl_sys as sys;
 // ============================================================================
 
 /// Label widget for displaying text
+#[cfg(feature = "widget-label")]
 pub struct Label {
     raw: *mut sys::lv_obj_t,
     _marker: PhantomData<*mut ()>,
 }
 
+#[cfg(feature = "widget-label")]
 impl Label {
     /// Create a new label on the given parent
     pub fn create(parent: &impl LvglObj) -> Result<Self> {
@@ -63,6 +69,7 @@ impl Label {
     }
 }
 
+#[cfg(feature = "widget-label")]
 impl LvglObj for Label {
     fn raw(&self) -> *mut sys::lv_obj_t {
         self.raw
@@ -70,6 +77,7 @@ impl LvglObj for Label {
 }
 
 /// Label long text mode
+#[cfg(feature = "widget-label")]
 #[derive(Clone, Copy, Debug)]
 #[repr(u8)]
 pub enum LabelLongMode {
@@ -80,16 +88,235 @@ pub enum LabelLongMode {
     Clip = sys::LV_LABEL_LONG_CLIP as u8,
 }
 
+/// Label with its own text buffer, for frequently updated numbers
+///
+/// Values are formatted into an `N`-byte buffer (including the NUL) that is
+/// allocated once and shown with `lv_label_set_text_static`, so updates
+/// neither allocate nor make LVGL copy the text. LVGL is only called, and
+/// the label only invalidated, when the rendered text actually changed.
+/// Longer text is truncated on a char boundary.
+///
+/// The buffer lives until the label is deleted, even if this handle is
+/// dropped first; updates after the label was deleted do nothing.
+///
+/// ```ignore
+/// let mut temp = FormattedLabel::<16>::create(&screen)?;
+/// temp.set_fixed(2315, 2);                      // "23.15"
+/// temp.set_fmt(format_args!("{} rpm", rpm));
+/// ```
+#[cfg(feature = "widget-label")]
+pub struct FormattedLabel<const N: usize> {
+    label: Label,
+    text: alloc::rc::Rc<LabelText<N>>,
+    len: usize,
+}
+
+/// Text buffer shared by a [`FormattedLabel`] and its label
+#[cfg(feature = "widget-label")]
+struct LabelText<const N: usize> {
+    buf: core::cell::UnsafeCell<[u8; N]>,
+    /// Cleared when the label is deleted
+    alive: core::cell::Cell<bool>,
+}
+
+#[cfg(feature = "widget-label")]
+impl<const N: usize> FormattedLabel<N> {
+    const VALID_SIZE: () = assert!(N >= 2, "buffer must hold at least one byte and the NUL");
+
+    /// Create a new label on the given parent
+    pub fn create(parent: &impl LvglObj) -> Result<Self> {
+        Ok(Self::from_label(Label::create(parent)?))
+    }
+
+    /// Take over an existing label (its current text is replaced on the first update)
+    pub fn from_label(label: Label) -> Self {
+        let () = Self::VALID_SIZE;
+        let text = alloc::rc::Rc::new(LabelText {
+            buf: core::cell::UnsafeCell::new([0; N]),
+            alive: core::cell::Cell::new(true),
+        });
+        // Keeps the buffer alive as long as the label points at it
+        let shown = text.clone();
+        crate::event::add_closure(
+            label.raw,
+            sys::LV_EVENT_DELETE,
+            move |_: &crate::EventInfo| {
+                shown.alive.set(false);
+            },
+        );
+        Self {
+            label,
+            text,
+            len: usize::MAX,
+        }
+    }
+
+    /// The underlying label
+    pub fn label(&self) -> &Label {
+        &self.label
+    }
+
+    /// Current text (without the NUL)
+    pub fn text(&self) -> &str {
+        let len = if self.len == usize::MAX { 0 } else { self.len };
+        // Only whole chars are ever copied into the buffer
+        unsafe { core::str::from_utf8_unchecked(&(*self.text.buf.get())[..len]) }
+    }
+
+    /// Show an integer. Returns true if the text changed.
+    pub fn set_int(&mut self, value: i32) -> bool {
+        let mut digits = [0u8; 11];
+        let text = format_i32(&mut digits, value);
+        self.update(text)
+    }
+
+    /// Show a fixed-point value: `value / 10^decimals`, e.g. `(-5, 2)` is `-0.05`
+    pub fn set_fixed(&mut self, value: i32, decimals: u32) -> bool {
+        let mut text = [0u8; 24];
+        let len = format_fixed(&mut text, value, decimals);
+        self.update(&text[..len])
+    }
+
+    /// Show a string
+    pub fn set_str(&mut self, text: &str) -> bool {
+        self.update(text.as_bytes())
+    }
+
+    /// Show `format_args!(...)` output
+    pub fn set_fmt(&mut self, args: core::fmt::Arguments<'_>) -> bool {
+        let mut scratch = [0u8; N];
+        let mut writer = TruncatingWriter {
+            buf: &mut scratch[..N - 1],
+            len: 0,
+        };
+        let _ = core::fmt::Write::write_fmt(&mut writer, args);
+        let len = writer.len;
+        self.update(&scratch[..len])
+    }
+
+    fn update(&mut self, text: &[u8]) -> bool {
+        if !self.text.alive.get() {
+            return false;
+        }
+        let len = truncated_len(text, N - 1);
+        let text = &text[..len];
+        // LVGL only reads the buffer while drawing, on this thread
+        let buf = unsafe { &mut *self.text.buf.get() };
+        if self.len == len && &buf[..len] == text {
+            return false;
+        }
+        buf[..len].copy_from_slice(text);
+        buf[len] = 0;
+        self.len = len;
+        // Same pointer every time: LVGL just re-measures the text
+        unsafe { sys::lv_label_set_text_static(self.label.raw, buf.as_ptr() as *const _) };
+        true
+    }
+}
+
+#[cfg(feature = "widget-label")]
+impl<const N: usize> LvglObj for FormattedLabel<N> {
+    fn raw(&self) -> *mut sys::lv_obj_t {
+        self.label.raw
+    }
+}
+
+/// `core::fmt` sink that drops whatever doesn't fit
+#[cfg(feature = "widget-label")]
+pub(crate) struct TruncatingWriter<'a> {
+    pub(crate) buf: &'a mut [u8],
+    pub(crate) len: usize,
+}
+
+#[cfg(feature = "widget-label")]
+impl core::fmt::Write for TruncatingWriter<'_> {
+    fn write_str(&mut self, s: &str) -> core::fmt::Result {
+        let take = truncated_len(s.as_bytes(), self.buf.len() - self.len);
+        self.buf[self.len..self.len + take].copy_from_slice(&s.as_bytes()[..take]);
+        self.len += take;
+        Ok(())
+    }
+}
+
+/// Longest prefix of UTF-8 `text` of at most `max` bytes ending on a char boundary
+#[cfg(feature = "widget-label")]
+fn truncated_len(text: &[u8], max: usize) -> usize {
+    if text.len() <= max {
+        return text.len();
+    }
+    let mut len = max;
+    // Back off continuation bytes (0b10xx_xxxx)
+    while len > 0 && text[len] & 0xC0 == 0x80 {
+        len -= 1;
+    }
+    len
+}
+
+/// Decimal digits of `n` at the end of `buf`
+#[cfg(feature = "widget-label")]
+fn format_u32(buf: &mut [u8; 11], mut n: u32) -> &[u8] {
+    let mut pos = buf.len();
+    loop {
+        pos -= 1;
+        buf[pos] = b'0' + (n % 10) as u8;
+        n /= 10;
+        if n == 0 {
+            break;
+        }
+    }
+    &buf[pos..]
+}
+
+/// Decimal text of `value` at the end of `buf`
+#[cfg(feature = "widget-label")]
+fn format_i32(buf: &mut [u8; 11], value: i32) -> &[u8] {
+    let pos = buf.len() - format_u32(buf, value.unsigned_abs()).len();
+    if value < 0 {
+        buf[pos - 1] = b'-';
+        &buf[pos - 1..]
+    } else {
+        &buf[pos..]
+    }
+}
+
+/// Write `value / 10^decimals` into `out`, returning the length
+#[cfg(feature = "widget-label")]
+fn format_fixed(out: &mut [u8; 24], value: i32, decimals: u32) -> usize {
+    let decimals = decimals.min(10) as usize;
+    let mut digits = [0u8; 11];
+    let abs = format_u32(&mut digits, value.unsigned_abs());
+    // Pad so there is at least one digit before the point
+    let pad = (decimals + 1).saturating_sub(abs.len());
+
+    let mut len = 0;
+    if value < 0 {
+        out[len] = b'-';
+        len += 1;
+    }
+    let int_digits = abs.len() + pad - decimals;
+    for i in 0..abs.len() + pad {
+        if i == int_digits {
+            out[len] = b'.';
+            len += 1;
+        }
+        out[len] = if i < pad { b'0' } else { abs[i - pad] };
+        len += 1;
+    }
+    len
+}
+
 // ============================================================================
 // Button
 // ============================================================================
 
 /// Button widget
+#[cfg(feature = "widget-button")]
 pub struct Button {
     raw: *mut sys::lv_obj_t,
     _marker: PhantomData<*mut ()>,
 }
 
+#[cfg(feature = "widget-button")]
 impl Button {
     /// Create a new button on the given parent
     pub fn create(parent: &impl LvglObj) -> Result<Self> {
@@ -107,6 +334,7 @@ impl Button {
     }
 
     /// Create a button with a label
+    #[cfg(feature = "widget-label")]
     pub fn create_with_label(parent: &impl LvglObj, text: &CStr) -> Result<Self> {
         let btn = Self::create(parent)?;
         let label = Label::create(&btn)?;
@@ -116,6 +344,7 @@ impl Button {
     }
 }
 
+#[cfg(feature = "widget-button")]
 impl LvglObj for Button {
     fn raw(&self) -> *mut sys::lv_obj_t {
         self.raw
@@ -127,11 +356,13 @@ impl LvglObj for Button {
 // ============================================================================
 
 /// Slider widget for selecting a value from a range
+#[cfg(feature = "widget-slider")]
 pub struct Slider {
     raw: *mut sys::lv_obj_t,
     _marker: PhantomData<*mut ()>,
 }
 
+#[cfg(feature = "widget-slider")]
 impl Slider {
     /// Create a new slider on the given parent
     pub fn create(parent: &impl LvglObj) -> Result<Self> {
@@ -169,6 +400,7 @@ impl Slider {
     }
 }
 
+#[cfg(feature = "widget-slider")]
 impl LvglObj for Slider {
     fn raw(&self) -> *mut sys::lv_obj_t {
         self.raw
@@ -180,11 +412,13 @@ impl LvglObj for Slider {
 // ============================================================================
 
 /// On/Off switch widget
+#[cfg(feature = "widget-switch")]
 pub struct Switch {
     raw: *mut sys::lv_obj_t,
     _marker: PhantomData<*mut ()>,
 }
 
+#[cfg(feature = "widget-switch")]
 impl Switch {
     /// Create a new switch on the given parent
     pub fn create(parent: &impl LvglObj) -> Result<Self> {
@@ -216,6 +450,7 @@ impl Switch {
     }
 }
 
+#[cfg(feature = "widget-switch")]
 impl LvglObj for Switch {
     fn raw(&self) -> *mut sys::lv_obj_t {
         self.raw
@@ -227,11 +462,13 @@ impl LvglObj for Switch {
 // ============================================================================
 
 /// Checkbox widget
+#[cfg(feature = "widget-checkbox")]
 pub struct Checkbox {
     raw: *mut sys::lv_obj_t,
     _marker: PhantomData<*mut ()>,
 }
 
+#[cfg(feature = "widget-checkbox")]
 impl Checkbox {
     /// Create a new checkbox on the given parent
     pub fn create(parent: &impl LvglObj) -> Result<Self> {
@@ -268,6 +505,7 @@ impl Checkbox {
     }
 }
 
+#[cfg(feature = "widget-checkbox")]
 impl LvglObj for Checkbox {
     fn raw(&self) -> *mut sys::lv_obj_t {
         self.raw
@@ -279,11 +517,13 @@ impl LvglObj for Checkbox {
 // ============================================================================
 
 /// Progress bar widget
+#[cfg(feature = "widget-bar")]
 pub struct Bar {
     raw: *mut sys::lv_obj_t,
     _marker: PhantomData<*mut ()>,
 }
 
+#[cfg(feature = "widget-bar")]
 impl Bar {
     /// Create a new bar on the given parent
     pub fn create(parent: &impl LvglObj) -> Result<Self> {
@@ -321,6 +561,7 @@ impl Bar {
     }
 }
 
+#[cfg(feature = "widget-bar")]
 impl LvglObj for Bar {
     fn raw(&self) -> *mut sys::lv_obj_t {
         self.raw
@@ -332,11 +573,13 @@ impl LvglObj for Bar {
 // ============================================================================
 
 /// Arc/Gauge widget
+#[cfg(feature = "widget-arc")]
 pub struct Arc {
     raw: *mut sys::lv_obj_t,
     _marker: PhantomData<*mut ()>,
 }
 
+#[cfg(feature = "widget-arc")]
 impl Arc {
     /// Create a new arc on the given parent
     pub fn create(parent: &impl LvglObj) -> Result<Self> {
@@ -384,6 +627,7 @@ impl Arc {
     }
 }
 
+#[cfg(feature = "widget-arc")]
 impl LvglObj for Arc {
     fn raw(&self) -> *mut sys::lv_obj_t {
         self.raw
@@ -391,6 +635,7 @@ impl LvglObj for Arc {
 }
 
 /// Arc display mode
+#[cfg(feature = "widget-arc")]
 #[derive(Clone, Copy, Debug)]
 #[repr(u8)]
 pub enum ArcMode {
@@ -404,11 +649,13 @@ pub enum ArcMode {
 // ============================================================================
 
 /// Loading spinner widget
+#[cfg(feature = "widget-spinner")]
 pub struct Spinner {
     raw: *mut sys::lv_obj_t,
     _marker: PhantomData<*mut ()>,
 }
 
+#[cfg(feature = "widget-spinner")]
 impl Spinner {
     /// Create a new spinner on the given parent
     pub fn create(parent: &impl LvglObj) -> Result<Self> {
@@ -431,6 +678,7 @@ impl Spinner {
     }
 }
 
+#[cfg(feature = "widget-spinner")]
 impl LvglObj for Spinner {
     fn raw(&self) -> *mut sys::lv_obj_t {
         self.raw
@@ -442,11 +690,13 @@ impl LvglObj for Spinner {
 // ============================================================================
 
 /// Dropdown (combo box) widget
+#[cfg(feature = "widget-dropdown")]
 pub struct Dropdown {
     raw: *mut sys::lv_obj_t,
     _marker: PhantomData<*mut ()>,
 }
 
+#[cfg(feature = "widget-dropdown")]
 impl Dropdown {
     /// Create a new dropdown on the given parent
     pub fn create(parent: &impl LvglObj) -> Result<Self> {
@@ -529,6 +779,7 @@ impl Dropdown {
     }
 }
 
+#[cfg(feature = "widget-dropdown")]
 impl LvglObj for Dropdown {
     fn raw(&self) -> *mut sys::lv_obj_t {
         self.raw
@@ -555,11 +806,13 @@ impl Dir {
 // ============================================================================
 
 /// Text area widget for text input
+#[cfg(feature = "widget-textarea")]
 pub struct Textarea {
     raw: *mut sys::lv_obj_t,
     _marker: PhantomData<*mut ()>,
 }
 
+#[cfg(feature = "widget-textarea")]
 impl Textarea {
     /// Create a new textarea on the given parent
     pub fn create(parent: &impl LvglObj) -> Result<Self> {
@@ -690,6 +943,7 @@ impl Textarea {
     }
 }
 
+#[cfg(feature = "widget-textarea")]
 impl LvglObj for Textarea {
     fn raw(&self) -> *mut sys::lv_obj_t {
         self.raw
@@ -701,11 +955,13 @@ impl LvglObj for Textarea {
 // ============================================================================
 
 /// Roller (scroll wheel selector) widget
+#[cfg(feature = "widget-roller")]
 pub struct Roller {
     raw: *mut sys::lv_obj_t,
     _marker: PhantomData<*mut ()>,
 }
 
+#[cfg(feature = "widget-roller")]
 impl Roller {
     /// Create a new roller on the given parent
     pub fn create(parent: &impl LvglObj) -> Result<Self> {
@@ -753,6 +1009,7 @@ impl Roller {
     }
 }
 
+#[cfg(feature = "widget-roller")]
 impl LvglObj for Roller {
     fn raw(&self) -> *mut sys::lv_obj_t {
         self.raw
@@ -760,6 +1017,7 @@ impl LvglObj for Roller {
 }
 
 /// Roller mode
+#[cfg(feature = "widget-roller")]
 #[derive(Clone, Copy, Debug)]
 #[repr(u8)]
 pub enum RollerMode {
@@ -772,11 +1030,13 @@ pub enum RollerMode {
 // ============================================================================
 
 /// LED indicator widget
+#[cfg(feature = "widget-led")]
 pub struct Led {
     raw: *mut sys::lv_obj_t,
     _marker: PhantomData<*mut ()>,
 }
 
+#[cfg(feature = "widget-led")]
 impl Led {
     /// Create a new LED on the given parent
     pub fn create(parent: &impl LvglObj) -> Result<Self> {
@@ -824,6 +1084,7 @@ impl Led {
     }
 }
 
+#[cfg(feature = "widget-led")]
 impl LvglObj for Led {
     fn raw(&self) -> *mut sys::lv_obj_t {
         self.raw
@@ -835,11 +1096,13 @@ impl LvglObj for Led {
 // ============================================================================
 
 /// Line drawing widget
+#[cfg(feature = "widget-line")]
 pub struct Line {
     raw: *mut sys::lv_obj_t,
     _marker: PhantomData<*mut ()>,
 }
 
+#[cfg(feature = "widget-line")]
 impl Line {
     /// Create a new line on the given parent
     pub fn create(parent: &impl LvglObj) -> Result<Self> {
@@ -880,6 +1143,7 @@ impl Line {
     }
 }
 
+#[cfg(feature = "widget-line")]
 impl LvglObj for Line {
     fn raw(&self) -> *mut sys::lv_obj_t {
         self.raw
@@ -891,11 +1155,13 @@ impl LvglObj for Line {
 // ============================================================================
 
 /// Image widget
+#[cfg(feature = "widget-image")]
 pub struct Image {
     raw: *mut sys::lv_obj_t,
     _marker: PhantomData<*mut ()>,
 }
 
+#[cfg(feature = "widget-image")]
 impl Image {
     /// Create a new image on the given parent
     pub fn create(parent: &impl LvglObj) -> Result<Self> {
@@ -917,7 +1183,18 @@ impl Image {
     /// # Safety
     /// The source must remain valid for the lifetime of the image object.
     pub unsafe fn set_src(&self, src: *const core::ffi::c_void) {
-        sys::lv_image_set_src(self.raw, src)
+        // The header cache entry outlives a screen built in an arena
+        crate::mem::outside_arena(|| sys::lv_image_set_src(self.raw, src))
+    }
+
+    /// Show an image linked into the binary
+    pub fn set_image(&self, image: &'static crate::image::ImageDsc) {
+        unsafe { self.set_src(image.raw_src()) }
+    }
+
+    /// Show an image file (`"S:/path/img.png"`); LVGL copies the path
+    pub fn set_path(&self, path: &core::ffi::CStr) {
+        unsafe { self.set_src(path.as_ptr() as *const core::ffi::c_void) }
     }
 
     /// Set rotation in 0.1 degree units (e.g. 900 = 90 degrees)
@@ -976,6 +1253,7 @@ impl Image {
     }
 }
 
+#[cfg(feature = "widget-image")]
 impl LvglObj for Image {
     fn raw(&self) -> *mut sys::lv_obj_t {
         self.raw
@@ -983,6 +1261,7 @@ impl LvglObj for Image {
 }
 
 /// Image inner alignment
+#[cfg(feature = "widget-image")]
 #[derive(Clone, Copy, Debug)]
 #[repr(u8)]
 pub enum ImageAlign {
@@ -1005,11 +1284,13 @@ pub enum ImageAlign {
 // ============================================================================
 
 /// Numeric spinbox widget
+#[cfg(feature = "widget-spinbox")]
 pub struct Spinbox {
     raw: *mut sys::lv_obj_t,
     _marker: PhantomData<*mut ()>,
 }
 
+#[cfg(feature = "widget-spinbox")]
 impl Spinbox {
     /// Create a new spinbox on the given parent
     pub fn create(parent: &impl LvglObj) -> Result<Self> {
@@ -1077,6 +1358,7 @@ impl Spinbox {
     }
 }
 
+#[cfg(feature = "widget-spinbox")]
 impl LvglObj for Spinbox {
     fn raw(&self) -> *mut sys::lv_obj_t {
         self.raw
@@ -1088,11 +1370,13 @@ impl LvglObj for Spinbox {
 // ============================================================================
 
 /// Scale (ruler/gauge marks) widget
+#[cfg(feature = "widget-scale")]
 pub struct Scale {
     raw: *mut sys::lv_obj_t,
     _marker: PhantomData<*mut ()>,
 }
 
+#[cfg(feature = "widget-scale")]
 impl Scale {
     /// Create a new scale on the given parent
     pub fn create(parent: &impl LvglObj) -> Result<Self> {
@@ -1150,6 +1434,7 @@ impl Scale {
     }
 }
 
+#[cfg(feature = "widget-scale")]
 impl LvglObj for Scale {
     fn raw(&self) -> *mut sys::lv_obj_t {
         self.raw
@@ -1157,6 +1442,7 @@ impl LvglObj for Scale {
 }
 
 /// Scale mode
+#[cfg(feature = "widget-scale")]
 #[derive(Clone, Copy, Debug)]
 #[repr(u8)]
 pub enum ScaleMode {
@@ -1173,11 +1459,13 @@ pub enum ScaleMode {
 // ============================================================================
 
 /// Button matrix widget
+#[cfg(feature = "widget-buttonmatrix")]
 pub struct Buttonmatrix {
     raw: *mut sys::lv_obj_t,
     _marker: PhantomData<*mut ()>,
 }
 
+#[cfg(feature = "widget-buttonmatrix")]
 impl Buttonmatrix {
     /// Create a new button matrix on the given parent
     pub fn create(parent: &impl LvglObj) -> Result<Self> {
@@ -1257,6 +1545,7 @@ impl Buttonmatrix {
     }
 }
 
+#[cfg(feature = "widget-buttonmatrix")]
 impl LvglObj for Buttonmatrix {
     fn raw(&self) -> *mut sys::lv_obj_t {
         self.raw
@@ -1268,11 +1557,13 @@ impl LvglObj for Buttonmatrix {
 // ============================================================================
 
 /// Table widget
+#[cfg(feature = "widget-table")]
 pub struct Table {
     raw: *mut sys::lv_obj_t,
     _marker: PhantomData<*mut ()>,
 }
 
+#[cfg(feature = "widget-table")]
 impl Table {
     /// Create a new table on the given parent
     pub fn create(parent: &impl LvglObj) -> Result<Self> {
@@ -1343,6 +1634,7 @@ impl Table {
     }
 }
 
+#[cfg(feature = "widget-table")]
 impl LvglObj for Table {
     fn raw(&self) -> *mut sys::lv_obj_t {
         self.raw
@@ -1354,16 +1646,19 @@ impl LvglObj for Table {
 // ============================================================================
 
 /// Chart widget for data visualization
+#[cfg(feature = "widget-chart")]
 pub struct Chart {
     raw: *mut sys::lv_obj_t,
     _marker: PhantomData<*mut ()>,
 }
 
 /// Opaque wrapper for a chart data series
+#[cfg(feature = "widget-chart")]
 pub struct ChartSeries {
-    raw: *mut sys::lv_chart_series_t,
+    pub(crate) raw: *mut sys::lv_chart_series_t,
 }
 
+#[cfg(feature = "widget-chart")]
 impl Chart {
     /// Create a new chart on the given parent
     pub fn create(parent: &impl LvglObj) -> Result<Self> {
@@ -1452,8 +1747,47 @@ impl Chart {
     pub fn get_pressed_point(&self) -> u32 {
         unsafe { sys::lv_chart_get_pressed_point(self.raw) }
     }
-}
 
+    /// Let `series` read its Y values straight from `buf`
+    ///
+    /// Sets the chart's update mode and its point count to `buf.len()`. All
+    /// series of a chart share the point count, so rings attached to the
+    /// same chart must be the same length.
+    pub fn attach_ring(
+        &self,
+        series: &ChartSeries,
+        buf: &'static mut [i32],
+        mode: ChartUpdateMode,
+    ) -> Result<ChartRing> {
+        let len = u32::try_from(buf.len()).map_err(|_| LvglError::InvalidParameter)?;
+        if len == 0 {
+            return Err(LvglError::InvalidParameter);
+        }
+        unsafe {
+            sys::lv_chart_set_update_mode(self.raw, mode as u32);
+            sys::lv_chart_set_point_count(self.raw, len);
+            sys::lv_chart_set_ext_y_array(self.raw, series.raw, buf.as_mut_ptr());
+            sys::lv_chart_set_x_start_point(self.raw, series.raw, 0);
+        }
+        let alive = alloc::rc::Rc::new(core::cell::Cell::new(true));
+        let flag = alive.clone();
+        crate::event::add_closure(self.raw, sys::LV_EVENT_DELETE, move |_: &crate::EventInfo| {
+            flag.set(false);
+        });
+        Ok(ChartRing {
+            chart: self.raw,
+            series: series.raw,
+            buf: buf.as_mut_ptr(),
+            len: buf.len(),
+            next: 0,
+            mode,
+            margin: DEFAULT_RING_MARGIN,
+            alive,
+        })
+    }
+}
+
+#[cfg(feature = "widget-chart")]
 impl LvglObj for Chart {
     fn raw(&self) -> *mut sys::lv_obj_t {
         self.raw
@@ -1461,6 +1795,7 @@ impl LvglObj for Chart {
 }
 
 /// Chart type
+#[cfg(feature = "widget-chart")]
 #[derive(Clone, Copy, Debug)]
 #[repr(u32)]
 pub enum ChartType {
@@ -1471,6 +1806,7 @@ pub enum ChartType {
 }
 
 /// Chart axis
+#[cfg(feature = "widget-chart")]
 #[derive(Clone, Copy, Debug)]
 #[repr(u32)]
 pub enum ChartAxis {
@@ -1481,6 +1817,7 @@ pub enum ChartAxis {
 }
 
 /// Chart update mode
+#[cfg(feature = "widget-chart")]
 #[derive(Clone, Copy, Debug)]
 #[repr(u8)]
 pub enum ChartUpdateMode {
@@ -1488,16 +1825,363 @@ pub enum ChartUpdateMode {
     Circular = sys::LV_CHART_UPDATE_MODE_CIRCULAR as u8,
 }
 
+/// True if `series` is one of the chart's series (not removed since the
+/// handle was taken)
+#[cfg(feature = "widget-chart")]
+pub(crate) unsafe fn chart_has_series(
+    chart: *mut sys::lv_obj_t,
+    series: *mut sys::lv_chart_series_t,
+) -> bool {
+    let mut next = sys::lv_chart_get_series_next(chart, core::ptr::null());
+    while !next.is_null() {
+        if next == series {
+            return true;
+        }
+        next = sys::lv_chart_get_series_next(chart, next);
+    }
+    false
+}
+
+/// Pixels invalidated beyond the changed columns (line width, point markers)
+#[cfg(feature = "widget-chart")]
+const DEFAULT_RING_MARGIN: i32 = 8;
+
+/// Chart series backed by a caller-owned ring buffer
+///
+/// Created by [`Chart::attach_ring`]. [`push_slice`](Self::push_slice)
+/// copies a whole batch into the ring and invalidates once: the whole chart
+/// in [`ChartUpdateMode::Shift`], where every point moves, and only the
+/// columns that changed in [`ChartUpdateMode::Circular`]. Updates after
+/// the chart was deleted or the series removed do nothing.
+///
+/// ```ignore
+/// static mut SAMPLES: [i32; 512] = [0; 512];
+///
+/// let series = chart.add_series(Color::hex(0x00ff88), ChartAxis::PrimaryY);
+/// let mut scope = chart.attach_ring(&series, unsafe { &mut SAMPLES }, ChartUpdateMode::Circular)?;
+/// scope.push_slice(&adc_capture);
+/// ```
+#[cfg(feature = "widget-chart")]
+pub struct ChartRing {
+    chart: *mut sys::lv_obj_t,
+    series: *mut sys::lv_chart_series_t,
+    buf: *mut i32,
+    len: usize,
+    /// Index the next value is written to
+    next: usize,
+    mode: ChartUpdateMode,
+    margin: i32,
+    /// Cleared when the chart is deleted
+    alive: alloc::rc::Rc<core::cell::Cell<bool>>,
+}
+
+#[cfg(feature = "widget-chart")]
+impl ChartRing {
+    /// Append one value
+    pub fn push(&mut self, value: i32) {
+        self.push_slice(core::slice::from_ref(&value));
+    }
+
+    /// Append `values`, oldest first (only the last `len()` matter)
+    pub fn push_slice(&mut self, values: &[i32]) {
+        if values.is_empty() || !self.is_alive() {
+            return;
+        }
+        let len = self.len;
+        let skip = values.len().saturating_sub(len);
+        let values = &values[skip..];
+        let start = (self.next + skip) % len;
+
+        // The ring is owned by this series since attach_ring()
+        let buf = unsafe { core::slice::from_raw_parts_mut(self.buf, len) };
+        let first = (len - start).min(values.len());
+        buf[start..start + first].copy_from_slice(&values[..first]);
+        buf[..values.len() - first].copy_from_slice(&values[first..]);
+        self.next = (start + values.len()) % len;
+
+        unsafe { sys::lv_chart_set_x_start_point(self.chart, self.series, self.next as u32) };
+        self.invalidate(start, values.len());
+    }
+
+    /// Set every point to `value`
+    pub fn fill(&mut self, value: i32) {
+        if !self.is_alive() {
+            return;
+        }
+        unsafe { core::slice::from_raw_parts_mut(self.buf, self.len) }.fill(value);
+        unsafe { sys::lv_obj_invalidate(self.chart) };
+    }
+
+    /// The ring in storage order (the oldest value is at [`next_index`](Self::next_index))
+    pub fn values(&self) -> &[i32] {
+        unsafe { core::slice::from_raw_parts(self.buf, self.len) }
+    }
+
+    /// Index the next value will be written to
+    pub fn next_index(&self) -> usize {
+        self.next
+    }
+
+    /// Number of points
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    /// Always false: rings have at least one point
+    pub fn is_empty(&self) -> bool {
+        false
+    }
+
+    /// False once the chart was deleted or the series removed from it
+    ///
+    /// Every update is then a no-op; [`values`](Self::values) still reads
+    /// the buffer.
+    pub fn is_alive(&self) -> bool {
+        self.alive.get() && unsafe { chart_has_series(self.chart, self.series) }
+    }
+
+    /// Extra pixels redrawn around changed columns in circular mode
+    ///
+    /// Raise it if the series uses wide lines or large point markers.
+    pub fn set_margin(&mut self, margin: i32) {
+        self.margin = margin;
+    }
+
+    /// True if the two points `offset` past the write position already
+    /// are `min` and `max` and writing them would look the same
+    ///
+    /// Only in circular mode: shifting moves every point.
+    fn shows_column(&self, offset: usize, min: i32, max: i32) -> bool {
+        // Pending points past a full lap would overwrite these
+        if !matches!(self.mode, ChartUpdateMode::Circular)
+            || offset + 2 > self.len
+            || !self.is_alive()
+        {
+            return false;
+        }
+        let values = self.values();
+        let i = (self.next + offset) % self.len;
+        values[i] == min && values[(i + 1) % self.len] == max
+    }
+
+    /// Move the write position by `count` points without redrawing
+    fn advance(&mut self, count: usize) {
+        self.next = (self.next + count) % self.len;
+        unsafe { sys::lv_chart_set_x_start_point(self.chart, self.series, self.next as u32) };
+    }
+
+    /// Redraw after writing `count` points from `start`
+    fn invalidate(&self, start: usize, count: usize) {
+        // Circular mode also moves the gap after the newest point
+        let count = count + 1;
+        if matches!(self.mode, ChartUpdateMode::Shift) || count >= self.len {
+            unsafe { sys::lv_obj_invalidate(self.chart) };
+            return;
+        }
+        let end = start + count - 1;
+        if end < self.len {
+            self.invalidate_columns(start, end);
+        } else {
+            self.invalidate_columns(start, self.len - 1);
+            self.invalidate_columns(0, end - self.len);
+        }
+    }
+
+    /// Invalidate the chart area covering points `first..=last`
+    ///
+    /// Uses the line chart's x positions, which also covers bar columns.
+    fn invalidate_columns(&self, first: usize, last: usize) {
+        unsafe {
+            let mut content = sys::lv_area_t::default();
+            sys::lv_obj_get_content_coords(self.chart, &mut content);
+            let mut coords = sys::lv_area_t::default();
+            sys::lv_obj_get_coords(self.chart, &mut coords);
+
+            let width = (content.x2 - content.x1 + 1) as i64;
+            let x_ofs = content.x1 - sys::lv_obj_get_scroll_left(self.chart);
+            let steps = (self.len as i64 - 1).max(1);
+            let x_of = |i: usize| x_ofs + (width * i as i64 / steps) as i32;
+
+            let area = sys::lv_area_t {
+                x1: x_of(first.saturating_sub(1)) - self.margin,
+                y1: coords.y1,
+                x2: x_of((last + 1).min(self.len - 1)) + self.margin,
+                y2: coords.y2,
+            };
+            sys::lv_obj_invalidate_area(self.chart, &area);
+        }
+    }
+}
+
+/// Columns collected before they are handed to the ring in one batch
+#[cfg(feature = "widget-chart")]
+const DECIMATE_BATCH: usize = 32;
+
+/// Min/max decimation of a high-rate signal onto a [`ChartRing`]
+///
+/// Every `samples_per_column` input samples are reduced to their minimum
+/// and maximum, which become two consecutive chart points, so a line chart
+/// draws the signal's envelope. Blocks of any size can be pushed; a column
+/// is only emitted, and the chart only invalidated, once it is complete. In
+/// [`ChartUpdateMode::Circular`] a column whose min/max equals the column
+/// it replaces is skipped without a redraw.
+///
+/// ```ignore
+/// // 160 columns on a 320-point ring, 1 ms per column at 48 kHz
+/// static mut ENVELOPE: [i32; 320] = [0; 320];
+/// let ring = chart.attach_ring(&series, unsafe { &mut ENVELOPE }, ChartUpdateMode::Circular)?;
+/// let mut scope = DecimatedSeries::new(ring, 48)?;
+/// scope.push_samples(&adc_block);
+/// ```
+#[cfg(feature = "widget-chart")]
+pub struct DecimatedSeries {
+    ring: ChartRing,
+    samples_per_column: u32,
+    /// Samples folded into the current column so far
+    pending: u32,
+    min: i32,
+    max: i32,
+}
+
+#[cfg(feature = "widget-chart")]
+impl DecimatedSeries {
+    /// Decimate onto `ring`, which needs an even length (two points per column)
+    pub fn new(ring: ChartRing, samples_per_column: u32) -> Result<Self> {
+        if samples_per_column == 0 || ring.len() % 2 != 0 || ring.next_index() % 2 != 0 {
+            return Err(LvglError::InvalidParameter);
+        }
+        Ok(Self {
+            ring,
+            samples_per_column,
+            pending: 0,
+            min: i32::MAX,
+            max: i32::MIN,
+        })
+    }
+
+    /// Reduce a block of samples, returning the number of columns completed
+    pub fn push_samples(&mut self, samples: &[i32]) -> usize {
+        let mut out = [0i32; 2 * DECIMATE_BATCH];
+        let mut filled = 0;
+        let mut columns = 0;
+        let mut rest = samples;
+
+        while !rest.is_empty() {
+            let take = rest.len().min((self.samples_per_column - self.pending) as usize);
+            let (min, max) = block_min_max(&rest[..take]);
+            self.min = self.min.min(min);
+            self.max = self.max.max(max);
+            self.pending += take as u32;
+            rest = &rest[take..];
+
+            if self.pending == self.samples_per_column {
+                let (min, max) = (self.min, self.max);
+                columns += 1;
+                self.pending = 0;
+                self.min = i32::MAX;
+                self.max = i32::MIN;
+
+                if self.ring.shows_column(filled, min, max) {
+                    // Unchanged envelope: write the columns before it and
+                    // step over this one
+                    if filled > 0 {
+                        self.ring.push_slice(&out[..filled]);
+                        filled = 0;
+                    }
+                    self.ring.advance(2);
+                    continue;
+                }
+                out[filled] = min;
+                out[filled + 1] = max;
+                filled += 2;
+
+                if filled == out.len() {
+                    self.ring.push_slice(&out);
+                    filled = 0;
+                }
+            }
+        }
+        if filled > 0 {
+            self.ring.push_slice(&out[..filled]);
+        }
+        columns
+    }
+
+    /// Change the decimation factor (drops the partial column)
+    pub fn set_samples_per_column(&mut self, samples_per_column: u32) {
+        self.samples_per_column = samples_per_column.max(1);
+        self.pending = 0;
+        self.min = i32::MAX;
+        self.max = i32::MIN;
+    }
+
+    /// Number of columns shown
+    pub fn columns(&self) -> usize {
+        self.ring.len() / 2
+    }
+
+    /// The underlying ring
+    pub fn ring(&mut self) -> &mut ChartRing {
+        &mut self.ring
+    }
+}
+
+/// Minimum and maximum of a non-empty block
+///
+/// Eight independent lanes, so LLVM turns the loop into SSE/AVX/NEON
+/// min/max on desktop targets.
+#[cfg(feature = "widget-chart")]
+#[cfg(any(target_arch = "x86_64", target_arch = "x86", target_arch = "aarch64"))]
+fn block_min_max(samples: &[i32]) -> (i32, i32) {
+    const LANES: usize = 8;
+    let mut lo = [i32::MAX; LANES];
+    let mut hi = [i32::MIN; LANES];
+    let chunks = samples.chunks_exact(LANES);
+    let tail = chunks.remainder();
+    for chunk in chunks {
+        for i in 0..LANES {
+            lo[i] = lo[i].min(chunk[i]);
+            hi[i] = hi[i].max(chunk[i]);
+        }
+    }
+    let mut min = lo.iter().fold(i32::MAX, |a, &b| a.min(b));
+    let mut max = hi.iter().fold(i32::MIN, |a, &b| a.max(b));
+    for &v in tail {
+        min = min.min(v);
+        max = max.max(v);
+    }
+    (min, max)
+}
+
+/// Minimum and maximum of a non-empty block (plain loop for MCUs)
+#[cfg(feature = "widget-chart")]
+#[cfg(not(any(target_arch = "x86_64", target_arch = "x86", target_arch = "aarch64")))]
+fn block_min_max(samples: &[i32]) -> (i32, i32) {
+    let mut min = i32::MAX;
+    let mut max = i32::MIN;
+    for &v in samples {
+        if v < min {
+            min = v;
+        }
+        if v > max {
+            max = v;
+        }
+    }
+    (min, max)
+}
+
 // ============================================================================
 // List
 // ============================================================================
 
 /// List widget (scrollable list of items)
+#[cfg(feature = "widget-list")]
 pub struct List {
     raw: *mut sys::lv_obj_t,
     _marker: PhantomData<*mut ()>,
 }
 
+#[cfg(feature = "widget-list")]
 impl List {
     /// Create a new list on the given parent
     pub fn create(parent: &impl LvglObj) -> Result<Self> {
@@ -1538,6 +2222,7 @@ impl List {
     }
 }
 
+#[cfg(feature = "widget-list")]
 impl LvglObj for List {
     fn raw(&self) -> *mut sys::lv_obj_t {
         self.raw
@@ -1549,11 +2234,13 @@ impl LvglObj for List {
 // ============================================================================
 
 /// Message box widget
+#[cfg(feature = "widget-msgbox")]
 pub struct Msgbox {
     raw: *mut sys::lv_obj_t,
     _marker: PhantomData<*mut ()>,
 }
 
+#[cfg(feature = "widget-msgbox")]
 impl Msgbox {
     /// Create a new message box on the given parent
     pub fn create(parent: &impl LvglObj) -> Result<Self> {
@@ -1628,6 +2315,7 @@ impl Msgbox {
     }
 }
 
+#[cfg(feature = "widget-msgbox")]
 impl LvglObj for Msgbox {
     fn raw(&self) -> *mut sys::lv_obj_t {
         self.raw
@@ -1639,11 +2327,13 @@ impl LvglObj for Msgbox {
 // ============================================================================
 
 /// Tabview widget (container with switchable tabs)
+#[cfg(feature = "widget-tabview")]
 pub struct Tabview {
     raw: *mut sys::lv_obj_t,
     _marker: PhantomData<*mut ()>,
 }
 
+#[cfg(feature = "widget-tabview")]
 impl Tabview {
     /// Create a new tabview on the given parent
     pub fn create(parent: &impl LvglObj) -> Result<Self> {
@@ -1714,6 +2404,7 @@ impl Tabview {
     }
 }
 
+#[cfg(feature = "widget-tabview")]
 impl LvglObj for Tabview {
     fn raw(&self) -> *mut sys::lv_obj_t {
         self.raw
@@ -1725,11 +2416,13 @@ impl LvglObj for Tabview {
 // ============================================================================
 
 /// Tileview widget (swipeable page grid)
+#[cfg(feature = "widget-tileview")]
 pub struct Tileview {
     raw: *mut sys::lv_obj_t,
     _marker: PhantomData<*mut ()>,
 }
 
+#[cfg(feature = "widget-tileview")]
 impl Tileview {
     /// Create a new tileview on the given parent
     pub fn create(parent: &impl LvglObj) -> Result<Self> {
@@ -1780,6 +2473,7 @@ impl Tileview {
     }
 }
 
+#[cfg(feature = "widget-tileview")]
 impl LvglObj for Tileview {
     fn raw(&self) -> *mut sys::lv_obj_t {
         self.raw
@@ -1791,11 +2485,13 @@ impl LvglObj for Tileview {
 // ============================================================================
 
 /// Calendar widget
+#[cfg(feature = "widget-calendar")]
 pub struct Calendar {
     raw: *mut sys::lv_obj_t,
     _marker: PhantomData<*mut ()>,
 }
 
+#[cfg(feature = "widget-calendar")]
 impl Calendar {
     /// Create a new calendar on the given parent
     pub fn create(parent: &impl LvglObj) -> Result<Self> {
@@ -1856,6 +2552,7 @@ impl Calendar {
     }
 }
 
+#[cfg(feature = "widget-calendar")]
 impl LvglObj for Calendar {
     fn raw(&self) -> *mut sys::lv_obj_t {
         self.raw
@@ -1867,11 +2564,13 @@ impl LvglObj for Calendar {
 // ============================================================================
 
 /// On-screen keyboard widget
+#[cfg(feature = "widget-keyboard")]
 pub struct Keyboard {
     raw: *mut sys::lv_obj_t,
     _marker: PhantomData<*mut ()>,
 }
 
+#[cfg(feature = "widget-keyboard")]
 impl Keyboard {
     /// Create a new keyboard on the given parent
     pub fn create(parent: &impl LvglObj) -> Result<Self> {
@@ -1914,6 +2613,7 @@ impl Keyboard {
     }
 }
 
+#[cfg(feature = "widget-keyboard")]
 impl LvglObj for Keyboard {
     fn raw(&self) -> *mut sys::lv_obj_t {
         self.raw
@@ -1921,6 +2621,7 @@ impl LvglObj for Keyboard {
 }
 
 /// Keyboard mode
+#[cfg(feature = "widget-keyboard")]
 #[derive(Clone, Copy, Debug)]
 #[repr(u8)]
 pub enum KeyboardMode {
@@ -1935,11 +2636,13 @@ pub enum KeyboardMode {
 // ============================================================================
 
 /// Menu widget (hierarchical navigation)
+#[cfg(feature = "widget-menu")]
 pub struct Menu {
     raw: *mut sys::lv_obj_t,
     _marker: PhantomData<*mut ()>,
 }
 
+#[cfg(feature = "widget-menu")]
 impl Menu {
     /// Create a new menu on the given parent
     pub fn create(parent: &impl LvglObj) -> Result<Self> {
@@ -2017,6 +2720,7 @@ impl Menu {
     }
 }
 
+#[cfg(feature = "widget-menu")]
 impl LvglObj for Menu {
     fn raw(&self) -> *mut sys::lv_obj_t {
         self.raw
@@ -2024,6 +2728,7 @@ impl LvglObj for Menu {
 }
 
 /// Menu header mode
+#[cfg(feature = "widget-menu")]
 #[derive(Clone, Copy, Debug)]
 #[repr(u8)]
 pub enum MenuModeHeader {
@@ -2033,6 +2738,7 @@ pub enum MenuModeHeader {
 }
 
 /// Menu root back button mode
+#[cfg(feature = "widget-menu")]
 #[derive(Clone, Copy, Debug)]
 #[repr(u8)]
 pub enum MenuModeRootBackButton {
@@ -2041,20 +2747,20 @@ pub enum MenuModeRootBackButton {
 }
 
 // ============================================================================
-// Canvas (requires LV_USE_CANVAS — disabled on ESP32 by default)
+// Canvas (`widget-canvas`, on with `simulator`: needs a large pixel buffer)
 // ============================================================================
 
 /// Canvas widget for pixel-level drawing
 ///
 /// Only available with the `simulator` feature (or when `LV_USE_CANVAS = 1`
 /// in your `lv_conf.h`). Requires a large pixel buffer.
-#[cfg(feature = "simulator")]
+#[cfg(feature = "widget-canvas")]
 pub struct Canvas {
     raw: *mut sys::lv_obj_t,
     _marker: PhantomData<*mut ()>,
 }
 
-#[cfg(feature = "simulator")]
+#[cfg(feature = "widget-canvas")]
 impl Canvas {
     /// Create a new canvas on the given parent
     pub fn create(parent: &impl LvglObj) -> Result<Self> {
@@ -2090,7 +2796,7 @@ impl Canvas {
     }
 }
 
-#[cfg(feature = "simulator")]
+#[cfg(feature = "widget-canvas")]
 impl LvglObj for Canvas {
     fn raw(&self) -> *mut sys::lv_obj_t {
         self.raw
@@ -2102,11 +2808,13 @@ impl LvglObj for Canvas {
 // ============================================================================
 
 /// Window widget (title bar + content area)
+#[cfg(feature = "widget-win")]
 pub struct Win {
     raw: *mut sys::lv_obj_t,
     _marker: PhantomData<*mut ()>,
 }
 
+#[cfg(feature = "widget-win")]
 impl Win {
     /// Create a new window on the given parent
     pub fn create(parent: &impl LvglObj) -> Result<Self> {
@@ -2146,6 +2854,7 @@ impl Win {
     }
 }
 
+#[cfg(feature = "widget-win")]
 impl LvglObj for Win {
     fn raw(&self) -> *mut sys::lv_obj_t {
         self.raw